@@ -3,6 +3,7 @@
 #define _XOPEN_SOURCE_EXTENDED 1 // Enables X/Open System Interfaces (XSI) extensions, for types like cchar_t.
 
 #include <wchar.h>    // For wide character functions (wcwidth, mbtowc, setcchar) and types (wchar_t, cchar_t).
+#include <wctype.h>   // For wide character classes (iswprint, iswalnum), used by the line editor.
 #include <ncurses.h>  // For the ncurses terminal handling library; should ideally be after wchar.h if dependent.
 #include <stdlib.h>   // For standard library functions like memory allocation (malloc, free), string conversion (atoi).
 #include <string.h>   // For string manipulation functions (strcpy, strlen, strcmp).
@@ -15,8 +16,23 @@
 #include <sys/wait.h> // For process waiting functions (WIFEXITED, WEXITSTATUS), used with pclose.
 #include <signal.h>   // For signal handling (SIGWINCH for resize, SIGINT/SIGTERM for exit).
 #include <unistd.h>   // For POSIX operating system API (execlp for executing programs, getopt for command-line options).
+#include <getopt.h>   // For getopt_long, used by the long-only command-line options.
 #include <stdbool.h>  // For the boolean type (bool) and its values (true, false).
 #include <locale.h>   // Required for setlocale, to enable non-ASCII (UTF-8) character support.
+#include <pthread.h>  // For POSIX threads, used to query several customer databases in parallel.
+#include <limits.h>   // For integer limits (INT_MAX).
+#include <stdint.h>   // For fixed-width integer types (uint64_t), used by the ASCII fast path.
+#include <errno.h>    // For errno, reported when a snapshot export fails.
+#include <stddef.h>   // For offsetof, used by the subcommands' field table.
+#include <math.h>     // For the trigonometry of distance searches (link with -lm).
+#include <fcntl.h>    // For open, used to read the per-thread I/O counters.
+#include <sys/stat.h> // For stat, used to tell whether two paths name the same database file.
+#include <sys/ioctl.h> // For ioctl(TIOCGWINSZ), used to read the terminal size after a resize.
+#include <poll.h>     // For poll, used by idle maintenance to notice keys the UI has not read yet.
+#if defined(__SSE2__)
+#include <emmintrin.h> // For SSE2 intrinsics, used to test 16 bytes at a time for non-ASCII text.
+#endif
+#include "gextux_snapshot.h" // For the columnar snapshot file format written by --export-snapshot.
 
 // --- Retro-Futuristic Look Character Definitions ---
 // These definitions require a UTF-8 capable terminal and the ncursesw library (wide character support).
@@ -52,15 +68,90 @@
 #define RF_LOADING_TEXT_STR        "[⢿ LOADING ⢿]" // Defines the text string displayed during loading operations.
 #define RF_LOADING_CLEAR_TEXT_STR  "             " // Defines a string of spaces to clear the loading text.
 #define RF_LOADING_TEXT_VISUAL_LEN 13             // Defines the visual character length of the loading text string.
+#define RF_BACKUP_TEXT_FMT         "[BACKUP %3d%%]" // Defines the status bar text shown while an online backup runs.
 // --- End Retro-Futuristic Look Definitions ---
 
 // --- Configuration & Constants ---
 #define DEFAULT_DB_NAME "gextux.db"         // Defines the default filename for the SQLite database.
+#define MAX_SHARDS 8                        // Defines the maximum number of customer databases that can be searched together.
+#define SHARD_LABEL_LEN 16                  // Defines the buffer size for a database's short label in list views.
+#define DB_POOL_SIZE 3                      // Defines how many databases switched away from stay open for a quick switch back.
+#define STATEMENT_CACHE_SIZE 16             // Defines how many prepared statements each open database keeps for reuse.
+#define BACKUP_STEP_PAGES 64                // Defines how many pages each sqlite3_backup_step copies (256 KB with 4 KB pages).
+#define BACKUP_STEP_SLEEP_MS 10             // Defines the pause between backup steps, leaving the database free for operator writes.
+#define BACKGROUND_POLL_MS 500              // Defines how often screens wake up to refresh background job progress.
+#define CHANGE_ROW_SQL_LEN 2048             // Defines the buffer size for the SQL expression serializing a clients row to JSON.
+#define DICTIONARY_COUNT 4                  // Defines how many client text fields are stored as keys into lookup tables.
+#define DICTIONARY_COMPLETION_LIMIT 50      // Defines how many lookup table values Tab cycles through for one prefix.
+#define TAIL_BATCH_ROWS 500                 // Defines how many change log rows --tail-changes reads per query.
+#define TAIL_POLL_MIN_MS 50                 // Defines the first wait when --tail-changes has caught up with the log.
+#define TAIL_POLL_MAX_MS 2000               // Defines the longest wait between polls of an idle change log.
+#define OPT_TAIL_CHANGES 1000               // Defines the getopt_long code of --tail-changes.
+#define OPT_COMPACT_CHANGES 1001            // Defines the getopt_long code of --compact-changes.
+#define OPT_EXPORT_SNAPSHOT 1002            // Defines the getopt_long code of --export-snapshot.
+#define OPT_PROFILE_OUTPUT 1003             // Defines the getopt_long code of --profile-output.
+#define OPT_MEMORY_BUDGET 1004              // Defines the getopt_long code of --memory-budget.
+#define OPT_FORMAT 1005                     // Defines the getopt_long code of --format.
+#define CLI_EXIT_NOT_FOUND 2                // Defines the exit status of a subcommand given an unknown customer ID.
+#define OPT_IMPORT_ZIPS 1006                // Defines the getopt_long code of --import-zips.
+#define OPT_STATUS 1007                     // Defines the getopt_long code of --status.
+#define RADIUS_SEARCH_PREFIX '@'            // Defines the first character of a radius search term ("@ZIP [km]").
+#define RADIUS_DEFAULT_KM 25.0              // Defines the radius used when a radius search gives none.
+#define RADIUS_MAX_KM 20000.0               // Defines the largest accepted search radius (half the earth's circumference).
+#define EARTH_RADIUS_KM 6371.0088           // Defines the mean earth radius used by distance_km().
+#define KM_PER_DEGREE_LAT 111.195           // Defines the length of one degree of latitude, for the bounding box.
+#define CREATED_SEARCH_PREFIX '+'           // Defines the first character of a search by date added ("+", "+DAYS" or "+FROM..TO").
+#define CREATED_PAGE_SIZE 200               // Defines how many rows each page of a date-added list holds.
+#define CREATED_MAX_DAYS 36500              // Defines the longest "added in the last N days" span accepted.
+#define CLIENT_STATUS_COUNT 5               // Defines the number of statuses allowed by the CHECK constraint on clients.status.
+#define BUSY_RETRY_FIRST_MS 2               // Defines the first wait before retrying a statement blocked by another connection's lock.
+#define BUSY_RETRY_MAX_MS 250               // Defines the longest single wait between retries of a blocked statement.
+#define BUSY_RETRY_LIMIT 60                 // Defines how many retries a blocked statement gets (about 10 s) before failing as busy.
+#define DB_UPDATE_CONFLICT -1               // Defines the result of db_update_client() when another user saved the customer first.
+#define CLI_UPDATE_ATTEMPTS 5               // Defines how often the update subcommand reapplies its fields after a conflict.
+#define OPT_FIND_DUPLICATES 1008            // Defines the getopt_long code of --find-duplicates.
+#define OPT_MERGE_DUPLICATES 1009           // Defines the getopt_long code of --merge-duplicates.
+#define DUP_KEY_LEN 64                      // Defines the buffer size of a normalized business name compared by duplicate detection.
+#define DUP_PHONE_DIGITS 9                  // Defines how many trailing phone digits form the phone blocking key (country prefixes vary).
+#define DUP_PHONE_MIN_DIGITS 7              // Defines the fewest phone digits that still make a phone blocking key.
+#define DUP_BLOCK_WINDOW 20                 // Defines how many following records of a block (in name order) each record is compared with.
+#define DUP_MATCH_SCORE 0.93                // Defines the similarity score from which two customers are taken for duplicates.
+#define DUP_CONTACT_BONUS 0.05              // Defines the score added for each of an identical email and an identical phone.
+#define DUP_NAME_MISMATCH_PENALTY 0.05      // Defines the score taken from names that still differ once normalized.
+#define DUP_MAX_THREADS 16                  // Defines the most worker threads scoring duplicate candidates.
+#define DUP_BLOCKS_PER_GRAB 64              // Defines how many blocks a scoring worker takes from the shared queue at a time.
+#define OPT_LIST_COLUMNS 1010               // Defines the getopt_long code of --list-columns.
+#define OPT_MAINTENANCE 1011                // Defines the getopt_long code of --maintenance.
+#define OPT_IDLE_MAINTENANCE 1012           // Defines the getopt_long code of --idle-maintenance.
+#define MAINTENANCE_IDLE_SECONDS 60         // Defines how long the editor waits without keys before maintaining the databases.
+#define MAINTENANCE_INTERVAL_SECONDS 3600   // Defines how long a completed maintenance run lasts before a database is due again.
+#define MAINTENANCE_ANALYSIS_LIMIT 1000     // Defines the rows of each index ANALYZE samples (PRAGMA analysis_limit).
+#define MAINTENANCE_RESTATS_PERCENT 10      // Defines by how much the customer count must change before statistics are gathered again.
+#define MAINTENANCE_VACUUM_STEP_PAGES 64    // Defines how many free pages each incremental_vacuum step returns to the file system.
+#define MAINTENANCE_CONVERT_FREE_PERCENT 10 // Defines the share of free pages from which a full VACUUM switches a database to incremental auto_vacuum.
+#define MAINTENANCE_CLOSE_MAX_MS 500        // Defines how long maintenance may delay the editor's exit.
+#define MAINTENANCE_PROGRESS_OPS 1000       // Defines how many virtual machine instructions run between checks for keys and the deadline.
+#define MAINTENANCE_LOG_ROWS 1000           // Defines how many runs maintenance_log keeps.
+#define RELATED_LIMIT 5                     // Defines how many related customers of each kind the detail pane lists.
+#define RELATED_CACHE_SIZE 32               // Defines how many customers' related customers stay cached.
+#define RELATED_POLL_MS 50                  // Defines how often the list view checks for related customers still being looked up.
+#define LIST_SPILL_WINDOW 512               // Defines how many rows of a spilled list are kept in memory at a time.
+#define LIST_SPILL_MIN_ITEMS (2 * LIST_SPILL_WINDOW) // Defines the smallest in-memory list size a memory budget can impose.
+#define THREAD_IO_STATS_PATH "/proc/thread-self/io" // Defines the per-thread I/O counters sampled around each refresh.
+#define PROFILER_OVERLAY_WIDTH 56           // Defines the width of the output profiler overlay.
+#define LIST_SELECT_SQL_LEN 192             // Defines the buffer size of the select list built for list queries.
 #define MAX_STR_LEN 256                     // Defines a general maximum length for string buffers.
-#define MAX_NOTES_LEN 101                   // Defines the maximum length for client notes (100 characters + null terminator).
+#define LIST_TEXT_CUT_MARK "\xE2\x80\xA6"     // Defines the ellipsis ending list text that was cut to fit MAX_STR_LEN.
+#define MAX_NOTES_LEN 16385                 // Defines the maximum length for client notes (16 KB + null terminator); notes are stored out of line.
+#define NOTES_MIGRATED_USER_VERSION 1       // Defines the PRAGMA user_version from which inline notes have been moved to client_notes.
+#define NOTES_BLOB_CHUNK 4096               // Defines the piece size used for incremental BLOB reads of notes.
 #define INPUT_WIN_HEIGHT 3                  // Defines the height (in lines) of the dedicated input window.
+#define MIN_MAIN_WIN_HEIGHT 3               // Defines the fewest lines the main window is laid out with; smaller terminals wait to be enlarged.
+#define RESIZE_SETTLE_MS 30                 // Defines how long SIGWINCH must stay quiet before the windows are laid out again.
+#define RESIZE_SETTLE_MAX_MS 250            // Defines the longest a burst of resizes delays the layout.
 #define PRINT_CMD "lp"                      // Defines the system command for printing (not used in this editor part).
 #define CANCEL_INPUT_STRING "!!CANCEL!!"    // Defines a special string input by the user to cancel an operation.
+#define QUERY_CACHE_MAX_BYTES (32 * 1024 * 1024) // Defines the memory bound for cached search results (32 MB).
 #define STATUS_BAR_TITLE " GexTuX Customer Management v1.0 - May 2025 " // Defines the title text for the status bar.
 
 // UI Constants
@@ -72,6 +163,11 @@
 #define DETAIL_LABEL_WIDTH 18       // Defines the fixed width for labels in the client detail view.
 #define DATETIME_FORMAT "%Y-%m-%d %H:%M:%S" // Defines the format string for displaying date and time.
 #define DATETIME_STR_LEN 19         // Defines the length of the string generated by DATETIME_FORMAT (excluding null).
+#define GAP_BUFFER_INITIAL_CAPACITY 64 // Defines how many characters the line editor allocates at first.
+#define INPUT_HISTORY_SIZE 64       // Defines how many entered lines are kept for recall with Up/Down.
+#define INPUT_HISTORY_PROMPT_LEN 64 // Defines the buffer size of the prompt a history entry belongs to.
+#define NOTES_PROMPT "Notes"        // Defines the prompt of the notes field, whose entries are never kept for recall.
+#define KEY_CTRL(c) ((c) & 0x1f)    // Defines the key code of Ctrl with a letter.
 
 // New Screen Layout Constants
 #define SCREEN_TITLE_Y (MAIN_WIN_BORDER_WIDTH - 1) // Defines the Y-coordinate (row) for screen titles within the main window.
@@ -84,6 +180,11 @@
 #define LIST_PANE_PERCENT 0.50      // Defines the percentage of available width the list pane should occupy.
 #define DETAIL_PANE_MIN_WIDTH 45    // Defines the minimum width (in characters) for the detail view pane.
 #define PANE_SEPARATOR_WIDTH 1      // Defines the width (in characters) of the visual separator between panes.
+#define LIST_SEEK_MAX_LEN 64        // Defines the maximum length of the type-to-seek prefix in list views.
+#define LIST_LETTER_INDEX_SIZE 27   // Defines the number of letter index buckets (A-Z plus one for other initials).
+#define LIST_NAME_MIN_WIDTH 20      // Defines the narrowest the Name column gets to make room for optional list columns.
+#define LIST_COLUMNS_ALL ((1u << LIST_COLUMN_COUNT) - 1) // Defines the mask of every optional list column.
+#define LIST_COLUMNS_DEFAULT ((1u << LIST_COLUMN_CITY) | (1u << LIST_COLUMN_PHONE)) // Defines the optional list columns shown without --list-columns.
 
 // Key Constants - mapping ncurses key codes or characters to symbolic names for actions.
 #define KEY_NAV_UP       KEY_UP        // Defines navigation key: Up arrow.
@@ -104,29 +205,64 @@
 #define KEY_EDIT_CLIENT_ALT 'E'        // Defines action key: Edit client (uppercase 'E').
 #define KEY_ACTION_DELETE  'd'         // Defines action key: Delete (lowercase 'd').
 #define KEY_ACTION_DELETE_ALT 'D'      // Defines action key: Delete (uppercase 'D').
+#define KEY_ACTION_SEEK  '/'           // Defines action key: Start type-to-seek in list views.
+#define KEY_ACTION_NOTES 'n'           // Defines action key: Read notes (lowercase 'n').
+#define KEY_ACTION_NOTES_ALT 'N'       // Defines action key: Read notes (uppercase 'N').
+#define KEY_ACTION_PROFILER KEY_F(12)  // Defines action key: Toggle the terminal output profiler overlay.
+#define KEY_ACTION_MEMORY 'm'          // Defines action key: Show memory usage (lowercase 'm').
+#define KEY_ACTION_MEMORY_ALT 'M'      // Defines action key: Show memory usage (uppercase 'M').
+#define KEY_ACTION_FILTER 'f'          // Defines action key: Cycle the status filter of lists (lowercase 'f').
+#define KEY_ACTION_FILTER_ALT 'F'      // Defines action key: Cycle the status filter of lists (uppercase 'F').
 #define KEY_ESC          27            // Defines the ASCII value for the Escape key.
 
 // --- Structures ---
-typedef struct { // Defines the structure for storing comprehensive client data.
+typedef struct { // Defines the cached terminal display width of a fetched string.
+    int bytes;                          // Length of the string in bytes.
+    int cols;                           // Display width of the string in terminal columns.
+    bool ascii;                         // True when the string is pure ASCII (columns == bytes).
+} TextWidth;
+
+typedef struct { // Defines one character of the line editor with its cached sizes.
+    wchar_t wc;                         // The character.
+    unsigned char width;                // Terminal columns it takes (unprintable ones take 1 and show as '?').
+    unsigned char bytes;                // Length of its UTF-8 encoding.
+} EditChar;
+
+typedef struct { // Defines the line editor's text: characters on both sides of a gap at the cursor, so typing moves nothing else.
+    EditChar *chars;                    // Text before the gap, the gap, then the text after it.
+    int capacity;                       // Allocated characters.
+    int gap_start;                      // Start of the gap, which is the cursor position.
+    int gap_end;                        // Index of the first character after the gap.
+    int bytes;                          // UTF-8 length of the whole text.
+} GapBuffer;
+
+typedef struct { // Defines a line entered at a prompt, recalled with Up/Down and completed with Tab at the same prompt.
+    char prompt[INPUT_HISTORY_PROMPT_LEN]; // Prompt the line was entered at.
+    char *text;                         // The line (malloc'd).
+} InputHistoryEntry;
+
+typedef enum { // Defines indices for the text fields of a client whose display widths are cached.
+    CF_BUSINESS_NAME, CF_EMAIL, CF_PHONE, CF_WEBSITE, CF_STREET, CF_CITY, CF_STATE, CF_ZIP_CODE, CF_COUNTRY,
+    CF_TAX_NUMBER, CF_INDUSTRY, CF_CONTACT_PERSON, CF_CONTACT_EMAIL, CF_CONTACT_PHONE, CF_STATUS, CF_CREATED_AT,
+    CLIENT_TEXT_FIELD_COUNT
+} ClientTextField;
+
+typedef struct { // Defines a client text field stored as the key of a value in a lookup table of its distinct values.
+    ClientTextField field;              // The field.
+    const char *column;                 // Its name in results and the change log; clients stores <column>_id.
+    const char *table;                  // The lookup table (id, name).
+} DictionaryColumn;
+
+typedef struct { // Defines a client record: one allocation holding the numeric fields, then the text fields back to back.
+    int refs;                           // Number of holders; a shared record is copied before it is changed.
     int id;                             // Unique identifier for the client (typically auto-incremented).
-    char business_name[MAX_STR_LEN];    // Name of the client's business.
-    char email[MAX_STR_LEN];            // Primary email address for the client's business.
-    char phone[MAX_STR_LEN];            // Primary phone number for the client's business.
-    char website[MAX_STR_LEN];          // Website URL for the client's business.
-    char street[MAX_STR_LEN];           // Street address of the client.
-    char city[MAX_STR_LEN];             // City of the client's address.
-    char state[MAX_STR_LEN];            // State or province of the client's address.
-    char zip_code[32];                  // Postal or ZIP code for the client's address.
-    char country[MAX_STR_LEN];          // Country of the client's address.
-    char tax_number[MAX_STR_LEN];       // Tax identification number for the client.
     int num_employees;                  // Number of employees in the client's business.
-    char industry[MAX_STR_LEN];         // Industry sector the client operates in.
-    char contact_person[MAX_STR_LEN];   // Name of the primary contact person at the client's business.
-    char contact_email[MAX_STR_LEN];    // Email address of the primary contact person.
-    char contact_phone[MAX_STR_LEN];    // Phone number of the primary contact person.
-    char status[MAX_STR_LEN];           // Current status of the client (e.g., "Active", "Prospect").
-    char notes[MAX_NOTES_LEN];          // Additional notes or comments about the client.
-    char created_at[MAX_STR_LEN];       // Timestamp of when the client record was created.
+    char *notes;                        // Out-of-line notes, loaded on demand (NULL when not loaded or unchanged); owned by the caller.
+    int notes_len;                      // Size in bytes of the stored notes (0 if none).
+    int row_version;                    // Incremented by every update; an update only applies to the version it was edited from.
+    int text_offsets[CLIENT_TEXT_FIELD_COUNT]; // Start of each NUL-terminated text field in text.
+    TextWidth text_widths[CLIENT_TEXT_FIELD_COUNT]; // Byte lengths and display widths of the text fields, computed when set.
+    char text[];                        // The text fields in ClientTextField order.
 } Client;
 
 typedef struct { // Defines a structure for storing summarized client data, used in list views.
@@ -136,25 +272,306 @@ typedef struct { // Defines a structure for storing summarized client data, used
     char phone[MAX_STR_LEN];            // Primary phone number for the client's business.
     char email[MAX_STR_LEN];            // Primary email address for the client's business.
     char contact_person[MAX_STR_LEN];   // Name of the primary contact person.
+    TextWidth business_name_tw;         // Cached display width of business_name.
+    TextWidth city_tw;                  // Cached display width of city.
+    TextWidth phone_tw;                 // Cached display width of phone.
+    TextWidth email_tw;                 // Cached display width of email.
+    TextWidth contact_person_tw;        // Cached display width of contact_person.
+    unsigned char null_fields;          // Bit i set when text field i (business_name to contact_person) was NULL and holds "N/A".
+    int shard;                          // Index of the database (shard) the row belongs to.
+    double sort_key;                    // Ordering value of lists not sorted by name (distance in km, or negated Unix time added); 0 otherwise.
 } ClientListItem;
 
+typedef struct { // Defines a list result: every row in memory, or once over budget, a window over a temporary table.
+    ClientListItem *items;              // All rows, or when spilled the window_count rows starting at index window_start.
+    int count;                          // Number of rows in the list.
+    int capacity;                       // Allocated capacity of items.
+    int window_start;                   // List index of items[0] (spilled lists only).
+    int window_count;                   // Number of valid rows in items (spilled lists only).
+    sqlite3 *spill_db;                  // Private connection holding the spill table; NULL while the list is in memory.
+    sqlite3_stmt *spill_insert;         // Insert statement used while the list is being filled.
+    bool spill_txn;                     // Whether the transaction batching the spill inserts is open.
+    char spill_table[48];               // Name of the spill table in the temp schema.
+    int *deleted;                       // Spill positions of rows removed from the list, ascending.
+    int deleted_count;                  // Number of entries in deleted.
+    int max_items;                      // Rows kept in memory before spilling; 0 means memory_budget.max_list_items.
+} ClientList;
+
 typedef struct { // Defines a structure to pass data to the SQLite callback for fetching list items.
-    ClientListItem **items_ptr;         // Pointer to a dynamic array of ClientListItem structures.
-    int *count_ptr;                     // Pointer to the current number of items in the array.
-    int *capacity_ptr;                  // Pointer to the current allocated capacity of the array.
+    ClientList *list;                   // List the rows are appended to.
+    int shard;                          // Index of the database (shard) the rows are fetched from.
 } FetchListData;
 
+typedef enum { // Defines the output formats of the command-line subcommands.
+    CLI_FORMAT_JSON,                    // One JSON object per customer and line.
+    CLI_FORMAT_TSV                      // A header line, then one tab-separated line per customer.
+} CliFormat;
+
+typedef struct { // Defines a client field as printed and set by the command-line subcommands.
+    const char *name;                   // Column name, used as JSON key, TSV header and in field=value arguments.
+    int text_field;                     // ClientTextField of a text field; -1 for integer fields.
+    size_t offset;                      // Offset of an integer field in Client.
+    bool writable;                      // Whether field=value may set it.
+} CliClientField;
+
+typedef struct { // Defines the memory budget given with --memory-budget and how it is divided.
+    sqlite3_int64 budget_bytes;         // Total budget; 0 means unlimited.
+    int max_list_items;                 // Rows a list keeps in memory before spilling to a temporary table.
+    size_t query_cache_max_bytes;       // Memory bound for cached search results.
+} MemoryBudget;
+
+typedef struct { // Defines a prepared statement kept for reuse; it is looked up by its SQL text (sqlite3_sql).
+    sqlite3_stmt *stmt;                 // The statement, reset between uses (NULL for a free slot).
+    bool in_use;                        // Handed out and not yet released.
+    unsigned last_used;                 // statement_cache_clock when last handed out, for replacing the least recently used.
+} CachedStatement;
+
+typedef struct { // Defines one open customer database; several can be searched together.
+    char path[MAX_STR_LEN];             // Path of the database file.
+    char label[SHARD_LABEL_LEN];        // Short name shown in the list's source column (file name without extension).
+    sqlite3 *conn;                      // Connection to the database.
+    CachedStatement statements[STATEMENT_CACHE_SIZE]; // Statements prepared on conn, kept while it stays open.
+    long long parked_ms;                // monotonic_ms() when it was switched away from (entries of db_pool only).
+    long long maintenance_due_ms;       // Idle maintenance schedule carried across switches (see MaintenanceJob.next_run_ms).
+} DbShard;
+
+typedef struct { // Defines the work and result of one per-shard search running on a worker thread.
+    int shard;                          // Index of the shard to search.
+    const char *sql_query;              // Query to run (shared, read-only).
+    ClientList list;                    // Rows fetched from this shard, in query order.
+    int rc;                             // SQLite result code of the query.
+    char err_msg[MAX_STR_LEN];          // Error message when rc is not SQLITE_OK.
+} ShardSearchJob;
+
+typedef enum { // Defines the optional list columns, shown after the Name column in this order when they fit.
+    LIST_COLUMN_CITY,
+    LIST_COLUMN_PHONE,
+    LIST_COLUMN_EMAIL,
+    LIST_COLUMN_CONTACT,
+    LIST_COLUMN_COUNT
+} ListColumn;
+
+typedef struct { // Defines an optional list column: where its value lives in ClientListItem and how it is shown.
+    const char *name;                   // Column name in results, also used by --list-columns.
+    const char *header;                 // Header text in the list pane.
+    int width;                          // Width of the column in the list pane.
+    size_t offset;                      // Offset of the value in ClientListItem.
+    size_t width_offset;                // Offset of the value's cached TextWidth in ClientListItem.
+} ListColumnSpec;
+
 typedef struct { // Defines a structure to hold calculated column widths for list displays.
     int id_width;                       // Calculated width for the ID column in a list.
     int name_width;                     // Calculated width for the Name (Business Name) column in a list.
     int name_col_start;                 // Calculated starting X-coordinate (column) for the Name column.
+    int source_width;                   // Calculated width for the Source (database) column; 0 with a single database.
+    int source_col_start;               // Calculated starting X-coordinate (column) for the Source column.
+    unsigned shown;                     // Optional columns (bits of ListColumn) that fit after the Name column.
+    int column_start[LIST_COLUMN_COUNT]; // Starting X-coordinate of each shown optional column.
 } ListColumnWidths;
 
+typedef struct QueryCacheEntry { // Defines a cached search result list, kept in most-recently-used order.
+    char *key;                          // Normalized search term combined with the list action.
+    ClientListItem *items;              // Copy of the result rows, in display order.
+    int count;                          // Number of rows in items.
+    size_t bytes;                       // Memory accounted to this entry (key plus rows).
+    struct QueryCacheEntry *next;       // Next (less recently used) entry.
+} QueryCacheEntry;
+
 typedef enum { // Defines an enumeration for possible actions originating from an interactive list selection.
     INTERACTIVE_LIST_ACTION_EDIT,       // Indicates that the selected item should be edited.
     INTERACTIVE_LIST_ACTION_DELETE      // Indicates that the selected item should be deleted.
 } InteractiveListAction;
 
+typedef enum { // Defines the order of a customer list; it decides how shard results merge and whether seek works.
+    LIST_ORDER_NAME,                    // By business name (NOCASE); supports type-to-seek and the letter index.
+    LIST_ORDER_DISTANCE,                // By distance from a zip code, nearest first (sort_key holds km).
+    LIST_ORDER_CREATED                  // By created_at, newest first, then by id (sort_key holds minus the Unix time).
+} ListOrder;
+
+typedef struct { // Defines a span of created_at values listed newest first, one page at a time.
+    char from[DATETIME_STR_LEN + 1];    // First created_at included ('YYYY-MM-DD HH:MM:SS' UTC), or "" for no lower bound.
+    char to[DATETIME_STR_LEN + 1];      // First created_at excluded, or "" for no upper bound.
+} CreatedRange;
+
+typedef struct { // Defines the keyset position a page of a date-added list starts after: the last row of the page before.
+    sqlite3_int64 created;              // Unix time of that row's created_at.
+    int id;                             // Its customer ID.
+    int shard;                          // Index of its database.
+} CreatedCursor;
+
+
+typedef struct { // Defines the state of an online backup running on a background thread.
+    pthread_t thread;                   // Worker thread running the sqlite3_backup steps.
+    pthread_mutex_t lock;               // Protects the progress and result fields below.
+    sqlite3 *src;                       // Source connection (the primary database); writes through it reach the backup directly.
+    char dest_path[MAX_STR_LEN];        // Destination file.
+    bool active;                        // True from start until the result has been collected.
+    bool finished;                      // Set by the worker when the backup is complete or failed.
+    int remaining;                      // Pages still to copy (sqlite3_backup_remaining).
+    int pagecount;                      // Total pages in the source (sqlite3_backup_pagecount).
+    int rc;                             // Final SQLite result code.
+    char err_msg[MAX_STR_LEN];          // Final error message when rc is not SQLITE_OK.
+} BackupJob;
+
+typedef struct { // Defines the maintenance worker that runs while the editor waits for keys.
+    pthread_t thread;                   // Worker thread, started with the editor.
+    pthread_mutex_t lock;               // Protects every field below.
+    pthread_cond_t wake;                // Signals the worker that it should stop.
+    bool started;                       // Whether the worker thread is running.
+    bool stop;                          // Asks the worker to exit; also interrupts a run in progress.
+    long long idle_ms;                  // Time without keys before a run starts (0 when idle maintenance is off).
+    long long last_input_ms;            // monotonic_ms() of the last key read.
+    long long next_run_ms[MAX_SHARDS];  // monotonic_ms() from which each database is due again (0 for at once).
+} MaintenanceJob;
+
+typedef struct { // Defines one maintenance run on one database and what it achieved, as logged in maintenance_log.
+    const char *trigger;                // "idle", "close" or "manual".
+    bool yield_on_input;                // Stop as soon as a key is pressed.
+    long long deadline_ms;              // monotonic_ms() at which the run stops (0 for none).
+    bool allow_convert;                 // May switch the database to incremental auto_vacuum with a full VACUUM.
+    long long started_ms;               // monotonic_ms() when the run started.
+    time_t started_at;                  // Wall clock time when the run started.
+    bool analyzed;                      // Whether statistics were gathered.
+    long long analyzed_rows;            // Customers counted when they were.
+    int pages_before;                   // Pages in the file before the run.
+    int pages_after;                    // Pages in the file after it.
+    int free_after;                     // Free pages left in the file.
+    long long bytes_reclaimed;          // Bytes returned to the file system by the vacuum step (never negative).
+    double duration_ms;                 // Time the run took.
+    bool interrupted;                   // Stopped early by a key, the deadline or the editor exiting.
+    bool converted;                     // Switched to incremental auto_vacuum.
+} MaintenanceRun;
+
+typedef enum { // Defines the screen regions terminal output is attributed to.
+    OUTPUT_REGION_MENU,
+    OUTPUT_REGION_LIST,
+    OUTPUT_REGION_DETAIL,
+    OUTPUT_REGION_PAGER,
+    OUTPUT_REGION_FORM,
+    OUTPUT_REGION_INPUT,
+    OUTPUT_REGION_STATUS,
+    OUTPUT_REGION_PROFILER,
+    OUTPUT_REGION_COUNT
+} OutputRegion;
+
+typedef struct { // Defines the terminal output counted for one screen region.
+    long long refreshes;                // Refreshes attributed to the region.
+    long long writes;                   // write() calls made by those refreshes.
+    long long bytes;                    // Bytes written by those refreshes.
+    long long frame_writes;             // write() calls in the frame being drawn.
+    long long frame_bytes;              // Bytes in the frame being drawn.
+    long long last_frame_writes;        // write() calls in the last completed frame.
+    long long last_frame_bytes;         // Bytes in the last completed frame.
+} OutputRegionStats;
+
+typedef struct { // Defines the state of terminal output accounting.
+    bool enabled;                       // True once counting has started.
+    bool overlay;                       // True while the overlay is shown.
+    int io_fd;                          // Open THREAD_IO_STATS_PATH of the UI thread, or -1.
+    char dump_path[MAX_STR_LEN];        // File the totals are written to at exit (empty for none).
+    long long frames;                   // Completed frames (main loop iterations).
+    long long max_frame_bytes;          // Largest frame so far.
+    OutputRegion main_region;           // Region that main_win refreshes are attributed to.
+    OutputRegionStats regions[OUTPUT_REGION_COUNT]; // Counters per region.
+} OutputProfile;
+
+typedef struct { // Defines a growable byte buffer used while building snapshot columns.
+    uint8_t *data;                      // Buffer contents.
+    size_t len;                         // Bytes in use.
+    size_t cap;                         // Bytes allocated.
+} SnapshotBuffer;
+
+typedef struct { // Defines a column being built for a snapshot export.
+    const char *name;                   // Column name in the snapshot.
+    const char *sql;                    // Expression selecting the column from clients.
+    uint32_t type;                      // One of the GXS_TYPE_* encodings.
+    SnapshotBuffer data;                // Per-row values, dictionary codes or string offsets.
+    SnapshotBuffer bytes;               // String bytes, or the dictionary entries' bytes.
+    SnapshotBuffer dict_offsets;        // Dictionary entry offsets into bytes (GXS_TYPE_DICT only).
+    uint32_t *dict_slots;               // Open-addressing hash table of dictionary codes + 1 (0 = empty).
+    uint32_t dict_slot_count;           // Number of hash slots (a power of two).
+    uint32_t dict_count;                // Number of dictionary entries.
+} SnapshotColumn;
+
+typedef struct { // Defines a customer as seen by duplicate detection: its normalized keys in a shared string arena.
+    int id;                             // Customer ID.
+    int filled;                         // Number of non-empty fields; the fullest customer of a cluster is kept.
+    uint32_t name;                      // Arena offset of the normalized business name.
+    uint32_t email;                     // Arena offset of the lowercased email (offset 0, the empty string, if none).
+    uint32_t phone;                     // Arena offset of the phone's trailing digits (empty if too few).
+} DupRecord;
+
+typedef struct { // Defines one blocking key of a customer; customers sharing a key form a block and are compared.
+    uint64_t hash;                      // FNV-1a hash of the key's kind and text.
+    uint32_t record;                    // Index of the customer in the records array (which is in business name order).
+} DupKey;
+
+typedef struct { // Defines two customers scored as duplicates.
+    uint32_t a, b;                      // Record indices.
+    float score;                        // Similarity, from DUP_MATCH_SCORE to 1.
+} DupPair;
+
+typedef struct { // Defines a customer in a duplicate cluster, sorted so that each cluster starts with the one to keep.
+    uint32_t root;                      // Union-find root identifying the cluster.
+    int filled;                         // Non-empty fields of the customer.
+    int id;                             // Customer ID.
+} DupMember;
+
+typedef struct { // Defines the work shared by the duplicate scoring thread pool.
+    const DupRecord *records;           // Customers being compared.
+    const char *arena;                  // Their normalized keys.
+    const DupKey *keys;                 // Keys sorted by hash, then record.
+    const uint32_t *blocks;             // Start and end index in keys of each block of two or more, two entries per block.
+    uint32_t block_count;               // Number of blocks.
+    uint32_t next_block;                // Next block to hand out; guarded by lock.
+    pthread_mutex_t lock;               // Protects next_block.
+} DupScoreJob;
+
+typedef struct { // Defines one worker of the duplicate scoring thread pool and the pairs it found.
+    DupScoreJob *job;                   // Shared work queue.
+    pthread_t thread;                   // Worker thread.
+    DupPair *pairs;                     // Pairs scoring at least DUP_MATCH_SCORE.
+    size_t count, cap;                  // Pairs found and allocated.
+    long long compared;                 // Pairs scored.
+    bool failed;                        // Whether the pairs array could not grow.
+} DupScoreWorker;
+
+typedef enum { // Defines the kinds of related customers shown below a customer's details.
+    RELATED_CITY_INDUSTRY,              // Same city and industry.
+    RELATED_EMAIL_DOMAIN,               // Same email domain.
+    RELATED_KIND_COUNT
+} RelatedKind;
+
+typedef struct { // Defines a lookup of related customers: the selected customer and the keys it is matched on.
+    int shard;                          // Database the customer belongs to.
+    int client_id;                      // Selected customer; 0 for none.
+    char city[MAX_STR_LEN];             // Its city.
+    char industry[MAX_STR_LEN];         // Its industry.
+    char domain[MAX_STR_LEN];           // Lowercased domain of its email; empty if the email has none.
+} RelatedRequest;
+
+typedef struct { // Defines the related customers found for one customer.
+    int shard;                          // Database the customer belongs to.
+    int client_id;                      // Customer the entry is for; 0 marks an unused cache slot.
+    int count[RELATED_KIND_COUNT];      // Related customers found of each kind, at most RELATED_LIMIT.
+    int ids[RELATED_KIND_COUNT][RELATED_LIMIT]; // Their IDs, in business name order.
+    char names[RELATED_KIND_COUNT][RELATED_LIMIT][MAX_STR_LEN]; // Their business names.
+} RelatedEntry;
+
+typedef struct { // Defines the background lookup of related customers and the cache of its results.
+    pthread_mutex_t lock;               // Protects every field below except conns, which only the worker uses.
+    pthread_cond_t wake;                // Signals the worker that a request is waiting or that it should stop.
+    pthread_t thread;                   // Worker thread, started by the first request.
+    bool started;                       // Whether the worker thread is running.
+    bool stop;                          // Asks the worker to exit.
+    bool pending;                       // Whether request waits for the worker.
+    RelatedRequest request;             // Latest lookup asked for; newer ones replace it.
+    RelatedRequest running;             // Lookup the worker is running (client_id 0 when idle).
+    unsigned generation;                // Incremented when the cache is cleared, so results of older lookups are dropped.
+    RelatedEntry cache[RELATED_CACHE_SIZE]; // Results, replaced round-robin.
+    int cache_next;                     // Slot the next result goes to.
+    sqlite3 *conns[MAX_SHARDS];         // The worker's read-only connections, opened on first use.
+} RelatedLookup;
 
 // --- Global Variables ---
 sqlite3 *db = NULL;                     // Global pointer to the SQLite database connection object. Initialized to NULL.
@@ -163,6 +580,61 @@ int max_y, max_x;                       // Global variables to store the termina
 volatile sig_atomic_t resize_pending = 0; // A volatile flag indicating if a SIGWINCH (resize) signal is pending.
 volatile sig_atomic_t exit_requested = 0; // A volatile flag indicating if a SIGINT or SIGTERM signal has been received.
 char db_path[MAX_STR_LEN];              // Global buffer to store the path to the SQLite database file.
+DbShard shards[MAX_SHARDS];             // Open customer databases; shards[0] is the primary one, where new customers are added.
+int shard_count = 0;                    // Number of entries in shards.
+DbShard db_pool[DB_POOL_SIZE];          // Databases switched away from, still open with their caches; the longest unused is closed first.
+int db_pool_count = 0;                  // Number of entries in db_pool.
+unsigned statement_cache_clock = 0;     // Counter ordering statement cache uses.
+BackupJob backup_job = { .lock = PTHREAD_MUTEX_INITIALIZER }; // The online backup, if one is running.
+MaintenanceJob maintenance_job = { .lock = PTHREAD_MUTEX_INITIALIZER, .wake = PTHREAD_COND_INITIALIZER }; // Idle maintenance, off until started.
+OutputProfile output_profile = { .io_fd = -1 }; // Terminal output accounting, off until requested.
+const char *output_region_names[OUTPUT_REGION_COUNT] = { "menu", "list", "detail pane", "notes pager", "form", "input bar", "status bar", "profiler" };
+RelatedLookup related_lookup = { .lock = PTHREAD_MUTEX_INITIALIZER, .wake = PTHREAD_COND_INITIALIZER }; // Related customers of the detail pane.
+QueryCacheEntry *query_cache_head = NULL; // Most recently used entry of the search result cache.
+size_t query_cache_bytes = 0;           // Total memory held by the search result cache.
+MemoryBudget memory_budget = { 0, INT_MAX, QUERY_CACHE_MAX_BYTES }; // Unlimited unless --memory-budget is given.
+size_t list_memory_bytes = 0;           // Memory held by the row arrays of live lists.
+unsigned list_spill_serial = 0;         // Counter making spill table names unique.
+pthread_mutex_t list_memory_lock = PTHREAD_MUTEX_INITIALIZER; // Protects the two above; shard search workers fill lists concurrently.
+const char *client_statuses[CLIENT_STATUS_COUNT] = { "Active", "Inactive", "Prospect", "Lead", "Former" }; // In the order F cycles through.
+const ListColumnSpec list_column_specs[LIST_COLUMN_COUNT] = { // In ListColumn order.
+    { "city", "City", 14, offsetof(ClientListItem, city), offsetof(ClientListItem, city_tw) },
+    { "phone", "Phone", 15, offsetof(ClientListItem, phone), offsetof(ClientListItem, phone_tw) },
+    { "email", "Email", 24, offsetof(ClientListItem, email), offsetof(ClientListItem, email_tw) },
+    { "contact_person", "Contact", 18, offsetof(ClientListItem, contact_person), offsetof(ClientListItem, contact_person_tw) },
+};
+const DictionaryColumn dictionary_columns[DICTIONARY_COUNT] = {
+    { CF_CITY, "city", "cities" },
+    { CF_STATE, "state", "states" },
+    { CF_COUNTRY, "country", "countries" },
+    { CF_INDUSTRY, "industry", "industries" },
+};
+InputHistoryEntry input_history[INPUT_HISTORY_SIZE]; // Lines entered at the prompts, oldest first.
+int input_history_count = 0; // Number of entries in input_history.
+unsigned list_columns = LIST_COLUMNS_DEFAULT; // Optional columns the list pane shows when there is room (--list-columns).
+int list_status_filter = -1;            // Index into client_statuses of the only status searches return, or -1 for all.
+const CliClientField cli_client_fields[] = { // Client fields in output order (notes follow separately).
+    { "id", -1, offsetof(Client, id), false },
+    { "business_name", CF_BUSINESS_NAME, 0, true },
+    { "email", CF_EMAIL, 0, true },
+    { "phone", CF_PHONE, 0, true },
+    { "website", CF_WEBSITE, 0, true },
+    { "street", CF_STREET, 0, true },
+    { "city", CF_CITY, 0, true },
+    { "state", CF_STATE, 0, true },
+    { "zip_code", CF_ZIP_CODE, 0, true },
+    { "country", CF_COUNTRY, 0, true },
+    { "tax_number", CF_TAX_NUMBER, 0, true },
+    { "num_employees", -1, offsetof(Client, num_employees), true },
+    { "industry", CF_INDUSTRY, 0, true },
+    { "contact_person", CF_CONTACT_PERSON, 0, true },
+    { "contact_email", CF_CONTACT_EMAIL, 0, true },
+    { "contact_phone", CF_CONTACT_PHONE, 0, true },
+    { "status", CF_STATUS, 0, true },
+    { "created_at", CF_CREATED_AT, 0, false },
+    { "row_version", -1, offsetof(Client, row_version), false }
+};
+sqlite3_int64 query_cache_data_versions[MAX_SHARDS]; // PRAGMA data_version of each shard when the cache was last validated.
 
 // --- Function Prototypes ---
 // Ncurses & Windowing related function declarations.
@@ -170,6 +642,7 @@ void init_ncurses();                    // Initializes the ncurses environment.
 void cleanup_ncurses();                 // Cleans up ncurses resources before program termination.
 void create_windows();                  // Creates the main application windows (main, input, status).
 void destroy_windows();                 // Destroys/deletes the ncurses windows.
+void layout_windows();                  // Resizes and moves the existing windows to fit the terminal (creates or drops them if needed).
 void handle_resize(int sig);            // Signal handler for SIGWINCH (terminal resize).
 void check_and_handle_resize();         // Checks the resize_pending flag and processes resize if needed.
 void handle_exit_signal(int sig);       // Signal handler for SIGINT/SIGTERM (exit signals).
@@ -181,35 +654,211 @@ void show_status(const char *fmt, ...); // Displays a formatted message on the s
 void show_error(const char *fmt, ...);  // Displays a formatted error message on the status bar.
 void update_status_bar_datetime();      // Updates the date and time display on the status bar.
 void show_loading_indicator(bool show); // Shows or hides a loading indicator on the status bar.
+void draw_backup_progress();            // Draws the progress of a running backup on the status bar.
+
+// Terminal output accounting function declarations.
+int enable_output_profiling();          // Starts counting terminal output; returns 0 if the kernel counters are unavailable.
+int read_thread_io(long long *bytes, long long *writes); // Reads the UI thread's cumulative write() bytes and calls.
+void account_output(OutputRegion region, long long bytes, long long writes); // Adds one refresh's output to a region.
+void refresh_window(WINDOW *win);       // Refreshes a window, attributing its output to a region when profiling.
+void refresh_window_area(WINDOW *win, int y, int x, int h, int w, OutputRegion region); // Refreshes part of a window on its own when profiling.
+void end_output_frame();                // Closes the current frame's counters and draws the overlay.
+void toggle_output_overlay();           // Shows or hides the output profiler overlay.
+void draw_output_overlay();             // Draws the per-region counters in a box at the top right.
+void dump_output_profile();             // Writes the totals to the --profile-output file.
+
+// Client record function declarations.
+Client *client_create(const char *const values[CLIENT_TEXT_FIELD_COUNT], const int lengths[CLIENT_TEXT_FIELD_COUNT]); // Allocates a record holding copies of the text fields (NULL values are empty, -1 lengths use strlen).
+Client *client_new();                   // Allocates an empty record for a new customer, with status 'Active'.
+Client *client_ref(Client *client);     // Adds a holder to a record and returns it.
+void client_free(Client *client);       // Drops a holder of a record, freeing it with the last one.
+const char *client_text(const Client *client, ClientTextField field); // Returns a text field of a record.
+int client_set_text(Client **client, ClientTextField field, const char *value); // Replaces a text field, reallocating the record; 0 when out of memory.
+Client *client_mutable(Client **client); // Copies a shared record before its numeric fields or notes change; NULL when out of memory.
 
 // Database related function declarations.
 int init_db(const char* db_filename);   // Initializes the database connection and schema.
 void close_db();                        // Closes the database connection.
 int db_execute(const char *sql, int (*callback)(void*,int,char**,char**), void *data); // Executes an SQL query.
+int add_db_shard(const char *path);     // Registers a database file to open at startup.
+int open_db_shards();                   // Opens and initializes every registered database.
+void select_db_shard(int shard);        // Makes a shard's connection the current one (global db).
+void set_db_shard_path(DbShard *shard, const char *path); // Clears a shard entry and sets its path and label.
+int fetch_list_items_from_shards(const char *sql_query, ClientList *list, ListOrder order); // Runs a list query on every shard in parallel and merges the results.
+int fetch_client_list(const char *sql_query, ListOrder order, ClientList *list); // Runs a list query on the current database, or on every shard; frees the list on failure.
+void *shard_search_worker(void *arg);   // Thread entry point running one shard's list query.
+
+// Change log function declarations.
+void build_client_change_row_sql(const char *ref, char *buf, size_t size); // Builds the SQL expression serializing a clients row to JSON.
+int init_change_log();                  // Creates the change log table and its triggers, seeding it on first use.
+int tail_client_changes(sqlite3_int64 from_seq); // Streams change log entries as JSONL and follows new ones; returns an exit status.
+int compact_client_changes(int retain_days); // Drops superseded changes and deletions older than retain_days; returns rows removed or -1.
+
+// Proximity search function declarations.
+int init_zip_locations();               // Creates the zip code table, the customer location R*Tree and the triggers keeping it current.
+void sql_distance_km(sqlite3_context *ctx, int argc, sqlite3_value **argv); // SQL function distance_km(lat1, lon1, lat2, lon2): great-circle distance.
+long long import_zip_file(sqlite3 *conn, FILE *fp, long long *skipped_out); // Loads zip,latitude,longitude lines into one database; returns rows loaded or -1.
+long long import_zip_locations(const char *path); // Loads a zip code CSV file into every open database; returns rows loaded or -1.
+
+// Snapshot export function declarations.
+int snapshot_buffer_append(SnapshotBuffer *buf, const void *data, size_t len); // Appends bytes to a snapshot buffer.
+int snapshot_dict_code(SnapshotColumn *col, const char *value, size_t len, uint32_t *code); // Finds or adds a dictionary entry.
+long long export_columnar_snapshot(const char *path); // Writes the clients table as a columnar snapshot; returns rows or -1.
+
+// Duplicate detection function declarations.
+size_t normalize_business_name(const char *name, char *out, size_t size); // Folds case and drops punctuation and legal forms.
+double jaro_winkler(const char *a, const char *b); // Jaro-Winkler similarity of two strings, from 0 to 1.
+double score_duplicate_pair(const DupRecord *a, const DupRecord *b, const char *arena); // Scores how likely two customers are one.
+void *duplicate_score_worker(void *arg); // Thread pool worker scoring the pairs within blocks taken from a shared queue.
+uint64_t dup_key_hash(char kind, const char *text); // FNV-1a hash of a blocking key and its kind.
+int compare_dup_keys(const void *a, const void *b); // qsort comparator ordering blocking keys by hash, then record.
+int compare_dup_members(const void *a, const void *b); // qsort comparator ordering cluster members, the one to keep first.
+uint32_t dup_find_root(uint32_t *parent, uint32_t i); // Finds a record's union-find root, halving the path.
+long long find_duplicate_clusters(const char *path); // Writes clusters of likely duplicates to a review file; returns clusters or -1.
+int db_merge_clients(const int *ids, int count); // Merges customers into the first of them in one transaction.
+long long merge_duplicate_clusters(const char *path); // Merges the clusters of a review file; returns customers merged away, or -1 if any cluster failed.
+
+// Online backup function declarations.
+int start_background_backup(const char *dest_path); // Starts backing up the primary database on a background thread.
+void *backup_worker(void *arg);         // Thread entry point copying the database in small sqlite3_backup_step batches.
+int get_backup_progress(int *percent);  // Reports whether a backup is active and its completion percentage.
+void poll_background_backup();          // Reports a finished backup on the status bar and releases its thread.
+int wait_for_background_backup();       // Blocks until a running backup is done; returns its result code.
+int run_headless_backup(const char *dest_path); // Runs a backup without the UI, printing progress to stderr.
+
+// Idle maintenance function declarations.
+long long monotonic_ms();               // Milliseconds on a clock that only moves forward.
+int read_key(WINDOW *win);              // Reads a key like wgetch, noting that the user is active.
+void note_user_input();                 // Records a key press, postponing and interrupting maintenance.
+int init_maintenance_log();             // Creates the table maintenance runs are logged to.
+int maintenance_progress(void *arg);    // Progress handler; nonzero interrupts the run on a key, at the deadline or at exit.
+int maintenance_query(sqlite3 *conn, const char *sql, long long *value); // Runs a query, storing the first column of its row in *value; returns the result code.
+int run_maintenance(sqlite3 *conn, MaintenanceRun *run); // Gathers statistics, optimizes and returns free pages, then logs the run; 0 on errors.
+void *maintenance_worker(void *arg);    // Thread entry point maintaining each due database once the user is idle.
+void start_idle_maintenance(int idle_seconds); // Starts the worker (nothing for 0 seconds).
+void stop_idle_maintenance();           // Stops the worker, interrupting a run in progress.
+void run_close_maintenance();           // Gives databases not maintained this session a short run before they close.
+int run_headless_maintenance();         // Maintains every database at once, printing a summary to stderr.
 static int check_column_exists(const char *table_name, const char *column_name); // Checks if a column exists in a table (static linkage).
-int fetch_client_by_id(int id, Client *client); // Fetches a single client's full details by ID.
+int init_dictionaries();                // Creates the lookup tables of dictionary_columns, moving an older table's text values into them.
+const char *dictionary_table_for(const char *column); // Returns the lookup table a clients column is stored in, or NULL.
+const char *client_field_dictionary(ClientTextField field); // Returns the lookup table a text field is stored in, or NULL.
+int db_intern_dictionary_values(const Client *client); // Adds the client's values of dictionary fields missing from their lookup tables.
+int fetch_client_by_id(int id, Client **client); // Fetches a single client's full details by ID into a new record.
 int db_insert_client(const Client *client_data); // Inserts a new client record into the database.
-int db_update_client(const Client *client_data); // Updates an existing client record in the database.
+int db_update_client(const Client *client_data); // Updates a client record unless it changed since fetched (DB_UPDATE_CONFLICT).
+void bind_client_fields(sqlite3_stmt *stmt, const Client *client); // Binds the stored fields to parameters 1-16 of an insert or update.
+int db_busy_backoff(void *unused, int retries); // Waits a jittered, growing time before SQLite retries a locked database.
+int db_begin_write();                   // Starts a write transaction, taking the write lock up front.
 int db_delete_client(int client_id);    // Deletes a client record from the database by ID.
+int db_open_client_notes_blob(int client_id, sqlite3_blob **blob, int *size); // Opens a client's notes for incremental reading.
+char *db_read_client_notes(int client_id); // Reads a client's full notes into a malloc'd string (NULL on error).
+int db_write_client_notes(sqlite3_int64 client_id, const char *notes); // Stores a client's notes in one statement, so the change log records them.
+const char *get_client_notes_preview(int client_id, int max_bytes); // Returns (and caches) the first bytes of a client's notes.
+
+// Connection pool function declarations.
+sqlite3_stmt *statement_cache_get(sqlite3 *conn, const char *sql); // Returns a cached statement for sql on an open database, preparing it on first use; NULL on errors.
+void statement_cache_release(sqlite3_stmt *stmt); // Resets a statement from statement_cache_get for its next use (finalizes uncached ones).
+void close_db_shard(DbShard *shard);    // Finalizes a shard's cached statements and closes its connection.
+bool same_db_file(const char *a, const char *b); // Whether two paths name the same file (or are equal, when either is missing).
+void db_pool_park(DbShard *shard);      // Keeps a shard's connection open in db_pool, closing the longest unused one when full.
+bool db_pool_take(const char *path, DbShard *shard); // Moves a pooled connection to path into shard; false if none.
+int switch_db_shards(const char *paths); // Makes the comma-separated databases the open ones, keeping the others pooled; reports errors itself.
+
+// Query result cache function declarations.
+void query_cache_clear();               // Drops every cached search result.
+void query_cache_validate();            // Clears the cache if another connection changed the database (PRAGMA data_version).
+const QueryCacheEntry *query_cache_lookup(const char *key); // Returns a cached result list and marks it most recently used.
+void query_cache_store(const char *key, const ClientListItem *items, int count); // Caches a copy of a result list, evicting old entries to stay in budget.
+char *build_search_cache_key(const char *search_term, InteractiveListAction action, unsigned columns); // Builds the normalized cache key for a search (sqlite3_free to release).
+
+// Related customers function declarations.
+void related_request_for_client(int shard, const Client *client, RelatedRequest *request); // Fills in the keys a customer's related customers are matched on.
+int get_related_customers(int shard, const Client *client, RelatedEntry *entry); // Copies cached related customers, or queues their lookup and returns 0.
+void related_cache_clear();             // Drops every cached result and discards lookups in flight.
+void run_related_lookup(const RelatedRequest *request, RelatedEntry *entry); // Runs the index lookups of one request; a failed kind gets count -1.
+void *related_lookup_worker(void *arg); // Thread entry point running queued related customer lookups.
+void stop_related_lookup();             // Stops the worker and closes its connections.
 
 // Input Helper function declarations.
+int gap_buffer_length(const GapBuffer *gb); // Number of characters in a gap buffer.
+EditChar *gap_buffer_at(GapBuffer *gb, int index); // Character at a text position, skipping the gap.
+void gap_buffer_move(GapBuffer *gb, int position); // Moves the gap (the cursor) to a text position.
+int gap_buffer_insert(GapBuffer *gb, wchar_t wc, int max_bytes); // Inserts a character at the cursor; 0 if it does not fit or memory runs out.
+void gap_buffer_delete(GapBuffer *gb, int from, int to); // Removes the characters from one position up to another.
+void gap_buffer_set_text(GapBuffer *gb, const char *text, int max_bytes); // Replaces the text with a UTF-8 string, cursor at the end.
+void gap_buffer_to_utf8(GapBuffer *gb, char *out, int from, int to); // Writes a range of the text as UTF-8 (out must hold its bytes + 1).
+int gap_buffer_word_boundary(GapBuffer *gb, int from, int direction); // Finds the start of the next (1) or previous (-1) word.
+void draw_line_editor(WINDOW *win, int y, int x, int width, GapBuffer *gb, int *view_start, wchar_t *shown); // Draws the visible part of the text, writing only cells that changed.
+void input_history_add(const char *prompt, const char *text); // Remembers a line entered at a prompt, dropping the oldest when full.
+void input_history_clear();             // Frees the remembered lines.
 int get_string_input(WINDOW *win, int y, int x, const char *prompt, char *buffer, int max_len, bool allow_empty, const char *current_value_display); // Gets string input from the user.
+int get_dictionary_string_input(WINDOW *win, int y, int x, const char *prompt, char *buffer, int max_len, bool allow_empty, const char *current_value_display, const char *dictionary); // Gets string input, also completing from a lookup table (NULL for none).
+int get_allocated_string_input(WINDOW *win, int y, int x, const char *prompt, int max_bytes, bool allow_empty, const char *current_value_display, const char *dictionary, char **text); // Gets string input of up to max_bytes into a new string (*text, freed by the caller); returns as get_string_input.
+int collect_input_completions(const char *prefix, const char *const *recall, int recall_count, const char *dictionary, char ***completions); // Collects the recalled and looked-up values starting with prefix; returns how many (-1 when out of memory).
 int get_int_input(WINDOW *win, int y, int x, const char *prompt, int *value, int current_value); // Gets integer input from the user.
 int select_client_status(char *selected_status, const char *current_status); // Allows user to select a client status from a list.
+int get_client_text_input(const char *prompt, Client **client, ClientTextField field, bool allow_empty, const char *current); // Reads a text field in a form; returns as get_string_input.
 
 // Core Screens & UI Logic function declarations.
 void display_editor_main_menu();        // Displays the main menu of the customer editor.
 void add_new_customer_screen();         // Displays the screen/form for adding a new customer.
+void backup_database_screen();          // Asks for a destination file and starts an online backup.
+void switch_database_screen();          // Lists the open and pooled databases and switches to the ones entered.
 void customer_search_workflow(const char *screen_title, const char *search_prompt_detail, InteractiveListAction action); // Manages the customer search and subsequent action.
+char *build_customer_search_sql(const char *search_term, unsigned columns, ListOrder *order, CreatedRange *range); // Builds the list query for a search term: an ID, part of name, contact, email or city, "@ZIP [km]" or a date added (sqlite3_free to release).
+char *build_status_filter_sql(const char *column); // Builds " AND column = 'status'" for the status filter, or "" without one (sqlite3_free to release).
+char *build_radius_search_sql(const char *search_term, unsigned columns); // Builds the distance-ranked list query for "@ZIP [km]"; reports errors itself.
+int parse_created_search_term(const char *search_term, CreatedRange *range); // Parses "+", "+DAYS" or "+FROM..TO" into a created_at range; reports errors itself.
+int created_stamp(const char *time_value, const char *modifier, char out[DATETIME_STR_LEN + 1]); // Computes datetime(time_value, modifier) as stored in created_at; 0 if invalid.
+char *build_created_range_sql(const CreatedRange *range, const CreatedCursor *cursor, int limit, unsigned columns); // Builds the newest-first query of a created_at range, optionally after a cursor and limited.
+int fetch_created_page(const CreatedRange *range, const CreatedCursor *cursor, unsigned columns, ClientList *list, bool *more); // Loads one page of a created_at range; sets *more if another follows.
 void edit_customer_form_screen(int client_id); // Displays the screen/form for editing an existing customer.
+int merge_client_edits(const Client *base, const char *base_notes, Client **mine, const Client *theirs, const char *their_notes); // Merges another user's saved changes into an edit.
+void show_client_notes_pager(int client_id, const char *business_name); // Pages through a client's notes, reading them in pieces.
 
 // New Interactive List with Detail Pane function declarations.
-void display_interactive_client_list(const char *title, const char *sql_query, InteractiveListAction action_type); // Displays a list of clients with a detail pane.
-void calculate_list_column_widths_for_pane(ListColumnWidths *widths, int pane_content_width); // Calculates column widths for the list pane.
+bool display_interactive_client_list(const char *title, const char *sql_query, const char *cache_key, InteractiveListAction action_type, ListOrder order, unsigned columns, const CreatedRange *pages); // Displays a list of clients with a detail pane; pages a created_at range instead of sql_query if given. Returns true if the status filter changed.
+void calculate_list_pane_widths(int main_win_width, int *list_pane_w, int *detail_pane_w); // Splits the main window's width between the list and detail panes.
+void calculate_list_column_widths_for_pane(ListColumnWidths *widths, int pane_content_width, unsigned columns); // Calculates column widths for the list pane, fitting in what it can of the optional columns.
+unsigned visible_list_columns();        // Returns the optional columns the list pane has room for at the current window size.
+void build_list_columns_sql(unsigned columns, const char *prefix, char *buf, size_t size); // Builds the select list of a list query, with '' for columns not shown.
+int parse_list_columns(const char *spec, unsigned *columns); // Parses a comma-separated --list-columns value ("none" for none).
 void draw_list_header_in_pane(WINDOW *win, const ListColumnWidths *col_widths, int pane_start_y, int pane_start_x, int pane_content_width); // Draws the header for the list pane.
 void draw_list_item_in_pane(WINDOW *win, int y_on_screen, const ClientListItem *item, const ListColumnWidths *col_widths, bool highlighted, int pane_start_x, int pane_content_width); // Draws a single item in the list pane.
-void draw_client_details_in_pane(WINDOW *win, const Client *client, int pane_start_y, int pane_start_x, int pane_content_width); // Draws client details in the detail pane.
+void draw_client_details_in_pane(WINDOW *win, const Client *client, const RelatedEntry *related, int pane_start_y, int pane_start_x, int pane_content_width); // Draws client details (and related customers, NULL while loading) in the detail pane.
 void wclr_pane_line(WINDOW *win, int y, int x, int width); // Clears a line segment within a pane.
+TextWidth measure_text_width(const char *text); // Measures the byte length and terminal display width of a UTF-8 string.
+int text_prefix_bytes_for_cols(const char *text, const TextWidth *tw, int max_cols, int *cols_used); // Finds the longest prefix that fits in max_cols columns.
+void draw_text_cols(WINDOW *win, const char *text, const TextWidth *tw, int max_cols, bool pad); // Prints text truncated (and optionally padded) to max_cols columns.
+int wrap_text_line(const char *text, int text_len, int max_width, int *print_bytes); // Measures one wrapped line of text; returns the bytes consumed.
+int find_first_list_item_with_prefix(ClientList *list, const char *prefix); // Finds the first item >= prefix in a name-sorted list.
+void build_list_letter_index(ClientList *list, int *letter_index); // Computes the first offset of each initial in a name-sorted list.
+
+// Bounded list memory function declarations.
+void copy_list_text(char dest[MAX_STR_LEN], const char *src); // Copies text into a list item field, cutting it at a character boundary with LIST_TEXT_CUT_MARK.
+void fill_client_list_item(ClientListItem *item, int id, const char *const fields[5], int shard); // Fills a list item from id, name, city, phone, email and contact.
+int client_list_max_items(const ClientList *list); // Returns how many rows a list may keep in memory before it spills.
+void list_memory_add(ptrdiff_t items); // Adjusts list_memory_bytes by a number of row slots, under list_memory_lock.
+int client_list_grow(ClientList *list, int min_capacity); // Grows the in-memory row array, keeping list_memory_bytes up to date.
+int client_list_spill(ClientList *list); // Moves a list's rows into a temporary table once it reaches the budget.
+int client_list_append(ClientList *list, const ClientListItem *item); // Adds a row, in memory or to the spill table.
+int client_list_finish(ClientList *list); // Completes a fetched list (indexes and commits the spill table).
+ClientListItem *client_list_item(ClientList *list, int index); // Returns a row; for spilled lists valid until the next call.
+int client_list_spill_pos(const ClientList *list, int index); // Maps a list index to its spill table position, skipping removed rows.
+void client_list_set_name(ClientList *list, int index, const char *name, TextWidth name_tw); // Updates a row's business name after an edit.
+void client_list_remove(ClientList *list, int index); // Removes a row from the list.
+void client_list_free(ClientList *list); // Releases a list's rows and drops its spill table.
+void apply_memory_budget(long megabytes); // Divides a memory budget between SQLite, lists and the query cache.
+void show_memory_usage();               // Shows SQLite heap, page cache and list memory on the status bar.
+
+// Command-line subcommand function declarations.
+void cli_print_text(const char *text, CliFormat format); // Prints a value as a JSON string or an escaped TSV field.
+void cli_print_client(const Client *client, const char *notes, CliFormat format, bool header); // Prints a full customer record.
+void cli_print_list_item(const ClientListItem *item, CliFormat format, bool header, ListOrder order); // Prints a search result row.
+int cli_set_client_field(Client **client, const char *assignment, char **notes); // Applies a field=value argument; 0 on error.
+int cli_print_client_by_id(int client_id, CliFormat format); // Fetches and prints a customer; returns an exit status.
+int run_cli_command(int argc, char **argv, CliFormat format); // Runs the get/search/add/update/delete/merge subcommands; returns an exit status.
 
 
 // Other utility function declarations.
@@ -241,6 +890,141 @@ void handle_exit_signal(int sig) {
     exit_requested = 1;
 }
 
+// --- Terminal Output Accounting ---
+// ncurses writes straight to the terminal's file descriptor, so output is measured by sampling the UI thread's
+// kernel I/O counters around each refresh; nothing else writes from that thread while a refresh runs.
+int enable_output_profiling() {
+    if (output_profile.io_fd < 0) output_profile.io_fd = open(THREAD_IO_STATS_PATH, O_RDONLY | O_CLOEXEC);
+    output_profile.enabled = output_profile.io_fd >= 0;
+    return output_profile.enabled;
+}
+
+int read_thread_io(long long *bytes, long long *writes) {
+    char buf[512];
+    ssize_t n = pread(output_profile.io_fd, buf, sizeof(buf) - 1, 0);
+    if (n <= 0) return 0;
+    buf[n] = '\0';
+    char *wchar = strstr(buf, "wchar:"), *syscw = strstr(buf, "syscw:");
+    if (!wchar || !syscw) return 0;
+    *bytes = strtoll(wchar + 6, NULL, 10);
+    *writes = strtoll(syscw + 6, NULL, 10);
+    return 1;
+}
+
+void account_output(OutputRegion region, long long bytes, long long writes) {
+    OutputRegionStats *stats = &output_profile.regions[region];
+    stats->refreshes++;
+    stats->bytes += bytes;
+    stats->writes += writes;
+    stats->frame_bytes += bytes;
+    stats->frame_writes += writes;
+}
+
+void refresh_window(WINDOW *win) {
+    long long bytes_before, writes_before, bytes_after, writes_after;
+    if (!output_profile.enabled || !read_thread_io(&bytes_before, &writes_before)) {
+        wrefresh(win);
+        return;
+    }
+    wrefresh(win);
+    if (!read_thread_io(&bytes_after, &writes_after)) return;
+
+    OutputRegion region = win == status_win ? OUTPUT_REGION_STATUS
+                        : win == input_win ? OUTPUT_REGION_INPUT
+                        : win == main_win ? output_profile.main_region : OUTPUT_REGION_PROFILER;
+    account_output(region, bytes_after - bytes_before, writes_after - writes_before);
+}
+
+// Only used while profiling: the area goes out first, so the refresh of the whole window that follows finds
+// it already on screen and the two costs can be told apart.
+void refresh_window_area(WINDOW *win, int y, int x, int h, int w, OutputRegion region) {
+    long long bytes_before, writes_before, bytes_after, writes_after;
+    if (!output_profile.enabled || h <= 0 || w <= 0) return;
+    WINDOW *area = derwin(win, h, w, y, x);
+    if (!area) return;
+    touchwin(area);
+    wnoutrefresh(area);
+    delwin(area);
+    if (!read_thread_io(&bytes_before, &writes_before)) { doupdate(); return; }
+    doupdate();
+    if (read_thread_io(&bytes_after, &writes_after)) account_output(region, bytes_after - bytes_before, writes_after - writes_before);
+}
+
+void end_output_frame() {
+    if (!output_profile.enabled) return;
+    long long frame_bytes = 0;
+    for (int i = 0; i < OUTPUT_REGION_COUNT; ++i) {
+        OutputRegionStats *stats = &output_profile.regions[i];
+        stats->last_frame_bytes = stats->frame_bytes;
+        stats->last_frame_writes = stats->frame_writes;
+        frame_bytes += stats->frame_bytes;
+        stats->frame_bytes = stats->frame_writes = 0;
+    }
+    output_profile.frames++;
+    if (frame_bytes > output_profile.max_frame_bytes) output_profile.max_frame_bytes = frame_bytes;
+    if (output_profile.overlay) draw_output_overlay(); // Counted in the next frame, under "profiler".
+}
+
+void toggle_output_overlay() {
+    if (!output_profile.enabled && !enable_output_profiling()) {
+        show_error("Output profiling needs %s (Linux).", THREAD_IO_STATS_PATH); napms(1000);
+        return;
+    }
+    output_profile.overlay = !output_profile.overlay;
+    show_status("Output profiler %s.", output_profile.overlay ? "shown (counts start now)" : "hidden");
+}
+
+void draw_output_overlay() {
+    int h = OUTPUT_REGION_COUNT + 5;
+    if (max_x < PROFILER_OVERLAY_WIDTH + 4 || max_y < h + 2) return;
+    WINDOW *overlay = newwin(h, PROFILER_OVERLAY_WIDTH, 1, max_x - PROFILER_OVERLAY_WIDTH - 2);
+    if (!overlay) return;
+    wbkgd(overlay, has_colors() ? COLOR_PAIR(COLOR_PAIR_HIGHLIGHT) : A_REVERSE);
+    draw_custom_box(overlay);
+    mvwprintw(overlay, 0, 2, " Terminal output (F12 hides) ");
+    mvwprintw(overlay, 1, 1, "%-12s %9s %6s %10s %9s", "region", "last B", "last W", "total B", "B/frame");
+
+    long long frames = output_profile.frames > 0 ? output_profile.frames : 1;
+    long long last_bytes = 0, last_writes = 0, total_bytes = 0;
+    for (int i = 0; i < OUTPUT_REGION_COUNT; ++i) {
+        OutputRegionStats *stats = &output_profile.regions[i];
+        mvwprintw(overlay, 2 + i, 1, "%-12s %9lld %6lld %10lld %9lld", output_region_names[i],
+                  stats->last_frame_bytes, stats->last_frame_writes, stats->bytes, stats->bytes / frames);
+        last_bytes += stats->last_frame_bytes;
+        last_writes += stats->last_frame_writes;
+        total_bytes += stats->bytes;
+    }
+    mvwprintw(overlay, 2 + OUTPUT_REGION_COUNT, 1, "%-12s %9lld %6lld %10lld %9lld", "frame", last_bytes, last_writes,
+              total_bytes, total_bytes / frames);
+    mvwprintw(overlay, 3 + OUTPUT_REGION_COUNT, 1, "frames %lld, largest %lld B", output_profile.frames, output_profile.max_frame_bytes);
+    refresh_window(overlay);
+    delwin(overlay);
+}
+
+void dump_output_profile() {
+    if (!output_profile.enabled || !output_profile.dump_path[0]) return;
+    FILE *out = fopen(output_profile.dump_path, "w");
+    if (!out) {
+        fprintf(stderr, "Cannot write output profile '%s': %s\n", output_profile.dump_path, strerror(errno));
+        return;
+    }
+    long long frames = output_profile.frames > 0 ? output_profile.frames : 1;
+    long long total_bytes = 0, total_writes = 0, total_refreshes = 0;
+    fprintf(out, "# GexTuX terminal output profile: %lld frames, largest frame %lld bytes\n", output_profile.frames, output_profile.max_frame_bytes);
+    fprintf(out, "%-12s %10s %10s %12s %12s %13s\n", "region", "refreshes", "writes", "bytes", "bytes/frame", "writes/frame");
+    for (int i = 0; i < OUTPUT_REGION_COUNT; ++i) {
+        OutputRegionStats *stats = &output_profile.regions[i];
+        fprintf(out, "%-12s %10lld %10lld %12lld %12.1f %13.2f\n", output_region_names[i], stats->refreshes, stats->writes,
+                stats->bytes, (double)stats->bytes / frames, (double)stats->writes / frames);
+        total_refreshes += stats->refreshes;
+        total_writes += stats->writes;
+        total_bytes += stats->bytes;
+    }
+    fprintf(out, "%-12s %10lld %10lld %12lld %12.1f %13.2f\n", "total", total_refreshes, total_writes, total_bytes,
+            (double)total_bytes / frames, (double)total_writes / frames);
+    fclose(out);
+}
+
 // --- Ncurses Initialization and Cleanup ---
 void draw_custom_box(WINDOW *win) {
     cchar_t ls, rs, ts, bs, tl, tr, bl, br;
@@ -257,18 +1041,21 @@ void draw_custom_box(WINDOW *win) {
     wborder_set(win, &ls, &rs, &ts, &bs, &tl, &tr, &bl, &br);
 }
 
+// Dragging a terminal edge sends a burst of SIGWINCH; the windows are laid out once it pauses (or every
+// RESIZE_SETTLE_MAX_MS while it goes on), in place, so screens keep their state and window settings.
 void check_and_handle_resize() {
-    if (resize_pending) {
+    if (!resize_pending) return;
+    int waited = 0;
+    do {
         resize_pending = 0;
-        endwin();
-        refresh();
-        clear();
-        getmaxyx(stdscr, max_y, max_x);
-        destroy_windows();
-        create_windows();
-        clear();
-        refresh();
-    }
+        napms(RESIZE_SETTLE_MS);
+        waited += RESIZE_SETTLE_MS;
+    } while (resize_pending && waited < RESIZE_SETTLE_MAX_MS);
+
+    struct winsize ws;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_row > 0 && ws.ws_col > 0) resize_term(ws.ws_row, ws.ws_col);
+    getmaxyx(stdscr, max_y, max_x);
+    layout_windows();
 }
 
 void init_ncurses() {
@@ -342,9 +1129,9 @@ void create_windows() {
     }
     clear_status();
 
-    wrefresh(main_win);
-    wrefresh(input_win);
-    wrefresh(status_win);
+    refresh_window(main_win);
+    refresh_window(input_win);
+    refresh_window(status_win);
 }
 
 void destroy_windows() {
@@ -353,6 +1140,41 @@ void destroy_windows() {
     if(status_win) { delwin(status_win); status_win = NULL; }
 }
 
+void layout_windows() {
+    int main_h = max_y - INPUT_WIN_HEIGHT - 1;
+    // Terminals reflow or scroll their contents while resizing, so the next refresh repaints the whole screen once.
+    clearok(curscr, TRUE);
+    if (main_h < MIN_MAIN_WIN_HEIGHT) {
+        destroy_windows();
+        return;
+    }
+    if (!main_win || !input_win || !status_win) {
+        destroy_windows();
+        create_windows();
+        return;
+    }
+    // Each window is resized before it moves, so it always fits the screen when mvwin checks it.
+    int old_time_x = getmaxx(status_win) - (RF_STATUS_TIME_LEFT_VISUAL_LEN + DATETIME_STR_LEN + RF_STATUS_TIME_RIGHT_VISUAL_LEN) - 1;
+    wresize(main_win, main_h, max_x);
+    mvwin(main_win, 0, 0);
+    wresize(input_win, INPUT_WIN_HEIGHT, max_x);
+    mvwin(input_win, main_h, 0);
+    wresize(status_win, 1, max_x);
+    mvwin(status_win, max_y - 1, 0);
+
+    // The screens redraw the main and input windows; the status bar keeps its message and moves its clock.
+    werase(main_win); draw_custom_box(main_win);
+    werase(input_win); draw_custom_box(input_win);
+    if (old_time_x > 0 && old_time_x < max_x) {
+        int y, x;
+        getyx(status_win, y, x);
+        wmove(status_win, 0, old_time_x);
+        wclrtoeol(status_win);
+        wmove(status_win, y, x);
+    }
+    update_status_bar_datetime();
+}
+
 // --- Status Bar ---
 void update_status_bar_datetime() {
     if (!status_win) return;
@@ -377,11 +1199,28 @@ void update_status_bar_datetime() {
     else wattron(status_win, A_BOLD);
 
     mvwprintw(status_win, 0, time_x, "%s%s%s", RF_STATUS_TIME_LEFT_STR, time_buf, RF_STATUS_TIME_RIGHT_STR);
+    draw_backup_progress();
 
     wattr_set(status_win, current_attrs, current_pair, NULL);
     wmove(status_win, current_y, current_x_ignored);
 }
 
+// Uses the loading indicator's slot; the caller saves and restores the cursor and attributes.
+void draw_backup_progress() {
+    int percent;
+    if (!status_win || !get_backup_progress(&percent)) return;
+
+    int title_text_visual_len = strlen(STATUS_BAR_TITLE);
+    int full_banner_visual_len = RF_STATUS_TITLE_LEFT_VISUAL_LEN + title_text_visual_len + RF_STATUS_TITLE_RIGHT_VISUAL_LEN;
+    int wrapped_time_visual_len = RF_STATUS_TIME_LEFT_VISUAL_LEN + DATETIME_STR_LEN + RF_STATUS_TIME_RIGHT_VISUAL_LEN;
+    int indicator_x = max_x - wrapped_time_visual_len - RF_LOADING_TEXT_VISUAL_LEN - 2;
+    if (indicator_x <= 1 + full_banner_visual_len + 2) return;
+
+    if (has_colors()) wattron(status_win, COLOR_PAIR(COLOR_PAIR_LOADING) | A_BOLD);
+    else wattron(status_win, A_REVERSE | A_BOLD);
+    mvwprintw(status_win, 0, indicator_x, RF_BACKUP_TEXT_FMT, percent);
+}
+
 void clear_status() {
     if (!status_win) return;
     werase(status_win);
@@ -400,7 +1239,7 @@ void clear_status() {
 
     wmove(status_win, 0, 1 + full_banner_visual_len + 2);
     update_status_bar_datetime();
-    wrefresh(status_win);
+    refresh_window(status_win);
 }
 
 void show_status(const char *fmt, ...) {
@@ -423,13 +1262,19 @@ void show_status(const char *fmt, ...) {
     }
 
     update_status_bar_datetime();
-    wrefresh(status_win);
+    refresh_window(status_win);
     va_end(args);
 }
 
 void show_error(const char *fmt, ...) {
-    if (!status_win) return;
     va_list args; va_start(args, fmt);
+    if (!status_win) { // Headless modes (subcommands, backups, change tailing) report errors on stderr.
+        fputs("Error: ", stderr);
+        vfprintf(stderr, fmt, args);
+        fputc('\n', stderr);
+        va_end(args);
+        return;
+    }
 
     int title_text_visual_len = strlen(STATUS_BAR_TITLE);
     int full_banner_visual_len = RF_STATUS_TITLE_LEFT_VISUAL_LEN + title_text_visual_len + RF_STATUS_TITLE_RIGHT_VISUAL_LEN;
@@ -458,13 +1303,13 @@ void show_error(const char *fmt, ...) {
     }
 
     update_status_bar_datetime();
-    wrefresh(status_win);
+    refresh_window(status_win);
     beep();
 
     if (input_win) {
         mvwprintw(input_win, INPUT_PROMPT_Y, INPUT_PROMPT_X, "Error. Press any key...");
-        draw_custom_box(input_win); wrefresh(input_win); wgetch(input_win);
-        werase(input_win); draw_custom_box(input_win); wrefresh(input_win);
+        draw_custom_box(input_win); refresh_window(input_win); read_key(input_win);
+        werase(input_win); draw_custom_box(input_win); refresh_window(input_win);
     } else {
         napms(2000);
     }
@@ -501,7 +1346,82 @@ void show_loading_indicator(bool show_ind) {
          wprintw(status_win, "%s", RF_LOADING_CLEAR_TEXT_STR);
      }
      update_status_bar_datetime();
-     wrefresh(status_win);
+     refresh_window(status_win);
+}
+
+// --- Client Records ---
+// A record is a single allocation: the numeric fields, then every text field as it was read from SQLite, NUL-terminated
+// and back to back. Records are shared by reference; changing a field of a shared one copies it first.
+Client *client_create(const char *const values[CLIENT_TEXT_FIELD_COUNT], const int lengths[CLIENT_TEXT_FIELD_COUNT]) {
+    int field_lengths[CLIENT_TEXT_FIELD_COUNT];
+    size_t text_size = 0;
+    for (int i = 0; i < CLIENT_TEXT_FIELD_COUNT; ++i) {
+        field_lengths[i] = !values[i] ? 0 : lengths && lengths[i] >= 0 ? lengths[i] : (int)strlen(values[i]);
+        text_size += field_lengths[i] + 1;
+    }
+    Client *client = calloc(1, sizeof(Client) + text_size);
+    if (!client) return NULL;
+    client->refs = 1;
+    int offset = 0;
+    for (int i = 0; i < CLIENT_TEXT_FIELD_COUNT; ++i) {
+        client->text_offsets[i] = offset;
+        if (field_lengths[i] > 0) memcpy(client->text + offset, values[i], field_lengths[i]);
+        client->text_widths[i] = measure_text_width(client->text + offset);
+        offset += field_lengths[i] + 1;
+    }
+    return client;
+}
+
+Client *client_new() {
+    const char *values[CLIENT_TEXT_FIELD_COUNT] = { [CF_STATUS] = "Active" };
+    return client_create(values, NULL);
+}
+
+Client *client_ref(Client *client) {
+    if (client) client->refs++;
+    return client;
+}
+
+void client_free(Client *client) {
+    if (client && --client->refs == 0) free(client);
+}
+
+const char *client_text(const Client *client, ClientTextField field) {
+    return client->text + client->text_offsets[field];
+}
+
+int client_set_text(Client **client, ClientTextField field, const char *value) {
+    const Client *old = *client;
+    if (strcmp(client_text(old, field), value) == 0) return 1;
+    const char *values[CLIENT_TEXT_FIELD_COUNT];
+    int lengths[CLIENT_TEXT_FIELD_COUNT];
+    for (int i = 0; i < CLIENT_TEXT_FIELD_COUNT; ++i) {
+        values[i] = i == (int)field ? value : client_text(old, i);
+        lengths[i] = i == (int)field ? -1 : old->text_widths[i].bytes;
+    }
+    Client *updated = client_create(values, lengths);
+    if (!updated) return 0;
+    updated->id = old->id;
+    updated->num_employees = old->num_employees;
+    updated->notes = old->notes;
+    updated->notes_len = old->notes_len;
+    updated->row_version = old->row_version;
+    client_free(*client);
+    *client = updated;
+    return 1;
+}
+
+Client *client_mutable(Client **client) {
+    Client *shared = *client;
+    if (shared->refs == 1) return shared;
+    const char *last = client_text(shared, CLIENT_TEXT_FIELD_COUNT - 1);
+    size_t size = (size_t)(last - (const char*)shared) + shared->text_widths[CLIENT_TEXT_FIELD_COUNT - 1].bytes + 1;
+    Client *copy = malloc(size);
+    if (!copy) return NULL;
+    memcpy(copy, shared, size);
+    copy->refs = 1;
+    shared->refs--;
+    return *client = copy;
 }
 
 // --- Database Interaction ---
@@ -509,7 +1429,7 @@ static int check_column_exists(const char *table_name, const char *column_name)
     if (!db) return -1;
     char *sql = sqlite3_mprintf("PRAGMA table_info(%q);", table_name);
     if (!sql) {
-        if(status_win) show_error("Memory allocation failed checking column existence.");
+        show_error("Memory allocation failed checking column existence.");
         return -1;
     }
 
@@ -517,7 +1437,7 @@ static int check_column_exists(const char *table_name, const char *column_name)
     int column_found = 0;
     if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK) {
         if (sqlite3_errcode(db) != SQLITE_ERROR || strstr(sqlite3_errmsg(db), "no such table") == NULL) {
-             if(status_win) show_error("DB error checking column: %s", sqlite3_errmsg(db));
+             show_error("DB error checking column: %s", sqlite3_errmsg(db));
         }
         sqlite3_free(sql);
         return 0;
@@ -535,6 +1455,87 @@ static int check_column_exists(const char *table_name, const char *column_name)
     return column_found;
 }
 
+// City, state, country and industry take a few hundred distinct values between them, so clients stores the integer
+// key of each value in a lookup table. Names are unique regardless of case, and values are trimmed before they are
+// looked up, so spelling variants that differ only in those end up as one entry.
+int init_dictionaries() {
+    char sql[4096];
+    size_t used = 0;
+    for (int i = 0; i < DICTIONARY_COUNT; ++i) {
+        used += snprintf(sql + used, sizeof(sql) - used,
+                         "CREATE TABLE IF NOT EXISTS \"%s\" (\"id\" INTEGER PRIMARY KEY, \"name\" TEXT NOT NULL UNIQUE COLLATE NOCASE);",
+                         dictionary_columns[i].table);
+    }
+    if (!db_execute(sql, NULL, NULL)) return 0;
+    int old_layout = check_column_exists("clients", dictionary_columns[0].column);
+    if (old_layout <= 0) return old_layout == 0;
+
+    // A table from before the lookup tables: move its values over in one transaction. The most frequent spelling of
+    // each value becomes its name. Dropping a column fails while an index or trigger uses it; the callers of this
+    // recreate them for the new columns.
+    used = snprintf(sql, sizeof(sql),
+                    "BEGIN IMMEDIATE;"
+                    "DROP INDEX IF EXISTS \"idx_clients_city_industry\";"
+                    "DROP TRIGGER IF EXISTS \"clients_log_insert\";"
+                    "DROP TRIGGER IF EXISTS \"clients_log_update\";"
+                    "DROP TRIGGER IF EXISTS \"client_notes_log_insert\";"
+                    "DROP TRIGGER IF EXISTS \"client_notes_log_update\";"
+                    "DROP TRIGGER IF EXISTS \"client_notes_log_delete\";");
+    for (int i = 0; i < DICTIONARY_COUNT; ++i) {
+        const char *column = dictionary_columns[i].column, *table = dictionary_columns[i].table;
+        used += snprintf(sql + used, sizeof(sql) - used,
+                         "INSERT OR IGNORE INTO \"%s\" (name) SELECT trim(%s) FROM clients WHERE trim(%s) <> '' "
+                         "GROUP BY trim(%s) ORDER BY count(*) DESC;"
+                         "ALTER TABLE clients ADD COLUMN \"%s_id\" INTEGER REFERENCES \"%s\" (\"id\");",
+                         table, column, column, column, column, table);
+    }
+    used += snprintf(sql + used, sizeof(sql) - used, "UPDATE clients SET ");
+    for (int i = 0; i < DICTIONARY_COUNT; ++i) {
+        const char *column = dictionary_columns[i].column;
+        used += snprintf(sql + used, sizeof(sql) - used, "%s_id = (SELECT id FROM \"%s\" WHERE name = trim(clients.%s))%s",
+                         column, dictionary_columns[i].table, column, i + 1 < DICTIONARY_COUNT ? ", " : ";");
+    }
+    for (int i = 0; i < DICTIONARY_COUNT; ++i) {
+        used += snprintf(sql + used, sizeof(sql) - used, "ALTER TABLE clients DROP COLUMN \"%s\";", dictionary_columns[i].column);
+    }
+    snprintf(sql + used, sizeof(sql) - used, "COMMIT;");
+    if (!db_execute(sql, NULL, NULL)) {
+        db_execute("ROLLBACK;", NULL, NULL);
+        return 0;
+    }
+    return 1;
+}
+
+const char *dictionary_table_for(const char *column) {
+    for (int i = 0; i < DICTIONARY_COUNT; ++i) {
+        if (strcmp(dictionary_columns[i].column, column) == 0) return dictionary_columns[i].table;
+    }
+    return NULL;
+}
+
+const char *client_field_dictionary(ClientTextField field) {
+    for (int i = 0; i < DICTIONARY_COUNT; ++i) {
+        if (dictionary_columns[i].field == field) return dictionary_columns[i].table;
+    }
+    return NULL;
+}
+
+int db_intern_dictionary_values(const Client *c) {
+    for (int i = 0; i < DICTIONARY_COUNT; ++i) {
+        const char *value = client_text(c, dictionary_columns[i].field);
+        if (!value[0]) continue;
+        char sql[128];
+        snprintf(sql, sizeof(sql), "INSERT OR IGNORE INTO \"%s\" (name) SELECT trim(?1) WHERE trim(?1) <> '';", dictionary_columns[i].table);
+        sqlite3_stmt *stmt;
+        if (!(stmt = statement_cache_get(db, sql))) return 0;
+        sqlite3_bind_text(stmt, 1, value, c->text_widths[dictionary_columns[i].field].bytes, SQLITE_STATIC);
+        int rc = sqlite3_step(stmt);
+        statement_cache_release(stmt);
+        if (rc != SQLITE_DONE) return 0;
+    }
+    return 1;
+}
+
 int init_db(const char* db_filename) {
     int rc = sqlite3_open(db_filename, &db);
     if (rc) {
@@ -545,6 +1546,16 @@ int init_db(const char* db_filename) {
         db = NULL;
         return 0;
     }
+    sqlite3_busy_handler(db, db_busy_backoff, NULL);
+    // New files start in incremental mode, so maintenance hands free pages back in small steps instead of a full VACUUM.
+    // Files without auto_vacuum keep the setting until maintenance rebuilds them; a file already in FULL mode is left as is.
+    long long pages = 0, auto_vacuum = 0;
+    int mode_rc = maintenance_query(db, "PRAGMA page_count;", &pages);
+    if (mode_rc == SQLITE_OK) mode_rc = maintenance_query(db, "PRAGMA auto_vacuum;", &auto_vacuum);
+    if ((mode_rc != SQLITE_OK || pages == 0 || auto_vacuum == 0) && !db_execute("PRAGMA auto_vacuum = INCREMENTAL;", NULL, NULL)) {
+        if (db) { sqlite3_close(db); db = NULL; }
+        return 0;
+    }
 
     const char *sql_create_table =
         "CREATE TABLE IF NOT EXISTS \"clients\" ("
@@ -554,13 +1565,13 @@ int init_db(const char* db_filename) {
         "\"phone\"	TEXT,"
         "\"website\"	TEXT,"
         "\"street\"	TEXT,"
-        "\"city\"	TEXT,"
-        "\"state\"	TEXT,"
+        "\"city_id\"	INTEGER REFERENCES \"cities\" (\"id\"),"
+        "\"state_id\"	INTEGER REFERENCES \"states\" (\"id\"),"
         "\"zip_code\"	TEXT,"
-        "\"country\"	TEXT,"
+        "\"country_id\"	INTEGER REFERENCES \"countries\" (\"id\"),"
         "\"tax_number\"	TEXT,"
         "\"num_employees\"	INTEGER DEFAULT 0,"
-        "\"industry\"	TEXT,"
+        "\"industry_id\"	INTEGER REFERENCES \"industries\" (\"id\"),"
         "\"contact_person\"	TEXT,"
         "\"contact_email\"	TEXT,"
         "\"contact_phone\"	TEXT,"
@@ -585,25 +1596,137 @@ int init_db(const char* db_filename) {
             // Non-fatal
         }
     }
+    if (!check_column_exists("clients", "row_version")) {
+        if (!db_execute("ALTER TABLE clients ADD COLUMN row_version INTEGER NOT NULL DEFAULT 1;", NULL, NULL)) {
+            // Non-fatal
+        }
+    }
+    if (!init_dictionaries()) {
+        if (db) { sqlite3_close(db); db = NULL; }
+        return 0;
+    }
+
+    // Notes live out of line, keyed by client id, so detail fetches never carry them and they can be read in pieces.
+    const char *sql_create_notes =
+        "CREATE TABLE IF NOT EXISTS \"client_notes\" ("
+        "\"client_id\"	INTEGER PRIMARY KEY,"
+        "\"body\"	BLOB NOT NULL"
+        ");"
+        "CREATE TRIGGER IF NOT EXISTS \"clients_delete_notes\" AFTER DELETE ON \"clients\" "
+        "BEGIN DELETE FROM \"client_notes\" WHERE \"client_id\" = OLD.\"id\"; END;";
+    if (!db_execute(sql_create_notes, NULL, NULL)) {
+        if (db) { sqlite3_close(db); db = NULL; }
+        return 0;
+    }
+    // Both statements scan the whole table, so they run once; the version is set in the same transaction.
+    sqlite3_stmt *version_stmt;
+    int user_version = 0;
+    if (sqlite3_prepare_v2(db, "PRAGMA user_version;", -1, &version_stmt, NULL) == SQLITE_OK) {
+        if (sqlite3_step(version_stmt) == SQLITE_ROW) user_version = sqlite3_column_int(version_stmt, 0);
+        sqlite3_finalize(version_stmt);
+    }
+    if (user_version < NOTES_MIGRATED_USER_VERSION) {
+        char *sql_migrate_notes = sqlite3_mprintf("BEGIN IMMEDIATE;"
+                    "INSERT OR IGNORE INTO client_notes (client_id, body) "
+                    "SELECT id, CAST(notes AS BLOB) FROM clients WHERE notes IS NOT NULL AND notes <> '';"
+                    "UPDATE clients SET notes = NULL WHERE notes IS NOT NULL;"
+                    "PRAGMA user_version = %d;"
+                    "COMMIT;", NOTES_MIGRATED_USER_VERSION);
+        if (!sql_migrate_notes || !db_execute(sql_migrate_notes, NULL, NULL)) {
+            db_execute("ROLLBACK;", NULL, NULL); // Non-fatal: inline notes stay where they are until the next start.
+        }
+        sqlite3_free(sql_migrate_notes);
+    }
+    if (!init_change_log() || !init_zip_locations() || !init_maintenance_log()) {
+        if (db) { sqlite3_close(db); db = NULL; }
+        return 0;
+    }
+    // Date-added lists walk this index newest first (the rowid breaks ties), so they neither scan nor sort the table.
+    if (!db_execute("CREATE INDEX IF NOT EXISTS \"idx_clients_created_at\" ON \"clients\" (\"created_at\");", NULL, NULL)) {
+        if (db) { sqlite3_close(db); db = NULL; }
+        return 0;
+    }
+    // Lists filtered to one of the statuses operators work with read their rows in name order from a partial index
+    // holding only those rows, instead of walking every customer (most of them former ones) through the name index.
+    const char *sql_create_status_indexes =
+        "CREATE INDEX IF NOT EXISTS \"idx_clients_active_name\" ON \"clients\" (\"business_name\") WHERE \"status\" = 'Active';"
+        "CREATE INDEX IF NOT EXISTS \"idx_clients_prospect_name\" ON \"clients\" (\"business_name\") WHERE \"status\" = 'Prospect';"
+        "CREATE INDEX IF NOT EXISTS \"idx_clients_lead_name\" ON \"clients\" (\"business_name\") WHERE \"status\" = 'Lead';";
+    if (!db_execute(sql_create_status_indexes, NULL, NULL)) {
+        if (db) { sqlite3_close(db); db = NULL; }
+        return 0;
+    }
+    // The related customers of the detail pane are the first few entries of these for the selected customer's keys.
+    const char *sql_create_related_indexes =
+        "CREATE INDEX IF NOT EXISTS \"idx_clients_city_industry\" ON \"clients\" (\"city_id\", \"industry_id\", \"business_name\");"
+        "CREATE INDEX IF NOT EXISTS \"idx_clients_email_domain\" ON \"clients\" "
+        "(lower(substr(\"email\", instr(\"email\", '@') + 1)), \"business_name\") WHERE instr(\"email\", '@') > 0;";
+    if (!db_execute(sql_create_related_indexes, NULL, NULL)) {
+        if (db) { sqlite3_close(db); db = NULL; }
+        return 0;
+    }
+    sqlite3_create_function(db, "distance_km", 4, SQLITE_UTF8 | SQLITE_DETERMINISTIC, NULL, sql_distance_km, NULL, NULL);
     return 1;
 }
 
 void close_db() {
+    stop_idle_maintenance();
+    wait_for_background_backup(); // The backup reads through the primary connection.
+    run_close_maintenance();
+    stop_related_lookup();
+    query_cache_clear();
+    for (int i = 0; i < shard_count; ++i) close_db_shard(&shards[i]);
+    for (int i = 0; i < db_pool_count; ++i) close_db_shard(&db_pool[i]);
+    db_pool_count = 0;
     if (db) {
         sqlite3_close(db);
         db = NULL;
     }
 }
 
+int add_db_shard(const char *path) {
+    if (shard_count >= MAX_SHARDS || !path || !*path) return 0;
+    set_db_shard_path(&shards[shard_count++], path);
+    return 1;
+}
+
+void set_db_shard_path(DbShard *shard, const char *path) {
+    memset(shard, 0, sizeof(DbShard));
+    strncpy(shard->path, path, sizeof(shard->path) - 1);
+
+    const char *base = strrchr(path, '/');
+    base = base ? base + 1 : path;
+    strncpy(shard->label, base, sizeof(shard->label) - 1);
+    char *ext = strrchr(shard->label, '.');
+    if (ext && ext != shard->label) *ext = '\0';
+}
+
+int open_db_shards() {
+    for (int i = 0; i < shard_count; ++i) {
+        if (!init_db(shards[i].path)) {
+            close_db();
+            return 0;
+        }
+        shards[i].conn = db;
+    }
+    select_db_shard(0);
+    return 1;
+}
+
+void select_db_shard(int shard) {
+    if (shard < 0 || shard >= shard_count) return;
+    db = shards[shard].conn;
+}
+
 int db_execute(const char *sql, int (*callback)(void*,int,char**,char**), void *data) {
     if (!db) {
-        if(status_win) show_error("Database connection is not valid.");
+        show_error("Database connection is not valid.");
         return 0;
     }
     char *err_msg = 0;
     int rc = sqlite3_exec(db, sql, callback, data, &err_msg);
     if (rc != SQLITE_OK && rc != SQLITE_ABORT) {
-        if(status_win) show_error("SQL error: %s (Query: %.50s...)", err_msg, sql);
+        show_error("SQL error: %s (Query: %.50s...)", err_msg, sql);
         sqlite3_free(err_msg);
         return 0;
     }
@@ -611,102 +1734,105 @@ int db_execute(const char *sql, int (*callback)(void*,int,char**,char**), void *
     return 1;
 }
 
-int fetch_client_by_id(int id, Client *client) {
+int fetch_client_by_id(int id, Client **client) {
     sqlite3_stmt *stmt;
-    const char *sql = "SELECT id, business_name, email, phone, website, street, city, state, zip_code, country, "
-                      "tax_number, num_employees, industry, contact_person, contact_email, contact_phone, "
-                      "status, notes, strftime('%Y-%m-%d %H:%M:%S', created_at) "
-                      "FROM clients WHERE id = ?;";
+    const char *sql = "SELECT clients.id, business_name, email, phone, website, street, cities.name, states.name, zip_code, "
+                      "countries.name, tax_number, num_employees, industries.name, contact_person, contact_email, contact_phone, "
+                      "status, (SELECT length(body) FROM client_notes WHERE client_id = clients.id), "
+                      "strftime('%Y-%m-%d %H:%M:%S', created_at), row_version "
+                      "FROM clients LEFT JOIN cities ON cities.id = city_id LEFT JOIN states ON states.id = state_id "
+                      "LEFT JOIN countries ON countries.id = country_id LEFT JOIN industries ON industries.id = industry_id "
+                      "WHERE clients.id = ?;";
     int found = 0;
+    *client = NULL;
 
     if (!db) {
-        if(status_win) show_error("DB connection invalid in fetch_client_by_id.");
+        show_error("DB connection invalid in fetch_client_by_id.");
         return 0;
     }
 
-    int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
-    if (rc != SQLITE_OK) {
-        if(status_win) show_error("Failed to prepare select: %s", sqlite3_errmsg(db));
+    stmt = statement_cache_get(db, sql);
+    if (!stmt) {
+        show_error("Failed to prepare select: %s", sqlite3_errmsg(db));
         return 0;
     }
 
     sqlite3_bind_int(stmt, 1, id);
-    rc = sqlite3_step(stmt);
+    int rc = sqlite3_step(stmt);
 
     if (rc == SQLITE_ROW) {
-        found = 1;
-        memset(client, 0, sizeof(Client));
-        client->id = sqlite3_column_int(stmt, 0);
-
-        const unsigned char *text_val;
-        #define SAFE_STRNCPY_FETCH(dest, src_idx, maxlen) \
-            text_val = sqlite3_column_text(stmt, src_idx); \
-            if (text_val) strncpy(dest, (const char*)text_val, maxlen - 1); else dest[0] = '\0'; \
-            dest[maxlen - 1] = '\0'
-
-        SAFE_STRNCPY_FETCH(client->business_name, 1, MAX_STR_LEN);
-        SAFE_STRNCPY_FETCH(client->email, 2, MAX_STR_LEN);
-        SAFE_STRNCPY_FETCH(client->phone, 3, MAX_STR_LEN);
-        SAFE_STRNCPY_FETCH(client->website, 4, MAX_STR_LEN);
-        SAFE_STRNCPY_FETCH(client->street, 5, MAX_STR_LEN);
-        SAFE_STRNCPY_FETCH(client->city, 6, MAX_STR_LEN);
-        SAFE_STRNCPY_FETCH(client->state, 7, MAX_STR_LEN);
-        SAFE_STRNCPY_FETCH(client->zip_code, 8, sizeof(client->zip_code));
-        SAFE_STRNCPY_FETCH(client->country, 9, MAX_STR_LEN);
-        SAFE_STRNCPY_FETCH(client->tax_number, 10, MAX_STR_LEN);
-        client->num_employees = sqlite3_column_int(stmt, 11);
-        SAFE_STRNCPY_FETCH(client->industry, 12, MAX_STR_LEN);
-        SAFE_STRNCPY_FETCH(client->contact_person, 13, MAX_STR_LEN);
-        SAFE_STRNCPY_FETCH(client->contact_email, 14, MAX_STR_LEN);
-        SAFE_STRNCPY_FETCH(client->contact_phone, 15, MAX_STR_LEN);
-        SAFE_STRNCPY_FETCH(client->status, 16, MAX_STR_LEN);
-        if (strlen(client->status) == 0) strcpy(client->status, "Active");
-        SAFE_STRNCPY_FETCH(client->notes, 17, MAX_NOTES_LEN);
-        SAFE_STRNCPY_FETCH(client->created_at, 18, MAX_STR_LEN);
-        #undef SAFE_STRNCPY_FETCH
+        // The text is copied straight from the row into one allocation; columns 1-16 hold the fields in
+        // ClientTextField order with num_employees between tax_number and industry.
+        const char *values[CLIENT_TEXT_FIELD_COUNT];
+        int lengths[CLIENT_TEXT_FIELD_COUNT];
+        for (int field = 0; field < CLIENT_TEXT_FIELD_COUNT; ++field) {
+            int column = field == CF_CREATED_AT ? 18 : field + 1 + (field >= CF_INDUSTRY);
+            values[field] = (const char*)sqlite3_column_text(stmt, column);
+            lengths[field] = sqlite3_column_bytes(stmt, column);
+        }
+        if (lengths[CF_STATUS] == 0) { values[CF_STATUS] = "Active"; lengths[CF_STATUS] = -1; }
+        *client = client_create(values, lengths);
+        if (*client) {
+            found = 1;
+            (*client)->id = sqlite3_column_int(stmt, 0);
+            (*client)->num_employees = sqlite3_column_int(stmt, 11);
+            (*client)->notes_len = sqlite3_column_int(stmt, 17);
+            (*client)->row_version = sqlite3_column_int(stmt, 19);
+        } else {
+            show_error("Memory allocation failed for customer ID %d.", id);
+        }
     } else if (rc != SQLITE_DONE) {
-        if(status_win) show_error("Failed to step select: %s", sqlite3_errmsg(db));
+        show_error("Failed to step select: %s", sqlite3_errmsg(db));
     }
-    sqlite3_finalize(stmt);
+    statement_cache_release(stmt);
     return found;
 }
 
+void bind_client_fields(sqlite3_stmt *stmt, const Client *c) {
+    // Parameters follow the column order: the text fields up to tax_number, num_employees, then industry to status.
+    for (int field = CF_BUSINESS_NAME; field <= CF_STATUS; ++field) {
+        sqlite3_bind_text(stmt, field + 1 + (field >= CF_INDUSTRY), client_text(c, field), c->text_widths[field].bytes, SQLITE_STATIC);
+    }
+    sqlite3_bind_int(stmt, CF_INDUSTRY + 1, c->num_employees);
+}
+
 int db_insert_client(const Client *c) {
-    if (!db) { if(status_win) show_error("DB not connected for insert."); return 0; }
-    const char *sql = "INSERT INTO clients (business_name, email, phone, website, street, city, state, zip_code, country, "
-                      "tax_number, num_employees, industry, contact_person, contact_email, contact_phone, status, notes) "
-                      "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);";
+    if (!db) { show_error("DB not connected for insert."); return 0; }
+    const char *sql = "INSERT INTO clients (business_name, email, phone, website, street, city_id, state_id, zip_code, country_id, "
+                      "tax_number, num_employees, industry_id, contact_person, contact_email, contact_phone, status) "
+                      "VALUES (?, ?, ?, ?, ?, (SELECT id FROM cities WHERE name = trim(?)), (SELECT id FROM states WHERE name = trim(?)), ?, "
+                      "(SELECT id FROM countries WHERE name = trim(?)), ?, ?, (SELECT id FROM industries WHERE name = trim(?)), ?, ?, ?, ?);";
     sqlite3_stmt *stmt;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK) {
-        if(status_win) show_error("DB prepare INSERT failed: %s", sqlite3_errmsg(db));
+    if (!(stmt = statement_cache_get(db, sql))) {
+        show_error("DB prepare INSERT failed: %s", sqlite3_errmsg(db));
         return 0;
     }
-    sqlite3_bind_text(stmt, 1, c->business_name, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 2, c->email, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 3, c->phone, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 4, c->website, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 5, c->street, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 6, c->city, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 7, c->state, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 8, c->zip_code, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 9, c->country, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 10, c->tax_number, -1, SQLITE_STATIC);
-    sqlite3_bind_int(stmt, 11, c->num_employees);
-    sqlite3_bind_text(stmt, 12, c->industry, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 13, c->contact_person, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 14, c->contact_email, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 15, c->contact_phone, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 16, c->status, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 17, c->notes, -1, SQLITE_STATIC);
-
-    int rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    bind_client_fields(stmt, c);
+
+    // The row and its notes are written in one transaction; the error is captured before ROLLBACK resets it.
+    if (!db_begin_write()) { statement_cache_release(stmt); return 0; }
+    int rc = db_intern_dictionary_values(c) ? sqlite3_step(stmt) : SQLITE_ERROR;
+    int err_code = sqlite3_extended_errcode(db);
+    char err_msg[MAX_STR_LEN];
+    snprintf(err_msg, sizeof(err_msg), "%s", sqlite3_errmsg(db));
+    statement_cache_release(stmt);
+
+    if (rc == SQLITE_DONE && c->notes && !db_write_client_notes(sqlite3_last_insert_rowid(db), c->notes)) {
+        rc = SQLITE_ERROR; err_code = sqlite3_extended_errcode(db);
+        snprintf(err_msg, sizeof(err_msg), "%s", sqlite3_errmsg(db));
+    }
+    if (rc == SQLITE_DONE && sqlite3_exec(db, "COMMIT;", NULL, NULL, NULL) != SQLITE_OK) {
+        rc = SQLITE_ERROR; err_code = sqlite3_extended_errcode(db);
+        snprintf(err_msg, sizeof(err_msg), "%s", sqlite3_errmsg(db));
+    }
+    if (rc != SQLITE_DONE) sqlite3_exec(db, "ROLLBACK;", NULL, NULL, NULL);
+    query_cache_clear();
 
     if (rc != SQLITE_DONE) {
-        if (sqlite3_errcode(db) == SQLITE_CONSTRAINT_UNIQUE) {
-             if(status_win) show_error("Insert failed: Business Name '%s' already exists.", c->business_name);
+        if (err_code == SQLITE_CONSTRAINT_UNIQUE) {
+             show_error("Insert failed: Business Name '%s' already exists.", client_text(c, CF_BUSINESS_NAME));
         } else {
-             if(status_win) show_error("DB execute INSERT failed: %s", sqlite3_errmsg(db));
+             show_error("DB execute INSERT failed: %s", err_msg);
         }
         return 0;
     }
@@ -714,42 +1840,51 @@ int db_insert_client(const Client *c) {
 }
 
 int db_update_client(const Client *c) {
-    if (!db) { if(status_win) show_error("DB not connected for update."); return 0; }
-    const char *sql = "UPDATE clients SET business_name=?, email=?, phone=?, website=?, street=?, city=?, state=?, zip_code=?, country=?, "
-                      "tax_number=?, num_employees=?, industry=?, contact_person=?, contact_email=?, contact_phone=?, status=?, notes=? "
-                      "WHERE id=?;";
+    if (!db) { show_error("DB not connected for update."); return 0; }
+    const char *sql = "UPDATE clients SET business_name=?, email=?, phone=?, website=?, street=?, "
+                      "city_id=(SELECT id FROM cities WHERE name = trim(?)), state_id=(SELECT id FROM states WHERE name = trim(?)), zip_code=?, "
+                      "country_id=(SELECT id FROM countries WHERE name = trim(?)), tax_number=?, num_employees=?, "
+                      "industry_id=(SELECT id FROM industries WHERE name = trim(?)), contact_person=?, contact_email=?, contact_phone=?, status=?, "
+                      "row_version = row_version + 1 WHERE id=? AND row_version=?;";
     sqlite3_stmt *stmt;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK) {
-        if(status_win) show_error("DB prepare UPDATE failed: %s", sqlite3_errmsg(db));
+    if (!(stmt = statement_cache_get(db, sql))) {
+        show_error("DB prepare UPDATE failed: %s", sqlite3_errmsg(db));
         return 0;
     }
-    sqlite3_bind_text(stmt, 1, c->business_name, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 2, c->email, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 3, c->phone, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 4, c->website, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 5, c->street, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 6, c->city, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 7, c->state, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 8, c->zip_code, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 9, c->country, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 10, c->tax_number, -1, SQLITE_STATIC);
-    sqlite3_bind_int(stmt, 11, c->num_employees);
-    sqlite3_bind_text(stmt, 12, c->industry, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 13, c->contact_person, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 14, c->contact_email, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 15, c->contact_phone, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 16, c->status, -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 17, c->notes, -1, SQLITE_STATIC);
-    sqlite3_bind_int(stmt, 18, c->id);
+    bind_client_fields(stmt, c);
+    sqlite3_bind_int(stmt, 17, c->id);
+    sqlite3_bind_int(stmt, 18, c->row_version);
+
+    // No row changes when someone else saved the customer since it was fetched; the caller merges and retries.
+    // Inside a caller's transaction the caller commits or rolls back.
+    bool own_txn = sqlite3_get_autocommit(db);
+    if (own_txn && !db_begin_write()) { statement_cache_release(stmt); return 0; }
+    int rc = db_intern_dictionary_values(c) ? sqlite3_step(stmt) : SQLITE_ERROR;
+    int err_code = sqlite3_extended_errcode(db);
+    char err_msg[MAX_STR_LEN];
+    snprintf(err_msg, sizeof(err_msg), "%s", sqlite3_errmsg(db));
+    statement_cache_release(stmt);
+    if (rc == SQLITE_DONE && sqlite3_changes(db) == 0) {
+        if (own_txn) sqlite3_exec(db, "ROLLBACK;", NULL, NULL, NULL);
+        return DB_UPDATE_CONFLICT;
+    }
 
-    int rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    if (rc == SQLITE_DONE && c->notes && !db_write_client_notes(c->id, c->notes)) {
+        rc = SQLITE_ERROR; err_code = sqlite3_extended_errcode(db);
+        snprintf(err_msg, sizeof(err_msg), "%s", sqlite3_errmsg(db));
+    }
+    if (own_txn && rc == SQLITE_DONE && sqlite3_exec(db, "COMMIT;", NULL, NULL, NULL) != SQLITE_OK) {
+        rc = SQLITE_ERROR; err_code = sqlite3_extended_errcode(db);
+        snprintf(err_msg, sizeof(err_msg), "%s", sqlite3_errmsg(db));
+    }
+    if (own_txn && rc != SQLITE_DONE) sqlite3_exec(db, "ROLLBACK;", NULL, NULL, NULL);
+    query_cache_clear();
 
     if (rc != SQLITE_DONE) {
-        if (sqlite3_errcode(db) == SQLITE_CONSTRAINT_UNIQUE) {
-             if(status_win) show_error("Update failed: Business Name '%s' already exists for another customer.", c->business_name);
+        if (err_code == SQLITE_CONSTRAINT_UNIQUE) {
+             show_error("Update failed: Business Name '%s' already exists for another customer.", client_text(c, CF_BUSINESS_NAME));
         } else {
-             if(status_win) show_error("DB execute UPDATE failed: %s", sqlite3_errmsg(db));
+             show_error("DB execute UPDATE failed: %s", err_msg);
         }
         return 0;
     }
@@ -757,131 +1892,2471 @@ int db_update_client(const Client *c) {
 }
 
 int db_delete_client(int client_id) {
-    if (!db) { if(status_win) show_error("DB not connected for delete."); return 0; }
+    if (!db) { show_error("DB not connected for delete."); return 0; }
     const char *sql = "DELETE FROM clients WHERE id = ?;";
     sqlite3_stmt *stmt;
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK) {
-        if(status_win) show_error("DB prepare DELETE failed: %s", sqlite3_errmsg(db));
+    if (!(stmt = statement_cache_get(db, sql))) {
+        show_error("DB prepare DELETE failed: %s", sqlite3_errmsg(db));
         return 0;
     }
     sqlite3_bind_int(stmt, 1, client_id);
+    bool own_txn = sqlite3_get_autocommit(db); // Inside a caller's transaction the caller commits or rolls back.
+    if (own_txn && !db_begin_write()) { statement_cache_release(stmt); return 0; }
     int rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
+    statement_cache_release(stmt);
+    if (own_txn && rc == SQLITE_DONE && sqlite3_exec(db, "COMMIT;", NULL, NULL, NULL) != SQLITE_OK) rc = SQLITE_ERROR;
+    char err_msg[MAX_STR_LEN];
+    snprintf(err_msg, sizeof(err_msg), "%s", sqlite3_errmsg(db));
+    if (own_txn && rc != SQLITE_DONE) sqlite3_exec(db, "ROLLBACK;", NULL, NULL, NULL);
+    query_cache_clear();
 
     if (rc != SQLITE_DONE) {
-        if(status_win) show_error("DB execute DELETE failed: %s", sqlite3_errmsg(db));
+        show_error("DB execute DELETE failed: %s", err_msg);
         return 0;
     }
     return 1;
 }
 
+// Writers take the write lock up front with BEGIN IMMEDIATE and hold it only for their few statements, so concurrent
+// editors queue for the lock instead of failing halfway through a transaction that tried to upgrade a read lock.
+int db_busy_backoff(void *unused, int retries) {
+    (void)unused;
+    if (retries >= BUSY_RETRY_LIMIT) return 0;
+    // Waits double up to a cap and are randomized between half and all of that, so blocked writers do not wake in step.
+    int limit_ms = retries < 8 ? BUSY_RETRY_FIRST_MS << retries : BUSY_RETRY_MAX_MS;
+    if (limit_ms > BUSY_RETRY_MAX_MS) limit_ms = BUSY_RETRY_MAX_MS;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    unsigned int seed = (unsigned int)now.tv_nsec ^ ((unsigned int)getpid() << 16);
+    int wait_ms = limit_ms / 2 + rand_r(&seed) % (limit_ms / 2 + 1);
+    struct timespec pause = { wait_ms / 1000, (wait_ms % 1000) * 1000000L };
+    nanosleep(&pause, NULL);
+    return 1;
+}
 
-// --- Input Helpers ---
-int get_string_input(WINDOW *win, int y, int x, const char *prompt, char *buffer, int max_len, bool allow_empty, const char *current_value_display) {
-    if (!win) return -2;
-    if (max_len <= 0) {
-        if(status_win) show_error("Internal error: max_len <= 0 in get_string_input for %s", prompt);
+int db_begin_write() {
+    int rc = sqlite3_exec(db, "BEGIN IMMEDIATE;", NULL, NULL, NULL);
+    if (rc != SQLITE_OK) {
+        if (rc == SQLITE_BUSY) show_error("Database is busy with other users' changes; try again.");
+        else show_error("Cannot start a write: %s", sqlite3_errmsg(db));
         return 0;
     }
+    return 1;
+}
 
-    char temp_buffer[max_len];
-    temp_buffer[0] = '\0';
-
-    werase(win); draw_custom_box(win);
-    curs_set(1);
-    echo();
 
-    wmove(win, y, x);
-    int prompt_text_visual_len = RF_INPUT_PROMPT_VISUAL_LEN + strlen(prompt) + 1;
+int db_open_client_notes_blob(int client_id, sqlite3_blob **blob, int *size) {
+    *blob = NULL; *size = 0;
+    if (!db) return 0;
+    if (sqlite3_blob_open(db, "main", "client_notes", "body", client_id, 0, blob) != SQLITE_OK) {
+        sqlite3_blob_close(*blob); // No row means no notes; sqlite3_blob_close(NULL) is a no-op.
+        *blob = NULL;
+        return 0;
+    }
+    *size = sqlite3_blob_bytes(*blob);
+    return 1;
+}
 
-    wprintw(win, "%s%s ", RF_INPUT_PROMPT_STR, prompt);
-    if (current_value_display && strlen(current_value_display) > 0) {
-        if(has_colors()) wattron(win, COLOR_PAIR(COLOR_PAIR_INPUT_CURRENT));
+char *db_read_client_notes(int client_id) {
+    sqlite3_blob *blob;
+    int size;
+    if (!db_open_client_notes_blob(client_id, &blob, &size)) return calloc(1, 1);
+
+    char *notes = malloc(size + 1);
+    if (!notes) { sqlite3_blob_close(blob); return NULL; }
+    for (int offset = 0; offset < size; offset += NOTES_BLOB_CHUNK) {
+        int n = size - offset < NOTES_BLOB_CHUNK ? size - offset : NOTES_BLOB_CHUNK;
+        if (sqlite3_blob_read(blob, notes + offset, n, offset) != SQLITE_OK) {
+            sqlite3_blob_close(blob);
+            free(notes);
+            return NULL;
+        }
+    }
+    notes[size] = '\0';
+    sqlite3_blob_close(blob);
+    return notes;
+}
 
-        int available_for_current = getmaxx(win) - x - prompt_text_visual_len - 3 - 2;
-        if (available_for_current < 3) available_for_current = 3;
+// Must run inside the caller's transaction; reports failure through sqlite3_errmsg(db) only.
+int db_write_client_notes(sqlite3_int64 client_id, const char *notes) {
+    int len = notes ? strlen(notes) : 0;
+    sqlite3_stmt *stmt;
+    // The whole text is bound in the statement: the change log triggers fire on it and must see the notes, which
+    // incremental BLOB writes after the row exists would bypass.
+    const char *sql = len > 0 ? "INSERT OR REPLACE INTO client_notes (client_id, body) VALUES (?, ?);"
+                              : "DELETE FROM client_notes WHERE client_id = ?;";
+    get_client_notes_preview(0, 0); // Drops the cached preview.
+
+    if (!(stmt = statement_cache_get(db, sql))) return 0;
+    sqlite3_bind_int64(stmt, 1, client_id);
+    if (len > 0) sqlite3_bind_blob(stmt, 2, notes, len, SQLITE_STATIC);
+    int rc = sqlite3_step(stmt);
+    statement_cache_release(stmt);
+    return rc == SQLITE_DONE;
+}
 
-        wprintw(win, "[%.*s%s]",
-                available_for_current - (strlen(current_value_display) > (size_t)available_for_current ? 2:0),
-                current_value_display,
-                strlen(current_value_display) > (size_t)available_for_current ? ".." : "");
+// Keeps the preview of the most recently shown client so list redraws do not touch the BLOB again.
+const char *get_client_notes_preview(int client_id, int max_bytes) {
+    static char *preview = NULL;
+    static int preview_id = 0, preview_bytes = 0;
 
-        if(has_colors()) wattroff(win, COLOR_PAIR(COLOR_PAIR_INPUT_CURRENT));
+    if (client_id <= 0 || max_bytes <= 0) {
+        free(preview); preview = NULL;
+        preview_id = preview_bytes = 0;
+        return NULL;
     }
-    wprintw(win, ": ");
-    wrefresh(win);
-
-    int result = wgetnstr(win, temp_buffer, max_len - 1);
-
-    noecho();
-    curs_set(0);
-    werase(win); draw_custom_box(win); wrefresh(win);
+    if (preview && preview_id == client_id && preview_bytes >= max_bytes) return preview;
+
+    sqlite3_blob *blob;
+    int size;
+    if (!db_open_client_notes_blob(client_id, &blob, &size)) return NULL;
+    int n = size < max_bytes ? size : max_bytes;
+
+    char *buf = malloc(n + 1);
+    if (!buf || sqlite3_blob_read(blob, buf, n, 0) != SQLITE_OK) {
+        free(buf);
+        sqlite3_blob_close(blob);
+        return NULL;
+    }
+    sqlite3_blob_close(blob);
+
+    // Drop a multibyte character cut in half at the end of the piece.
+    if (n < size) {
+        int lead = n;
+        while (lead > 0 && ((unsigned char)buf[lead - 1] & 0xC0) == 0x80) lead--;
+        if (lead > 0 && ((unsigned char)buf[lead - 1] & 0x80)) {
+            unsigned char c = buf[lead - 1];
+            int seq_len = (c & 0xE0) == 0xC0 ? 2 : (c & 0xF0) == 0xE0 ? 3 : (c & 0xF8) == 0xF0 ? 4 : 1;
+            if (n - (lead - 1) < seq_len) n = lead - 1;
+        }
+    }
+    buf[n] = '\0';
 
-    temp_buffer[strcspn(temp_buffer, "\r\n")] = 0;
+    free(preview);
+    preview = buf;
+    preview_id = client_id;
+    preview_bytes = n < size ? max_bytes : INT_MAX;
+    return preview;
+}
 
-    if (result == ERR) {
-        if (current_value_display) {
-            strncpy(buffer, current_value_display, max_len - 1);
-        } else {
-            buffer[0] = '\0';
+// --- Connection Pool ---
+// Each open database keeps its frequently run statements prepared, and databases switched away from stay open in
+// db_pool with their page caches and statements, so switching back skips init_db's schema checks and cold reads.
+// Both are bounded: STATEMENT_CACHE_SIZE statements per connection and DB_POOL_SIZE pooled connections.
+sqlite3_stmt *statement_cache_get(sqlite3 *conn, const char *sql) {
+    DbShard *shard = NULL;
+    for (int i = 0; i < shard_count && !shard; ++i) {
+        if (shards[i].conn == conn) shard = &shards[i];
+    }
+    CachedStatement *slot = NULL;
+    for (int i = 0; shard && i < STATEMENT_CACHE_SIZE; ++i) {
+        CachedStatement *entry = &shard->statements[i];
+        if (entry->in_use) continue;
+        if (entry->stmt && strcmp(sqlite3_sql(entry->stmt), sql) == 0) {
+            entry->in_use = true;
+            entry->last_used = ++statement_cache_clock;
+            return entry->stmt;
         }
-        buffer[max_len - 1] = '\0';
-        return -1;
+        if (!slot || (slot->stmt && (!entry->stmt || entry->last_used < slot->last_used))) slot = entry;
+    }
+    // Statements of connections that are not open shards yet, or needed twice at once, are not cached.
+    sqlite3_stmt *stmt = NULL;
+    if (sqlite3_prepare_v3(conn, sql, -1, slot ? SQLITE_PREPARE_PERSISTENT : 0, &stmt, NULL) != SQLITE_OK) {
+        sqlite3_finalize(stmt);
+        return NULL;
     }
+    if (slot) {
+        sqlite3_finalize(slot->stmt);
+        slot->stmt = stmt;
+        slot->in_use = true;
+        slot->last_used = ++statement_cache_clock;
+    }
+    return stmt;
+}
 
-    if (strlen(temp_buffer) == 0) {
-        if (current_value_display) {
-            strncpy(buffer, current_value_display, max_len - 1);
-            buffer[max_len - 1] = '\0';
-            return 1;
-        } else {
-            if (!allow_empty) {
-                show_error("Input for '%s' cannot be empty.", prompt);
-                buffer[0] = '\0';
-                return 0;
-            }
-            buffer[0] = '\0';
-            return 1;
+void statement_cache_release(sqlite3_stmt *stmt) {
+    if (!stmt) return;
+    sqlite3 *conn = sqlite3_db_handle(stmt);
+    for (int i = 0; i < shard_count; ++i) {
+        if (shards[i].conn != conn) continue;
+        for (int k = 0; k < STATEMENT_CACHE_SIZE; ++k) {
+            if (shards[i].statements[k].stmt != stmt) continue;
+            sqlite3_reset(stmt);
+            sqlite3_clear_bindings(stmt);
+            shards[i].statements[k].in_use = false;
+            return;
         }
     }
-
-    strncpy(buffer, temp_buffer, max_len - 1);
-    buffer[max_len - 1] = '\0';
-    return 1;
+    sqlite3_finalize(stmt);
 }
 
-int get_int_input(WINDOW *win, int y, int x, const char *prompt, int *value_ptr, int current_value) {
-    char buffer[MAX_STR_LEN];
-    char current_val_str[32];
-    snprintf(current_val_str, sizeof(current_val_str), "%d", current_value);
-
-    int res = get_string_input(win, y, x, prompt, buffer, sizeof(buffer), true, current_val_str);
+void close_db_shard(DbShard *shard) {
+    for (int k = 0; k < STATEMENT_CACHE_SIZE; ++k) {
+        sqlite3_finalize(shard->statements[k].stmt);
+        shard->statements[k].stmt = NULL;
+        shard->statements[k].in_use = false;
+    }
+    if (shard->conn) {
+        if (shard->conn == db) db = NULL;
+        sqlite3_close(shard->conn);
+        shard->conn = NULL;
+    }
+}
 
-    if (res == -1) return -1;
-    if (res == 0 ) return 0;
+bool same_db_file(const char *a, const char *b) {
+    struct stat sa, sb;
+    if (stat(a, &sa) == 0 && stat(b, &sb) == 0) return sa.st_dev == sb.st_dev && sa.st_ino == sb.st_ino;
+    return strcmp(a, b) == 0;
+}
 
-    if (strlen(buffer) == 0 || strcmp(buffer, current_val_str) == 0) {
-        *value_ptr = current_value;
-        return 1;
+void db_pool_park(DbShard *shard) {
+    if (db_pool_count == DB_POOL_SIZE) {
+        int oldest = 0;
+        for (int i = 1; i < db_pool_count; ++i) {
+            if (db_pool[i].parked_ms < db_pool[oldest].parked_ms) oldest = i;
+        }
+        close_db_shard(&db_pool[oldest]);
+        db_pool[oldest] = db_pool[--db_pool_count];
     }
+    shard->parked_ms = monotonic_ms();
+    db_pool[db_pool_count++] = *shard;
+    shard->conn = NULL; // The pool owns the connection and its statements now.
+    memset(shard->statements, 0, sizeof(shard->statements));
+}
 
-    char *endptr;
-    long num = strtol(buffer, &endptr, 10);
+bool db_pool_take(const char *path, DbShard *shard) {
+    for (int i = 0; i < db_pool_count; ++i) {
+        if (!same_db_file(db_pool[i].path, path)) continue;
+        shard->conn = db_pool[i].conn;
+        shard->maintenance_due_ms = db_pool[i].maintenance_due_ms;
+        memcpy(shard->statements, db_pool[i].statements, sizeof(shard->statements));
+        db_pool[i] = db_pool[--db_pool_count];
+        return true;
+    }
+    return false;
+}
 
-    if (*endptr != '\0' || endptr == buffer) {
-        show_error("Invalid number for '%s': %s", prompt, buffer);
-        *value_ptr = current_value;
+int switch_db_shards(const char *paths) {
+    DbShard next[MAX_SHARDS];
+    int next_count = 0;
+    char *list = strdup(paths), *save_ptr = NULL;
+    if (!list) { show_error("Memory allocation failed switching databases."); return 0; }
+    for (char *path = strtok_r(list, ",", &save_ptr); path; path = strtok_r(NULL, ",", &save_ptr)) {
+        if (next_count == MAX_SHARDS) {
+            show_error("Too many databases (at most %d).", MAX_SHARDS);
+            free(list);
+            return 0;
+        }
+        set_db_shard_path(&next[next_count++], path);
+    }
+    free(list);
+    if (next_count == 0) { show_error("No database file given."); return 0; }
+    pthread_mutex_lock(&backup_job.lock);
+    bool backing_up = backup_job.active;
+    pthread_mutex_unlock(&backup_job.lock);
+    if (backing_up) { show_error("Wait for the backup to finish before switching databases."); return 0; }
+
+    // Databases already open or pooled are reused as they are; only the others go through init_db.
+    bool kept[MAX_SHARDS] = { false }, reused[MAX_SHARDS] = { false };
+    int opened = 0;
+    for (; opened < next_count; ++opened) {
+        DbShard *shard = &next[opened];
+        for (int j = 0; j < shard_count && !shard->conn; ++j) {
+            if (kept[j] || !same_db_file(shards[j].path, shard->path)) continue;
+            kept[j] = reused[opened] = true;
+            shard->conn = shards[j].conn;
+            memcpy(shard->statements, shards[j].statements, sizeof(shard->statements));
+        }
+        if (shard->conn || db_pool_take(shard->path, shard)) continue;
+        if (!init_db(shard->path)) break; // init_db has reported why.
+        shard->conn = db;
+    }
+    if (opened < next_count) {
+        for (int i = 0; i < opened; ++i) {
+            if (!reused[i]) db_pool_park(&next[i]);
+        }
+        select_db_shard(0);
         return 0;
     }
-    *value_ptr = (int)num;
+    bool unchanged = next_count == shard_count;
+    for (int i = 0; i < next_count && unchanged; ++i) unchanged = next[i].conn == shards[i].conn;
+    if (unchanged) return 1; // Same databases in the same order: nothing to reopen, reschedule or forget.
+
+    long long idle_ms = maintenance_job.idle_ms;
+    stop_idle_maintenance(); // Its schedule and the related lookups' connections are per shard index.
+    stop_related_lookup();
+    query_cache_clear();
+    get_client_notes_preview(0, 0);
+    for (int j = 0; j < shard_count; ++j) {
+        shards[j].maintenance_due_ms = maintenance_job.next_run_ms[j];
+        for (int i = 0; i < next_count; ++i) {
+            if (next[i].conn == shards[j].conn) next[i].maintenance_due_ms = shards[j].maintenance_due_ms;
+        }
+        if (!kept[j]) db_pool_park(&shards[j]);
+    }
+    for (int i = 0; i < MAX_SHARDS; ++i) maintenance_job.next_run_ms[i] = i < next_count ? next[i].maintenance_due_ms : 0;
+    memcpy(shards, next, next_count * sizeof(DbShard));
+    shard_count = next_count;
+    select_db_shard(0);
+    strncpy(db_path, shards[0].path, sizeof(db_path) - 1);
+    db_path[sizeof(db_path) - 1] = '\0';
+    start_idle_maintenance((int)(idle_ms / 1000));
     return 1;
 }
 
-int select_client_status(char *selected_status, const char *current_status) {
-    const char *statuses[] = {"Active", "Inactive", "Prospect", "Lead", "Former", "(Cancel)"};
-    int n_statuses = sizeof(statuses) / sizeof(statuses[0]);
-    int choice = 0;
-    int key;
+// --- Query Result Cache ---
+void query_cache_clear() {
+    while (query_cache_head) {
+        QueryCacheEntry *next = query_cache_head->next;
+        sqlite3_free(query_cache_head->key);
+        free(query_cache_head->items);
+        free(query_cache_head);
+        query_cache_head = next;
+    }
+    query_cache_bytes = 0;
+    related_cache_clear();
+}
+
+// data_version only changes for commits made by other connections; our own writes clear the cache directly in the db_* functions.
+void query_cache_validate() {
+    for (int i = 0; i < shard_count; ++i) {
+        sqlite3_stmt *stmt;
+        sqlite3_int64 version = -1;
+        if (shards[i].conn && (stmt = statement_cache_get(shards[i].conn, "PRAGMA data_version;"))) {
+            if (sqlite3_step(stmt) == SQLITE_ROW) version = sqlite3_column_int64(stmt, 0);
+            statement_cache_release(stmt);
+        }
+        if (version < 0 || version != query_cache_data_versions[i]) {
+            query_cache_clear();
+            query_cache_data_versions[i] = version;
+        }
+    }
+}
+
+const QueryCacheEntry *query_cache_lookup(const char *key) {
+    if (!key) return NULL;
+    query_cache_validate();
+
+    QueryCacheEntry *prev = NULL;
+    for (QueryCacheEntry *e = query_cache_head; e; prev = e, e = e->next) {
+        if (strcmp(e->key, key) != 0) continue;
+        if (prev) {
+            prev->next = e->next;
+            e->next = query_cache_head;
+            query_cache_head = e;
+        }
+        return e;
+    }
+    return NULL;
+}
+
+void query_cache_store(const char *key, const ClientListItem *items, int count) {
+    if (!key || count < 0) return;
+    size_t rows_bytes = (size_t)count * sizeof(ClientListItem);
+    size_t entry_bytes = sizeof(QueryCacheEntry) + strlen(key) + 1 + rows_bytes;
+    if (entry_bytes > memory_budget.query_cache_max_bytes) return;
+
+    while (query_cache_head && query_cache_bytes + entry_bytes > memory_budget.query_cache_max_bytes) {
+        QueryCacheEntry **tail = &query_cache_head;
+        while ((*tail)->next) tail = &(*tail)->next;
+        query_cache_bytes -= (*tail)->bytes;
+        sqlite3_free((*tail)->key);
+        free((*tail)->items);
+        free(*tail);
+        *tail = NULL;
+    }
+
+    QueryCacheEntry *entry = calloc(1, sizeof(QueryCacheEntry));
+    if (!entry) return;
+    entry->key = sqlite3_mprintf("%s", key);
+    entry->items = rows_bytes > 0 ? malloc(rows_bytes) : NULL;
+    if (!entry->key || (rows_bytes > 0 && !entry->items)) {
+        sqlite3_free(entry->key); free(entry->items); free(entry);
+        return;
+    }
+    if (rows_bytes > 0) memcpy(entry->items, items, rows_bytes);
+    entry->count = count;
+    entry->bytes = entry_bytes;
+    entry->next = query_cache_head;
+    query_cache_head = entry;
+    query_cache_bytes += entry_bytes;
+}
+
+// LIKE only folds ASCII case, so the key folds ASCII only; whitespace around the term is already trimmed by the caller.
+char *build_search_cache_key(const char *search_term, InteractiveListAction action, unsigned columns) {
+    char *key = sqlite3_mprintf("%d:%d:%u:%s", (int)action, list_status_filter, columns, search_term);
+    if (!key) return NULL;
+    for (char *p = key; *p; ++p) {
+        if (*p >= 'A' && *p <= 'Z') *p = *p - 'A' + 'a';
+    }
+    return key;
+}
+
+// --- Related Customers ---
+// The detail pane lists other customers in the selected one's city and industry and at its email domain. Each kind is
+// a few entries read in business name order from an index, on a worker thread with its own connections, so moving
+// through a list never waits for them; results are cached per customer until the next write.
+void related_request_for_client(int shard, const Client *client, RelatedRequest *request) {
+    memset(request, 0, sizeof(*request));
+    request->shard = shard;
+    request->client_id = client->id;
+    const char *city = client_text(client, CF_CITY), *industry = client_text(client, CF_INDUSTRY);
+    if (city[0] && industry[0]) {
+        snprintf(request->city, sizeof(request->city), "%s", city);
+        snprintf(request->industry, sizeof(request->industry), "%s", industry);
+    }
+    const char *at = strchr(client_text(client, CF_EMAIL), '@');
+    if (at && at[1]) {
+        size_t len = 0;
+        for (const char *c = at + 1; *c && len < sizeof(request->domain) - 1; ++c) {
+            request->domain[len++] = (*c >= 'A' && *c <= 'Z') ? *c - 'A' + 'a' : *c; // ASCII only, like SQL lower().
+        }
+        request->domain[len] = '\0';
+    }
+}
+
+int get_related_customers(int shard, const Client *client, RelatedEntry *entry) {
+    RelatedLookup *lookup = &related_lookup;
+    pthread_mutex_lock(&lookup->lock);
+    for (int i = 0; i < RELATED_CACHE_SIZE; ++i) {
+        if (lookup->cache[i].client_id == client->id && lookup->cache[i].shard == shard) {
+            *entry = lookup->cache[i];
+            pthread_mutex_unlock(&lookup->lock);
+            return 1;
+        }
+    }
+    bool queued = (lookup->pending && lookup->request.client_id == client->id && lookup->request.shard == shard) ||
+                  (lookup->running.client_id == client->id && lookup->running.shard == shard);
+    if (!queued) {
+        related_request_for_client(shard, client, &lookup->request);
+        lookup->pending = true;
+        if (!lookup->started) {
+            lookup->started = pthread_create(&lookup->thread, NULL, related_lookup_worker, lookup) == 0;
+        }
+        if (!lookup->started) { // Without a worker the lookup runs here, uncached.
+            RelatedRequest request = lookup->request;
+            lookup->pending = false;
+            pthread_mutex_unlock(&lookup->lock);
+            run_related_lookup(&request, entry);
+            return 1;
+        }
+        pthread_cond_signal(&lookup->wake);
+    }
+    pthread_mutex_unlock(&lookup->lock);
+    return 0;
+}
+
+void related_cache_clear() {
+    pthread_mutex_lock(&related_lookup.lock);
+    related_lookup.generation++;
+    related_lookup.pending = false;
+    memset(related_lookup.cache, 0, sizeof(related_lookup.cache));
+    pthread_mutex_unlock(&related_lookup.lock);
+}
+
+// idx_clients_city_industry holds every column of the first query, so it never reads the table. SQLite does not
+// answer queries from an expression index alone, so the second reads one table row per customer it returns.
+void run_related_lookup(const RelatedRequest *request, RelatedEntry *entry) {
+    const char *sql[RELATED_KIND_COUNT] = {
+        "SELECT id, business_name FROM clients WHERE city_id = (SELECT id FROM cities WHERE name = ?1) "
+        "AND industry_id = (SELECT id FROM industries WHERE name = ?2) AND id <> ?3 ORDER BY business_name LIMIT ?4;",
+        "SELECT id, business_name FROM clients WHERE lower(substr(email, instr(email, '@') + 1)) = ?1 AND instr(email, '@') > 0 "
+        "AND id <> ?2 ORDER BY business_name LIMIT ?3;"
+    };
+    memset(entry, 0, sizeof(*entry));
+    entry->shard = request->shard;
+    entry->client_id = request->client_id;
+
+    sqlite3 **conn = &related_lookup.conns[request->shard];
+    if (!*conn) {
+        if (sqlite3_open_v2(shards[request->shard].path, conn, SQLITE_OPEN_READONLY, NULL) == SQLITE_OK) {
+            sqlite3_busy_handler(*conn, db_busy_backoff, NULL);
+        } else {
+            sqlite3_close(*conn);
+            *conn = NULL;
+        }
+    }
+    for (int kind = 0; kind < RELATED_KIND_COUNT; ++kind) {
+        const char *key = kind == RELATED_CITY_INDUSTRY ? request->city : request->domain;
+        if (!key[0]) continue;
+        sqlite3_stmt *stmt = NULL;
+        if (!*conn || sqlite3_prepare_v2(*conn, sql[kind], -1, &stmt, NULL) != SQLITE_OK) {
+            entry->count[kind] = -1;
+            continue;
+        }
+        int param = 1;
+        sqlite3_bind_text(stmt, param++, key, -1, SQLITE_STATIC);
+        if (kind == RELATED_CITY_INDUSTRY) sqlite3_bind_text(stmt, param++, request->industry, -1, SQLITE_STATIC);
+        sqlite3_bind_int(stmt, param++, request->client_id);
+        sqlite3_bind_int(stmt, param, RELATED_LIMIT);
+        int rc;
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+            int n = entry->count[kind]++;
+            const unsigned char *name = sqlite3_column_text(stmt, 1);
+            entry->ids[kind][n] = sqlite3_column_int(stmt, 0);
+            snprintf(entry->names[kind][n], MAX_STR_LEN, "%s", name ? (const char *)name : "");
+        }
+        if (rc != SQLITE_ROW && rc != SQLITE_DONE) entry->count[kind] = -1;
+        sqlite3_finalize(stmt);
+    }
+}
+
+void *related_lookup_worker(void *arg) {
+    RelatedLookup *lookup = arg;
+    pthread_mutex_lock(&lookup->lock);
+    while (!lookup->stop) {
+        if (!lookup->pending) {
+            pthread_cond_wait(&lookup->wake, &lookup->lock);
+            continue;
+        }
+        RelatedRequest request = lookup->request;
+        unsigned generation = lookup->generation;
+        lookup->running = request;
+        lookup->pending = false;
+        pthread_mutex_unlock(&lookup->lock);
+
+        RelatedEntry entry;
+        run_related_lookup(&request, &entry);
+
+        pthread_mutex_lock(&lookup->lock);
+        if (generation == lookup->generation) { // Otherwise a write happened meanwhile and the result may be stale.
+            lookup->cache[lookup->cache_next] = entry;
+            lookup->cache_next = (lookup->cache_next + 1) % RELATED_CACHE_SIZE;
+        }
+        lookup->running.client_id = 0;
+    }
+    pthread_mutex_unlock(&lookup->lock);
+    return NULL;
+}
+
+void stop_related_lookup() {
+    pthread_mutex_lock(&related_lookup.lock);
+    bool started = related_lookup.started;
+    related_lookup.stop = true;
+    pthread_cond_signal(&related_lookup.wake);
+    pthread_mutex_unlock(&related_lookup.lock);
+    if (started) pthread_join(related_lookup.thread, NULL);
+    related_lookup.started = false;
+    related_lookup.stop = false;
+    related_lookup.pending = false;
+    for (int i = 0; i < MAX_SHARDS; ++i) {
+        if (related_lookup.conns[i]) { sqlite3_close(related_lookup.conns[i]); related_lookup.conns[i] = NULL; }
+    }
+}
+
+// --- Federated Search ---
+// Each worker only touches its own shard's connection, and the UI thread waits for all of them before using any result.
+void *shard_search_worker(void *arg) {
+    ShardSearchJob *job = (ShardSearchJob*)arg;
+    FetchListData list_data = { &job->list, job->shard };
+    char *err_msg = NULL;
+
+    job->rc = sqlite3_exec(shards[job->shard].conn, job->sql_query, fetch_list_items_callback, &list_data, &err_msg);
+    if ((job->rc == SQLITE_OK || job->rc == SQLITE_ABORT) && !client_list_finish(&job->list)) {
+        job->rc = SQLITE_NOMEM;
+        snprintf(job->err_msg, sizeof(job->err_msg), "%s: %s", shards[job->shard].label, sqlite3_errmsg(job->list.spill_db));
+    } else if (job->rc != SQLITE_OK) {
+        snprintf(job->err_msg, sizeof(job->err_msg), "%s: %s", shards[job->shard].label, err_msg ? err_msg : sqlite3_errstr(job->rc));
+    }
+    sqlite3_free(err_msg);
+    return NULL;
+}
+
+int fetch_list_items_from_shards(const char *sql_query, ClientList *list, ListOrder order) {
+    ShardSearchJob jobs[MAX_SHARDS];
+    pthread_t threads[MAX_SHARDS];
+    bool started[MAX_SHARDS];
+    memset(jobs, 0, sizeof(jobs));
+
+    // The shard lists share the budget, so together they keep no more rows in memory than one list would.
+    int shard_max_items = memory_budget.max_list_items / shard_count;
+    if (shard_max_items < LIST_SPILL_MIN_ITEMS) shard_max_items = LIST_SPILL_MIN_ITEMS;
+    for (int i = 0; i < shard_count; ++i) {
+        jobs[i].shard = i;
+        jobs[i].sql_query = sql_query;
+        jobs[i].list.max_items = shard_max_items;
+        started[i] = pthread_create(&threads[i], NULL, shard_search_worker, &jobs[i]) == 0;
+        if (!started[i]) shard_search_worker(&jobs[i]); // Could not spawn a thread: run this shard inline.
+    }
+    for (int i = 0; i < shard_count; ++i) {
+        if (started[i]) pthread_join(threads[i], NULL);
+    }
+
+    int total = 0, failed = -1;
+    for (int i = 0; i < shard_count; ++i) {
+        if (jobs[i].rc != SQLITE_OK && jobs[i].rc != SQLITE_ABORT && failed < 0) failed = i;
+        total += jobs[i].list.count;
+    }
+    if (failed < 0 && total > 0 && total <= memory_budget.max_list_items && !client_list_grow(list, total)) failed = shard_count;
+
+    // Every shard returns rows in the list's order (business_name NOCASE, or sort_key and for created_at the id descending);
+    // merge them, keeping shard order on ties.
+    // Spilled shard lists are read through their windows, so the merge stays within the budget too.
+    int pos[MAX_SHARDS] = {0};
+    for (int n = 0; n < total && failed < 0; ++n) {
+        int best = -1;
+        ClientListItem *best_item = NULL;
+        for (int i = 0; i < shard_count; ++i) {
+            if (pos[i] >= jobs[i].list.count) continue;
+            ClientListItem *item = client_list_item(&jobs[i].list, pos[i]);
+            bool before = best < 0 || (order == LIST_ORDER_NAME ? sqlite3_stricmp(item->business_name, best_item->business_name) < 0
+                                                                : item->sort_key < best_item->sort_key
+                                                                  || (order == LIST_ORDER_CREATED && item->sort_key == best_item->sort_key
+                                                                      && item->id > best_item->id));
+            if (before) { best = i; best_item = item; }
+        }
+        if (!client_list_append(list, best_item)) failed = shard_count;
+        pos[best]++;
+    }
+    for (int i = 0; i < shard_count; ++i) client_list_free(&jobs[i].list);
+    if (failed < 0 && !client_list_finish(list)) failed = shard_count;
+
+    if (failed >= 0) {
+        client_list_free(list);
+        if (failed < shard_count) show_error("SQL error: %s", jobs[failed].err_msg);
+        else show_error("Failed to allocate memory for merged results.");
+        return 0;
+    }
+    return 1;
+}
+
+int fetch_client_list(const char *sql_query, ListOrder order, ClientList *list) {
+    if (shard_count > 1) return fetch_list_items_from_shards(sql_query, list, order);
+    FetchListData list_data = { list, 0 };
+    int ok = db_execute(sql_query, fetch_list_items_callback, &list_data);
+    if (ok && !client_list_finish(list)) {
+        show_error("Failed to store the results: %s", sqlite3_errmsg(list->spill_db));
+        ok = 0;
+    }
+    if (!ok) client_list_free(list);
+    return ok;
+}
+
+// --- Change Log ---
+void build_client_change_row_sql(const char *ref, char *buf, size_t size) {
+    static const char *columns[] = {
+        "id", "business_name", "email", "phone", "website", "street", "city", "state", "zip_code", "country",
+        "tax_number", "num_employees", "industry", "contact_person", "contact_email", "contact_phone", "status", "created_at"
+    };
+    int len = snprintf(buf, size, "json_object(");
+    for (size_t i = 0; i < sizeof(columns) / sizeof(columns[0]) && len < (int)size; ++i) {
+        const char *table = dictionary_table_for(columns[i]);
+        // An empty value is stored as a NULL id; it is logged as "", as the text columns were before the lookup tables.
+        if (table) len += snprintf(buf + len, size - len, "'%s', coalesce((SELECT name FROM \"%s\" WHERE id = %s.\"%s_id\"), ''), ", columns[i], table, ref, columns[i]);
+        else len += snprintf(buf + len, size - len, "'%s', %s.\"%s\", ", columns[i], ref, columns[i]);
+    }
+    if (len < (int)size) {
+        snprintf(buf + len, size - len,
+                 "'notes', (SELECT CAST(body AS TEXT) FROM client_notes WHERE client_id = %s.\"id\"))", ref);
+    }
+}
+
+// Every change to clients or their notes appends the full row, so a consumer can apply entries without reading
+// the table. AUTOINCREMENT keeps sequence numbers increasing even after compaction empties the tail of the log.
+int init_change_log() {
+    bool new_log = !check_column_exists("client_changes", "seq");
+    char new_row[CHANGE_ROW_SQL_LEN], joined_row[CHANGE_ROW_SQL_LEN];
+    build_client_change_row_sql("NEW", new_row, sizeof(new_row));
+    build_client_change_row_sql("c", joined_row, sizeof(joined_row));
+
+    // Triggers written by an earlier version serialize rows differently; they are replaced in the same transaction.
+    bool stale_triggers = false;
+    sqlite3_stmt *trigger_stmt;
+    if (sqlite3_prepare_v2(db, "SELECT sql FROM sqlite_master WHERE type = 'trigger' AND name = 'clients_log_insert';", -1, &trigger_stmt, NULL) == SQLITE_OK) {
+        if (sqlite3_step(trigger_stmt) == SQLITE_ROW) {
+            const char *trigger_sql = (const char*)sqlite3_column_text(trigger_stmt, 0);
+            stale_triggers = trigger_sql && !strstr(trigger_sql, new_row);
+        }
+        sqlite3_finalize(trigger_stmt);
+    }
+
+    size_t sql_size = 8 * CHANGE_ROW_SQL_LEN;
+    char *sql = malloc(sql_size);
+    if (!sql) return 0;
+    snprintf(sql, sql_size,
+        "BEGIN IMMEDIATE;"
+        "%s"
+        "CREATE TABLE IF NOT EXISTS \"client_changes\" ("
+        "\"seq\"	INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "\"op\"	TEXT NOT NULL CHECK(\"op\" IN ('insert', 'update', 'delete')),"
+        "\"client_id\"	INTEGER NOT NULL,"
+        "\"changed_at\"	TEXT NOT NULL DEFAULT (strftime('%%Y-%%m-%%dT%%H:%%M:%%fZ', 'now')),"
+        "\"row\"	TEXT"
+        ");"
+        "CREATE INDEX IF NOT EXISTS \"idx_client_changes_client\" ON \"client_changes\" (\"client_id\", \"seq\");"
+        "CREATE TABLE IF NOT EXISTS \"client_changes_state\" ("
+        "\"id\"	INTEGER PRIMARY KEY CHECK(\"id\" = 1),"
+        "\"purged_through\"	INTEGER NOT NULL DEFAULT 0"
+        ");"
+        "INSERT OR IGNORE INTO \"client_changes_state\" (\"id\") VALUES (1);"
+        "CREATE TRIGGER IF NOT EXISTS \"clients_log_insert\" AFTER INSERT ON \"clients\" "
+        "BEGIN INSERT INTO client_changes (op, client_id, row) VALUES ('insert', NEW.id, %s); END;"
+        "CREATE TRIGGER IF NOT EXISTS \"clients_log_update\" AFTER UPDATE ON \"clients\" "
+        "BEGIN INSERT INTO client_changes (op, client_id, row) VALUES ('update', NEW.id, %s); END;"
+        "CREATE TRIGGER IF NOT EXISTS \"clients_log_delete\" AFTER DELETE ON \"clients\" "
+        "BEGIN INSERT INTO client_changes (op, client_id, row) VALUES ('delete', OLD.id, NULL); END;"
+        "CREATE TRIGGER IF NOT EXISTS \"client_notes_log_insert\" AFTER INSERT ON \"client_notes\" "
+        "BEGIN INSERT INTO client_changes (op, client_id, row) SELECT 'update', c.id, %s FROM clients c WHERE c.id = NEW.client_id; END;"
+        "CREATE TRIGGER IF NOT EXISTS \"client_notes_log_update\" AFTER UPDATE ON \"client_notes\" "
+        "BEGIN INSERT INTO client_changes (op, client_id, row) SELECT 'update', c.id, %s FROM clients c WHERE c.id = NEW.client_id; END;"
+        "CREATE TRIGGER IF NOT EXISTS \"client_notes_log_delete\" AFTER DELETE ON \"client_notes\" "
+        "BEGIN INSERT INTO client_changes (op, client_id, row) SELECT 'update', c.id, %s FROM clients c WHERE c.id = OLD.client_id; END;",
+        stale_triggers ? "DROP TRIGGER IF EXISTS \"clients_log_insert\";"
+                         "DROP TRIGGER IF EXISTS \"clients_log_update\";"
+                         "DROP TRIGGER IF EXISTS \"client_notes_log_insert\";"
+                         "DROP TRIGGER IF EXISTS \"client_notes_log_update\";"
+                         "DROP TRIGGER IF EXISTS \"client_notes_log_delete\";" : "",
+        new_row, new_row, joined_row, joined_row, joined_row);
+    size_t used = strlen(sql);
+    if (new_log) {
+        // Seed the new log with the current table so that tailing from 0 reproduces every existing customer.
+        used += snprintf(sql + used, sql_size - used,
+                         "INSERT INTO client_changes (op, client_id, row) SELECT 'insert', c.id, %s FROM clients c ORDER BY c.id;",
+                         joined_row);
+    }
+    snprintf(sql + used, sql_size - used, "COMMIT;");
+
+    int ok = db_execute(sql, NULL, NULL);
+    if (!ok) db_execute("ROLLBACK;", NULL, NULL);
+    free(sql);
+    return ok;
+}
+
+int tail_client_changes(sqlite3_int64 from_seq) {
+    sqlite3_stmt *purged_stmt = NULL, *batch_stmt = NULL, *version_stmt = NULL;
+    sqlite3_int64 purged_through = 0;
+    if (sqlite3_prepare_v2(db, "SELECT purged_through FROM client_changes_state WHERE id = 1;", -1, &purged_stmt, NULL) == SQLITE_OK &&
+        sqlite3_step(purged_stmt) == SQLITE_ROW) {
+        purged_through = sqlite3_column_int64(purged_stmt, 0);
+    }
+    sqlite3_finalize(purged_stmt);
+    if (from_seq < purged_through) {
+        fprintf(stderr, "Deletions up to sequence %lld have been compacted away; reload the customers and tail from %lld.\n",
+                (long long)purged_through, (long long)purged_through);
+        return 2;
+    }
+
+    const char *sql_batch =
+        "SELECT seq, json_object('seq', seq, 'op', op, 'client_id', client_id, 'changed_at', changed_at, 'row', json(row)) "
+        "FROM client_changes WHERE seq > ?1 ORDER BY seq LIMIT ?2;";
+    if (sqlite3_prepare_v2(db, sql_batch, -1, &batch_stmt, NULL) != SQLITE_OK ||
+        sqlite3_prepare_v2(db, "PRAGMA data_version;", -1, &version_stmt, NULL) != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare change log queries: %s\n", sqlite3_errmsg(db));
+        sqlite3_finalize(batch_stmt);
+        sqlite3_finalize(version_stmt);
+        return 1;
+    }
+
+    int status = 0;
+    int wait_ms = TAIL_POLL_MIN_MS;
+    sqlite3_int64 last_version = -1;
+    while (!exit_requested) {
+        int rows = 0, rc;
+        sqlite3_bind_int64(batch_stmt, 1, from_seq);
+        sqlite3_bind_int(batch_stmt, 2, TAIL_BATCH_ROWS);
+        while ((rc = sqlite3_step(batch_stmt)) == SQLITE_ROW) {
+            from_seq = sqlite3_column_int64(batch_stmt, 0);
+            fputs((const char*)sqlite3_column_text(batch_stmt, 1), stdout);
+            fputc('\n', stdout);
+            rows++;
+        }
+        sqlite3_reset(batch_stmt);
+        if (rc != SQLITE_DONE && rc != SQLITE_BUSY) {
+            fprintf(stderr, "Failed to read the change log: %s\n", sqlite3_errmsg(db));
+            status = 1;
+            break;
+        }
+        if (rows > 0) {
+            if (fflush(stdout) != 0) break; // The consumer went away.
+            wait_ms = TAIL_POLL_MIN_MS;
+            if (rows == TAIL_BATCH_ROWS) continue;
+        }
+
+        // Caught up: wait for another connection to commit, backing off while the database stays idle.
+        while (!exit_requested) {
+            sqlite3_int64 version = last_version;
+            if (sqlite3_step(version_stmt) == SQLITE_ROW) version = sqlite3_column_int64(version_stmt, 0);
+            sqlite3_reset(version_stmt);
+            if (version != last_version) { last_version = version; break; }
+            sqlite3_sleep(wait_ms);
+            if (wait_ms < TAIL_POLL_MAX_MS) wait_ms = wait_ms * 2 > TAIL_POLL_MAX_MS ? TAIL_POLL_MAX_MS : wait_ms * 2;
+        }
+    }
+
+    sqlite3_finalize(batch_stmt);
+    sqlite3_finalize(version_stmt);
+    return status;
+}
+
+// Consumers that stay less than retain_days behind still see every change; anyone further behind converges to
+// the current rows but may have missed deletions, which tail_client_changes detects through purged_through.
+int compact_client_changes(int retain_days) {
+    const char *sql_purge_mark =
+        "UPDATE client_changes_state SET purged_through = max(purged_through, coalesce(("
+        "SELECT max(seq) FROM client_changes WHERE op = 'delete' "
+        "AND changed_at < strftime('%Y-%m-%dT%H:%M:%fZ', 'now', '-' || ?1 || ' days')), 0));";
+    const char *sql_compact =
+        "DELETE FROM client_changes WHERE changed_at < strftime('%Y-%m-%dT%H:%M:%fZ', 'now', '-' || ?1 || ' days') "
+        "AND (op = 'delete' OR EXISTS (SELECT 1 FROM client_changes later "
+        "WHERE later.client_id = client_changes.client_id AND later.seq > client_changes.seq));";
+    const char *steps[] = { sql_purge_mark, sql_compact };
+
+    if (!db_begin_write()) return -1;
+    int removed = -1;
+    for (int i = 0; i < 2; ++i) {
+        sqlite3_stmt *stmt = NULL;
+        int rc = sqlite3_prepare_v2(db, steps[i], -1, &stmt, NULL);
+        if (rc == SQLITE_OK) {
+            sqlite3_bind_int(stmt, 1, retain_days);
+            rc = sqlite3_step(stmt);
+        }
+        sqlite3_finalize(stmt);
+        if (rc != SQLITE_DONE) {
+            fprintf(stderr, "Change log compaction failed: %s\n", sqlite3_errmsg(db));
+            db_execute("ROLLBACK;", NULL, NULL);
+            return -1;
+        }
+        removed = sqlite3_changes(db);
+    }
+    if (!db_execute("COMMIT;", NULL, NULL)) {
+        db_execute("ROLLBACK;", NULL, NULL);
+        return -1;
+    }
+    return removed;
+}
+
+// --- Proximity Search ---
+// Customers are placed by their zip code: zip_locations maps codes to coordinates and client_locations, an R*Tree of
+// points keyed by client id, is maintained by triggers on both tables, so writes from any program keep it current.
+int init_zip_locations() {
+    bool new_index = !check_column_exists("client_locations", "min_lat");
+    char sql[4096];
+    int used = snprintf(sql, sizeof(sql),
+        "BEGIN IMMEDIATE;"
+        "CREATE TABLE IF NOT EXISTS \"zip_locations\" ("
+        "\"zip_code\"	TEXT PRIMARY KEY,"
+        "\"latitude\"	REAL NOT NULL CHECK(\"latitude\" BETWEEN -90 AND 90),"
+        "\"longitude\"	REAL NOT NULL CHECK(\"longitude\" BETWEEN -180 AND 180)"
+        ") WITHOUT ROWID;"
+        "CREATE VIRTUAL TABLE IF NOT EXISTS \"client_locations\" USING rtree(id, min_lat, max_lat, min_lon, max_lon);"
+        "CREATE INDEX IF NOT EXISTS \"idx_clients_zip_code\" ON \"clients\" (\"zip_code\");"
+        "CREATE TRIGGER IF NOT EXISTS \"clients_location_insert\" AFTER INSERT ON \"clients\" BEGIN "
+        "INSERT INTO client_locations SELECT NEW.id, latitude, latitude, longitude, longitude FROM zip_locations WHERE zip_code = NEW.zip_code; END;"
+        "CREATE TRIGGER IF NOT EXISTS \"clients_location_update\" AFTER UPDATE OF \"zip_code\" ON \"clients\" BEGIN "
+        "DELETE FROM client_locations WHERE id = OLD.id;"
+        "INSERT INTO client_locations SELECT NEW.id, latitude, latitude, longitude, longitude FROM zip_locations WHERE zip_code = NEW.zip_code; END;"
+        "CREATE TRIGGER IF NOT EXISTS \"clients_location_delete\" AFTER DELETE ON \"clients\" BEGIN "
+        "DELETE FROM client_locations WHERE id = OLD.id; END;"
+        "CREATE TRIGGER IF NOT EXISTS \"zip_locations_insert\" AFTER INSERT ON \"zip_locations\" BEGIN "
+        "INSERT OR REPLACE INTO client_locations SELECT id, NEW.latitude, NEW.latitude, NEW.longitude, NEW.longitude FROM clients WHERE zip_code = NEW.zip_code; END;"
+        "CREATE TRIGGER IF NOT EXISTS \"zip_locations_update\" AFTER UPDATE ON \"zip_locations\" BEGIN "
+        "DELETE FROM client_locations WHERE id IN (SELECT id FROM clients WHERE zip_code = OLD.zip_code);"
+        "INSERT OR REPLACE INTO client_locations SELECT id, NEW.latitude, NEW.latitude, NEW.longitude, NEW.longitude FROM clients WHERE zip_code = NEW.zip_code; END;"
+        "CREATE TRIGGER IF NOT EXISTS \"zip_locations_delete\" AFTER DELETE ON \"zip_locations\" BEGIN "
+        "DELETE FROM client_locations WHERE id IN (SELECT id FROM clients WHERE zip_code = OLD.zip_code); END;");
+    if (new_index) {
+        // A database created before proximity search may already hold coordinates: index its customers once.
+        used += snprintf(sql + used, sizeof(sql) - used,
+                         "INSERT INTO client_locations SELECT c.id, z.latitude, z.latitude, z.longitude, z.longitude "
+                         "FROM clients c JOIN zip_locations z ON z.zip_code = c.zip_code;");
+    }
+    snprintf(sql + used, sizeof(sql) - used, "COMMIT;");
+
+    int ok = db_execute(sql, NULL, NULL);
+    if (!ok) db_execute("ROLLBACK;", NULL, NULL);
+    return ok;
+}
+
+void sql_distance_km(sqlite3_context *ctx, int argc, sqlite3_value **argv) {
+    double deg[4];
+    for (int i = 0; i < argc; ++i) {
+        if (sqlite3_value_type(argv[i]) == SQLITE_NULL) { sqlite3_result_null(ctx); return; }
+        deg[i] = sqlite3_value_double(argv[i]) * M_PI / 180.0;
+    }
+    // Haversine formula on a spherical earth; good to about 0.5% for sales territories.
+    double sin_dlat = sin((deg[2] - deg[0]) / 2), sin_dlon = sin((deg[3] - deg[1]) / 2);
+    double a = sin_dlat * sin_dlat + cos(deg[0]) * cos(deg[2]) * sin_dlon * sin_dlon;
+    sqlite3_result_double(ctx, 2 * EARTH_RADIUS_KM * asin(sqrt(a > 1 ? 1 : a)));
+}
+
+long long import_zip_file(sqlite3 *conn, FILE *fp, long long *skipped_out) {
+    sqlite3_stmt *stmt = NULL;
+    if (sqlite3_prepare_v2(conn, "INSERT INTO zip_locations (zip_code, latitude, longitude) VALUES (?1, ?2, ?3) "
+                                 "ON CONFLICT(zip_code) DO UPDATE SET latitude = excluded.latitude, longitude = excluded.longitude;",
+                           -1, &stmt, NULL) != SQLITE_OK) {
+        fprintf(stderr, "Cannot prepare zip code import: %s\n", sqlite3_errmsg(conn));
+        return -1;
+    }
+
+    // Lines are "zip,latitude,longitude"; fields may be quoted, and lines that do not parse (such as a header) are skipped.
+    char line[MAX_STR_LEN];
+    long long loaded = 0, skipped = 0, line_no = 0;
+    int rc = sqlite3_exec(conn, "BEGIN IMMEDIATE;", NULL, NULL, NULL);
+    while (rc == SQLITE_OK && fgets(line, sizeof(line), fp)) {
+        line_no++;
+        char *fields[3] = { NULL, NULL, NULL };
+        int field_count = 0;
+        for (char *p = line; field_count < 3; ) {
+            while (*p == ' ' || *p == '"') p++;
+            fields[field_count++] = p;
+            char *end = strchr(p, ',');
+            char *stop = end ? end : p + strcspn(p, "\r\n");
+            char *trim = stop;
+            while (trim > p && (trim[-1] == ' ' || trim[-1] == '"')) trim--;
+            bool more = end != NULL;
+            *trim = '\0';
+            if (!more) break;
+            p = end + 1;
+        }
+        char *lat_end = NULL, *lon_end = NULL;
+        double lat = field_count == 3 ? strtod(fields[1], &lat_end) : 0;
+        double lon = field_count == 3 ? strtod(fields[2], &lon_end) : 0;
+        if (field_count != 3 || fields[0][0] == '\0' || lat_end == fields[1] || *lat_end != '\0' || lon_end == fields[2] || *lon_end != '\0' ||
+            lat < -90 || lat > 90 || lon < -180 || lon > 180) {
+            bool blank = field_count == 1 && fields[0][0] == '\0';
+            if (line_no > 1 && !blank) skipped++; // The first line may be a header.
+            continue;
+        }
+        sqlite3_bind_text(stmt, 1, fields[0], -1, SQLITE_STATIC);
+        sqlite3_bind_double(stmt, 2, lat);
+        sqlite3_bind_double(stmt, 3, lon);
+        if (sqlite3_step(stmt) != SQLITE_DONE) rc = sqlite3_errcode(conn);
+        sqlite3_reset(stmt);
+        if (rc == SQLITE_OK) loaded++;
+    }
+    sqlite3_finalize(stmt);
+    if (rc != SQLITE_OK) {
+        fprintf(stderr, "Zip code import failed at line %lld: %s\n", line_no, sqlite3_errmsg(conn));
+        sqlite3_exec(conn, "ROLLBACK;", NULL, NULL, NULL);
+        return -1;
+    }
+    if (sqlite3_exec(conn, "COMMIT;", NULL, NULL, NULL) != SQLITE_OK) {
+        fprintf(stderr, "Zip code import failed: %s\n", sqlite3_errmsg(conn));
+        sqlite3_exec(conn, "ROLLBACK;", NULL, NULL, NULL);
+        return -1;
+    }
+    *skipped_out = skipped;
+    return loaded;
+}
+
+long long import_zip_locations(const char *path) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        fprintf(stderr, "Cannot open '%s': %s\n", path, strerror(errno));
+        return -1;
+    }
+    // Every database indexes its own customers from its own zip_locations, so each one gets the whole file.
+    long long loaded = 0, skipped = 0;
+    for (int i = 0; i < shard_count && loaded >= 0; ++i) {
+        rewind(fp);
+        loaded = import_zip_file(shards[i].conn, fp, &skipped);
+        if (loaded < 0 && shard_count > 1) fprintf(stderr, "Zip codes were not loaded into '%s'%s.\n", shards[i].path,
+                                                    i > 0 ? " (the databases before it were updated)" : "");
+    }
+    fclose(fp);
+    if (loaded >= 0 && skipped > 0) fprintf(stderr, "Skipped %lld lines that are not zip,latitude,longitude.\n", skipped);
+    query_cache_clear();
+    return loaded;
+}
+
+// --- Columnar Snapshot Export ---
+int snapshot_buffer_append(SnapshotBuffer *buf, const void *data, size_t len) {
+    if (buf->len + len > buf->cap) {
+        size_t new_cap = buf->cap ? buf->cap : 4096;
+        while (new_cap < buf->len + len) new_cap *= 2;
+        uint8_t *new_data = realloc(buf->data, new_cap);
+        if (!new_data) return 0;
+        buf->data = new_data;
+        buf->cap = new_cap;
+    }
+    if (len) memcpy(buf->data + buf->len, data, len);
+    buf->len += len;
+    return 1;
+}
+
+int snapshot_dict_code(SnapshotColumn *col, const char *value, size_t len, uint32_t *code) {
+    if ((uint64_t)(col->dict_count + 1) * 2 > col->dict_slot_count) {
+        uint32_t new_count = col->dict_slot_count ? col->dict_slot_count * 2 : 256;
+        uint32_t *new_slots = calloc(new_count, sizeof(uint32_t));
+        if (!new_slots) return 0;
+        const uint64_t *offsets = (const uint64_t*)col->dict_offsets.data;
+        for (uint32_t c = 0; c < col->dict_count; ++c) {
+            uint32_t h = 2166136261u;
+            for (uint64_t k = offsets[c]; k < offsets[c + 1]; ++k) h = (h ^ col->bytes.data[k]) * 16777619u;
+            while (new_slots[h & (new_count - 1)]) h++;
+            new_slots[h & (new_count - 1)] = c + 1;
+        }
+        free(col->dict_slots);
+        col->dict_slots = new_slots;
+        col->dict_slot_count = new_count;
+    }
+
+    uint32_t h = 2166136261u; // FNV-1a
+    for (size_t k = 0; k < len; ++k) h = (h ^ (uint8_t)value[k]) * 16777619u;
+    for (;; h++) {
+        uint32_t slot = col->dict_slots[h & (col->dict_slot_count - 1)];
+        if (slot == 0) break;
+        const uint64_t *offsets = (const uint64_t*)col->dict_offsets.data;
+        if (offsets[slot] - offsets[slot - 1] == len && memcmp(col->bytes.data + offsets[slot - 1], value, len) == 0) {
+            *code = slot - 1;
+            return 1;
+        }
+    }
+
+    if (col->dict_count == 0) {
+        uint64_t zero = 0;
+        if (!snapshot_buffer_append(&col->dict_offsets, &zero, sizeof(zero))) return 0;
+    }
+    if (!snapshot_buffer_append(&col->bytes, value, len)) return 0;
+    uint64_t end = col->bytes.len;
+    if (!snapshot_buffer_append(&col->dict_offsets, &end, sizeof(end))) return 0;
+    col->dict_slots[h & (col->dict_slot_count - 1)] = col->dict_count + 1;
+    *code = col->dict_count++;
+    return 1;
+}
+
+// Builds every column in memory from one pass over clients, then writes the file under a temporary name and
+// renames it into place, so readers never map a half-written snapshot.
+long long export_columnar_snapshot(const char *path) {
+    SnapshotColumn columns[] = {
+        { .name = "id",             .sql = "id",                                         .type = GXS_TYPE_INT64 },
+        { .name = "num_employees",  .sql = "num_employees",                              .type = GXS_TYPE_INT32 },
+        { .name = "created_at",     .sql = "CAST(strftime('%s', created_at) AS INTEGER)", .type = GXS_TYPE_INT64 },
+        { .name = "status",         .sql = "status",                                     .type = GXS_TYPE_DICT },
+        { .name = "city",           .sql = "(SELECT name FROM cities WHERE id = city_id)", .type = GXS_TYPE_DICT },
+        { .name = "country",        .sql = "(SELECT name FROM countries WHERE id = country_id)", .type = GXS_TYPE_DICT },
+        { .name = "business_name",  .sql = "business_name",                              .type = GXS_TYPE_STRING },
+        { .name = "email",          .sql = "email",                                      .type = GXS_TYPE_STRING },
+        { .name = "phone",          .sql = "phone",                                      .type = GXS_TYPE_STRING },
+        { .name = "website",        .sql = "website",                                    .type = GXS_TYPE_STRING },
+        { .name = "street",         .sql = "street",                                     .type = GXS_TYPE_STRING },
+        { .name = "state",          .sql = "(SELECT name FROM states WHERE id = state_id)", .type = GXS_TYPE_STRING },
+        { .name = "zip_code",       .sql = "zip_code",                                   .type = GXS_TYPE_STRING },
+        { .name = "tax_number",     .sql = "tax_number",                                 .type = GXS_TYPE_STRING },
+        { .name = "industry",       .sql = "(SELECT name FROM industries WHERE id = industry_id)", .type = GXS_TYPE_STRING },
+        { .name = "contact_person", .sql = "contact_person",                             .type = GXS_TYPE_STRING },
+        { .name = "contact_email",  .sql = "contact_email",                              .type = GXS_TYPE_STRING },
+        { .name = "contact_phone",  .sql = "contact_phone",                              .type = GXS_TYPE_STRING },
+    };
+    const int n_columns = sizeof(columns) / sizeof(columns[0]);
+    long long rows = -1;
+    uint64_t row_count = 0;
+    sqlite3_stmt *stmt = NULL;
+    FILE *out = NULL;
+    char tmp_path[MAX_STR_LEN + 8];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+    char sql[2048] = "SELECT ";
+    for (int i = 0; i < n_columns; ++i) {
+        strncat(sql, columns[i].sql, sizeof(sql) - strlen(sql) - 1);
+        strncat(sql, i + 1 < n_columns ? ", " : " FROM clients ORDER BY id;", sizeof(sql) - strlen(sql) - 1);
+    }
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK) {
+        fprintf(stderr, "Failed to prepare snapshot query: %s\n", sqlite3_errmsg(db));
+        goto cleanup;
+    }
+
+    uint64_t zero_offset = 0;
+    for (int i = 0; i < n_columns; ++i) {
+        if (columns[i].type == GXS_TYPE_STRING && !snapshot_buffer_append(&columns[i].data, &zero_offset, sizeof(zero_offset))) goto out_of_memory;
+    }
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        for (int i = 0; i < n_columns; ++i) {
+            SnapshotColumn *col = &columns[i];
+            int ok = 1;
+            if (col->type == GXS_TYPE_INT64) {
+                int64_t v = sqlite3_column_int64(stmt, i);
+                ok = snapshot_buffer_append(&col->data, &v, sizeof(v));
+            } else if (col->type == GXS_TYPE_INT32) {
+                int32_t v = sqlite3_column_int(stmt, i);
+                ok = snapshot_buffer_append(&col->data, &v, sizeof(v));
+            } else {
+                const char *text = (const char*)sqlite3_column_text(stmt, i);
+                size_t len = text ? (size_t)sqlite3_column_bytes(stmt, i) : 0;
+                if (col->type == GXS_TYPE_DICT) {
+                    uint32_t code;
+                    ok = snapshot_dict_code(col, text ? text : "", len, &code) && snapshot_buffer_append(&col->data, &code, sizeof(code));
+                } else {
+                    uint64_t end = col->bytes.len + len;
+                    ok = snapshot_buffer_append(&col->bytes, text, len) && snapshot_buffer_append(&col->data, &end, sizeof(end));
+                }
+            }
+            if (!ok) goto out_of_memory;
+        }
+        row_count++;
+    }
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "Failed to read customers for the snapshot: %s\n", sqlite3_errmsg(db));
+        goto cleanup;
+    }
+
+    GxsHeader header;
+    GxsColumn directory[sizeof(columns) / sizeof(columns[0])];
+    memset(&header, 0, sizeof(header));
+    memset(directory, 0, sizeof(directory));
+    uint64_t offset = sizeof(GxsHeader) + sizeof(directory);
+    for (int i = 0; i < n_columns; ++i) {
+        SnapshotColumn *col = &columns[i];
+        GxsColumn *entry = &directory[i];
+        strncpy(entry->name, col->name, GXS_COLUMN_NAME_LEN - 1);
+        entry->type = col->type;
+        entry->dict_count = col->dict_count;
+        if (col->type == GXS_TYPE_DICT && col->dict_count == 0) {
+            if (!snapshot_buffer_append(&col->dict_offsets, &zero_offset, sizeof(zero_offset))) goto out_of_memory;
+        }
+        entry->data_offset = offset;
+        entry->data_size = col->data.len;
+        offset = (offset + entry->data_size + 7) & ~(uint64_t)7;
+        if (col->type == GXS_TYPE_DICT || col->type == GXS_TYPE_STRING) {
+            entry->aux_offset = offset;
+            entry->aux_size = col->dict_offsets.len + col->bytes.len;
+            offset = (offset + entry->aux_size + 7) & ~(uint64_t)7;
+        }
+    }
+    memcpy(header.magic, GXS_MAGIC, sizeof(header.magic));
+    header.version = GXS_VERSION;
+    header.column_count = n_columns;
+    header.byte_order_mark = GXS_BYTE_ORDER_MARK;
+    header.row_count = row_count;
+    header.created_at = (int64_t)time(NULL);
+    header.file_size = offset;
+
+    out = fopen(tmp_path, "wb");
+    if (!out) {
+        fprintf(stderr, "Cannot create '%s': %s\n", tmp_path, strerror(errno));
+        goto cleanup;
+    }
+    static const uint8_t padding[8] = {0};
+    bool written = fwrite(&header, sizeof(header), 1, out) == 1 && fwrite(directory, sizeof(directory), 1, out) == 1;
+    for (int i = 0; i < n_columns && written; ++i) {
+        SnapshotColumn *col = &columns[i];
+        written = fwrite(col->data.data, 1, col->data.len, out) == col->data.len &&
+                  fwrite(padding, 1, (8 - col->data.len % 8) % 8, out) == (8 - col->data.len % 8) % 8;
+        if (written && directory[i].aux_offset) {
+            size_t aux_len = col->dict_offsets.len + col->bytes.len;
+            written = fwrite(col->dict_offsets.data, 1, col->dict_offsets.len, out) == col->dict_offsets.len &&
+                      fwrite(col->bytes.data, 1, col->bytes.len, out) == col->bytes.len &&
+                      fwrite(padding, 1, (8 - aux_len % 8) % 8, out) == (8 - aux_len % 8) % 8;
+        }
+    }
+    if (fclose(out) != 0) written = false;
+    out = NULL;
+    if (!written || rename(tmp_path, path) != 0) {
+        fprintf(stderr, "Failed to write snapshot '%s': %s\n", path, strerror(errno));
+        remove(tmp_path);
+        goto cleanup;
+    }
+    rows = (long long)row_count;
+    goto cleanup;
+
+out_of_memory:
+    fprintf(stderr, "Out of memory while building the snapshot.\n");
+cleanup:
+    if (out) { fclose(out); remove(tmp_path); }
+    sqlite3_finalize(stmt);
+    for (int i = 0; i < n_columns; ++i) {
+        free(columns[i].data.data);
+        free(columns[i].bytes.data);
+        free(columns[i].dict_offsets.data);
+        free(columns[i].dict_slots);
+    }
+    return rows;
+}
+
+// --- Duplicate Detection ---
+// Comparing every pair of customers is quadratic, so candidates are grouped by blocking keys (normalized name, email
+// domain, trailing phone digits) and each customer is only scored against its next DUP_BLOCK_WINDOW neighbours in
+// name order within a block. Blocks are scored on a thread pool; matches are joined into clusters with union-find.
+size_t normalize_business_name(const char *name, char *out, size_t size) {
+    static const char *legal_forms[] = {
+        "ltd", "limited", "inc", "incorporated", "llc", "llp", "plc", "corp", "corporation", "co", "company",
+        "gmbh", "ag", "kg", "sa", "sl", "slu", "srl", "spa", "bv", "nv", "sas", "sarl", "oy", "ab", "pty"
+    };
+    char folded[MAX_STR_LEN];
+    struct { size_t start, end; } tokens[32];
+    int token_count = 0;
+    size_t len = 0;
+    bool in_token = false;
+    for (const unsigned char *p = (const unsigned char*)name; *p && len + 4 < sizeof(folded); ) {
+        if (*p < 0x80 && !isalnum(*p)) { in_token = false; p++; continue; }
+        if (!in_token) {
+            if (token_count < 32) tokens[token_count++].start = len;
+            in_token = true;
+        }
+        if (*p < 0x80) {
+            folded[len++] = tolower(*p++);
+        } else if ((*p & 0xE0) == 0xC0 && (p[1] & 0xC0) == 0x80) {
+            // Two-byte letters: Latin-1 and Latin Extended-A capitals are folded without depending on the locale.
+            unsigned int cp = ((p[0] & 0x1Fu) << 6) | (p[1] & 0x3Fu);
+            if (cp >= 0xC0 && cp <= 0xDE && cp != 0xD7) cp += 0x20;
+            else if ((cp >= 0x100 && cp <= 0x137) || (cp >= 0x14A && cp <= 0x177)) cp |= 1;
+            else if ((cp >= 0x139 && cp <= 0x148) || (cp >= 0x179 && cp <= 0x17E)) cp += cp & 1;
+            folded[len++] = (char)(0xC0 | (cp >> 6));
+            folded[len++] = (char)(0x80 | (cp & 0x3F));
+            p += 2;
+        } else {
+            folded[len++] = (char)*p++;
+        }
+        tokens[token_count - 1].end = len;
+    }
+    // Runs of single letters are initials ("A.C.M.E.", "S.L."): they are joined into one token.
+    int merged = 0;
+    for (int i = 0; i < token_count; ++i) {
+        bool single = tokens[i].end - tokens[i].start == 1 && isalpha((unsigned char)folded[tokens[i].start]);
+        if (single && i > 0 && tokens[i - 1].end - tokens[i - 1].start == 1 && isalpha((unsigned char)folded[tokens[i - 1].start])) {
+            tokens[merged - 1].end = tokens[i].end;
+        } else {
+            tokens[merged++] = tokens[i];
+        }
+    }
+    token_count = merged;
+    int first = 0;
+    #define TOKEN_IS(t, word) (tokens[t].end - tokens[t].start == strlen(word) && memcmp(folded + tokens[t].start, word, strlen(word)) == 0)
+    if (token_count > 1 && TOKEN_IS(0, "the")) first = 1;
+    for (bool dropped = true; dropped && token_count - first > 1; ) {
+        dropped = false;
+        for (size_t k = 0; k < sizeof(legal_forms) / sizeof(legal_forms[0]); ++k) {
+            if (TOKEN_IS(token_count - 1, legal_forms[k])) { token_count--; dropped = true; break; }
+        }
+    }
+    size_t out_len = 0;
+    for (int i = first; i < token_count; ++i) {
+        if (token_count - first > 1 && TOKEN_IS(i, "and")) continue;
+        size_t token_len = tokens[i].end - tokens[i].start;
+        if (out_len + token_len >= size) token_len = size - 1 - out_len;
+        memcpy(out + out_len, folded + tokens[i].start, token_len);
+        out_len += token_len;
+    }
+    #undef TOKEN_IS
+    out[out_len] = '\0';
+    return out_len;
+}
+
+double jaro_winkler(const char *a, const char *b) {
+    int len_a = strlen(a), len_b = strlen(b);
+    if (len_a == 0 || len_b == 0) return 0.0;
+    if (len_a == len_b && memcmp(a, b, len_a) == 0) return 1.0;
+    if (len_a > DUP_KEY_LEN) len_a = DUP_KEY_LEN;
+    if (len_b > DUP_KEY_LEN) len_b = DUP_KEY_LEN;
+    bool a_matched[DUP_KEY_LEN] = { false }, b_matched[DUP_KEY_LEN] = { false };
+    int range = (len_a > len_b ? len_a : len_b) / 2 - 1;
+    if (range < 0) range = 0;
+    int matches = 0;
+    for (int i = 0; i < len_a; ++i) {
+        int lo = i > range ? i - range : 0, hi = i + range + 1 < len_b ? i + range + 1 : len_b;
+        for (int j = lo; j < hi; ++j) {
+            if (!b_matched[j] && a[i] == b[j]) { a_matched[i] = b_matched[j] = true; matches++; break; }
+        }
+    }
+    if (matches == 0) return 0.0;
+    int transpositions = 0;
+    for (int i = 0, j = 0; i < len_a; ++i) {
+        if (!a_matched[i]) continue;
+        while (!b_matched[j]) j++;
+        if (a[i] != b[j++]) transpositions++;
+    }
+    double m = matches;
+    double jaro = (m / len_a + m / len_b + (m - transpositions / 2.0) / m) / 3.0;
+    int prefix = 0;
+    while (prefix < 4 && prefix < len_a && prefix < len_b && a[prefix] == b[prefix]) prefix++;
+    return jaro + prefix * 0.1 * (1.0 - jaro);
+}
+
+double score_duplicate_pair(const DupRecord *a, const DupRecord *b, const char *arena) {
+    const char *name_a = arena + a->name, *name_b = arena + b->name;
+    // Numbers in names tell branches and series apart ("Store 12", "Store 13"), so they must agree.
+    for (const char *digit_a = name_a, *digit_b = name_b; ; ++digit_a, ++digit_b) {
+        while (*digit_a && !isdigit((unsigned char)*digit_a)) digit_a++;
+        while (*digit_b && !isdigit((unsigned char)*digit_b)) digit_b++;
+        if (*digit_a != *digit_b) return 0.0;
+        if (*digit_a == '\0') break;
+    }
+    // Names that only differ in case, punctuation or legal form normalize to the same text; any other difference
+    // (a typo, or another company with a similar name) needs a matching email or phone to reach DUP_MATCH_SCORE.
+    double score = strcmp(name_a, name_b) == 0 ? 1.0 : jaro_winkler(name_a, name_b) - DUP_NAME_MISMATCH_PENALTY;
+    if (arena[a->email] && strcmp(arena + a->email, arena + b->email) == 0) score += DUP_CONTACT_BONUS;
+    if (arena[a->phone] && strcmp(arena + a->phone, arena + b->phone) == 0) score += DUP_CONTACT_BONUS;
+    return score > 1.0 ? 1.0 : score;
+}
+
+void *duplicate_score_worker(void *arg) {
+    DupScoreWorker *worker = arg;
+    DupScoreJob *job = worker->job;
+    for (;;) {
+        pthread_mutex_lock(&job->lock);
+        uint32_t first = job->next_block;
+        uint32_t last = job->block_count - first > DUP_BLOCKS_PER_GRAB ? first + DUP_BLOCKS_PER_GRAB : job->block_count;
+        job->next_block = last;
+        pthread_mutex_unlock(&job->lock);
+        if (first >= last) return NULL;
+
+        for (uint32_t block = first; block < last; ++block) {
+            uint32_t start = job->blocks[2 * block], end = job->blocks[2 * block + 1];
+            for (uint32_t i = start; i < end; ++i) {
+                uint32_t stop = end - i > DUP_BLOCK_WINDOW ? i + 1 + DUP_BLOCK_WINDOW : end;
+                for (uint32_t j = i + 1; j < stop; ++j) {
+                    uint32_t a = job->keys[i].record, b = job->keys[j].record;
+                    if (a == b) continue;
+                    worker->compared++;
+                    double score = score_duplicate_pair(&job->records[a], &job->records[b], job->arena);
+                    if (score < DUP_MATCH_SCORE) continue;
+                    if (worker->count == worker->cap) {
+                        size_t new_cap = worker->cap ? worker->cap * 2 : 1024;
+                        DupPair *new_pairs = realloc(worker->pairs, new_cap * sizeof(DupPair));
+                        if (!new_pairs) { worker->failed = true; return NULL; }
+                        worker->pairs = new_pairs;
+                        worker->cap = new_cap;
+                    }
+                    worker->pairs[worker->count++] = (DupPair){ a, b, (float)score };
+                }
+            }
+        }
+    }
+}
+
+uint64_t dup_key_hash(char kind, const char *text) {
+    uint64_t hash = 14695981039346656037ULL;
+    hash = (hash ^ (unsigned char)kind) * 1099511628211ULL;
+    for (const unsigned char *p = (const unsigned char*)text; *p; ++p) hash = (hash ^ *p) * 1099511628211ULL;
+    return hash;
+}
+
+int compare_dup_keys(const void *a, const void *b) {
+    const DupKey *ka = a, *kb = b;
+    if (ka->hash != kb->hash) return ka->hash < kb->hash ? -1 : 1;
+    return ka->record < kb->record ? -1 : ka->record > kb->record;
+}
+
+int compare_dup_members(const void *a, const void *b) {
+    const DupMember *ma = a, *mb = b;
+    if (ma->root != mb->root) return ma->root < mb->root ? -1 : 1;
+    if (ma->filled != mb->filled) return mb->filled - ma->filled; // The fullest record leads its cluster.
+    return ma->id < mb->id ? -1 : ma->id > mb->id;
+}
+
+uint32_t dup_find_root(uint32_t *parent, uint32_t i) {
+    while (parent[i] != i) i = parent[i] = parent[parent[i]];
+    return i;
+}
+
+long long find_duplicate_clusters(const char *path) {
+    struct timespec started, finished;
+    clock_gettime(CLOCK_MONOTONIC, &started);
+    const char *sql =
+        "SELECT id, business_name, lower(coalesce(email, '')), coalesce(phone, ''), "
+        "(coalesce(email, '') <> '') + (coalesce(phone, '') <> '') + (coalesce(website, '') <> '') + "
+        "(coalesce(street, '') <> '') + (city_id IS NOT NULL) + (coalesce(zip_code, '') <> '') + "
+        "(country_id IS NOT NULL) + (coalesce(tax_number, '') <> '') + (industry_id IS NOT NULL) + "
+        "(coalesce(contact_person, '') <> '') + (coalesce(contact_email, '') <> '') + (coalesce(contact_phone, '') <> '') + "
+        "(num_employees > 0) + EXISTS (SELECT 1 FROM client_notes WHERE client_id = clients.id) "
+        "FROM clients ORDER BY business_name;";
+    sqlite3_stmt *stmt = NULL;
+    DupRecord *records = NULL;
+    DupKey *keys = NULL;
+    uint32_t *blocks = NULL, *parent = NULL;
+    float *cluster_score = NULL;
+    DupMember *members = NULL;
+    DupScoreWorker *workers = NULL;
+    SnapshotBuffer arena = { NULL, 0, 0 };
+    FILE *out = NULL;
+    bool reported = false;              // Whether the failure was already reported (otherwise memory ran out).
+    size_t record_count = 0, record_cap = 0, key_count = 0, member_count = 0;
+    long long clusters = -1, compared = 0;
+    int thread_count = 0;
+    uint32_t block_count = 0;
+
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) != SQLITE_OK) {
+        fprintf(stderr, "Cannot read customers: %s\n", sqlite3_errmsg(db));
+        return -1;
+    }
+    if (!snapshot_buffer_append(&arena, "", 1)) goto done; // Offset 0 is the empty string.
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        if (record_count == record_cap) {
+            size_t new_cap = record_cap ? record_cap * 2 : 4096;
+            DupRecord *new_records = realloc(records, new_cap * sizeof(DupRecord));
+            if (!new_records) goto done;
+            records = new_records;
+            record_cap = new_cap;
+        }
+        DupRecord *r = &records[record_count];
+        char name[DUP_KEY_LEN], digits[DUP_PHONE_DIGITS + 1];
+        const char *email = (const char*)sqlite3_column_text(stmt, 2), *phone = (const char*)sqlite3_column_text(stmt, 3);
+        const char *raw_name = (const char*)sqlite3_column_text(stmt, 1);
+        size_t name_len = normalize_business_name(raw_name ? raw_name : "", name, sizeof(name));
+        size_t digit_count = 0;
+        for (const char *p = phone ? phone : ""; *p; ++p) {
+            if (!isdigit((unsigned char)*p)) continue;
+            if (digit_count == DUP_PHONE_DIGITS) { memmove(digits, digits + 1, DUP_PHONE_DIGITS - 1); digit_count--; }
+            digits[digit_count++] = *p;
+        }
+        digits[digit_count >= DUP_PHONE_MIN_DIGITS ? digit_count : 0] = '\0';
+        r->id = sqlite3_column_int(stmt, 0);
+        r->filled = sqlite3_column_int(stmt, 4);
+        r->name = r->email = r->phone = 0;
+        if (name_len > 0) { r->name = arena.len; if (!snapshot_buffer_append(&arena, name, name_len + 1)) goto done; }
+        if (email && *email) { r->email = arena.len; if (!snapshot_buffer_append(&arena, email, strlen(email) + 1)) goto done; }
+        if (digits[0]) { r->phone = arena.len; if (!snapshot_buffer_append(&arena, digits, strlen(digits) + 1)) goto done; }
+        record_count++;
+    }
+    if (rc != SQLITE_DONE) {
+        fprintf(stderr, "Cannot read customers: %s\n", sqlite3_errmsg(db));
+        reported = true;
+        goto done;
+    }
+    if (arena.len > UINT32_MAX) goto done;
+
+    keys = malloc((3 * record_count + 1) * sizeof(DupKey));
+    if (!keys) goto done;
+    const char *arena_text = (const char*)arena.data;
+    for (size_t i = 0; i < record_count; ++i) {
+        if (records[i].name) keys[key_count++] = (DupKey){ dup_key_hash('n', arena_text + records[i].name), (uint32_t)i };
+        const char *domain = records[i].email ? strchr(arena_text + records[i].email, '@') : NULL;
+        if (domain && domain[1]) keys[key_count++] = (DupKey){ dup_key_hash('d', domain + 1), (uint32_t)i };
+        if (records[i].phone) keys[key_count++] = (DupKey){ dup_key_hash('p', arena_text + records[i].phone), (uint32_t)i };
+    }
+    qsort(keys, key_count, sizeof(DupKey), compare_dup_keys);
+    blocks = malloc((key_count + 1) * sizeof(uint32_t));
+    if (!blocks) goto done;
+    for (size_t start = 0, end; start < key_count; start = end) {
+        for (end = start + 1; end < key_count && keys[end].hash == keys[start].hash; ++end) {}
+        if (end - start < 2) continue;
+        blocks[2 * block_count] = start;
+        blocks[2 * block_count + 1] = end;
+        block_count++;
+    }
+
+    DupScoreJob job = { records, arena_text, keys, blocks, block_count, 0, PTHREAD_MUTEX_INITIALIZER };
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    thread_count = cpus < 1 ? 1 : cpus > DUP_MAX_THREADS ? DUP_MAX_THREADS : (int)cpus;
+    workers = calloc(thread_count, sizeof(DupScoreWorker));
+    if (!workers) goto done;
+    bool started_threads[DUP_MAX_THREADS];
+    for (int i = 0; i < thread_count; ++i) {
+        workers[i].job = &job;
+        started_threads[i] = pthread_create(&workers[i].thread, NULL, duplicate_score_worker, &workers[i]) == 0;
+    }
+    for (int i = 0; i < thread_count; ++i) {
+        if (started_threads[i]) pthread_join(workers[i].thread, NULL);
+        else duplicate_score_worker(&workers[i]); // Whatever is left of the queue is scored here.
+    }
+
+    parent = malloc(record_count * sizeof(uint32_t));
+    cluster_score = malloc(record_count * sizeof(float));
+    if (!parent || !cluster_score) goto done;
+    for (size_t i = 0; i < record_count; ++i) { parent[i] = i; cluster_score[i] = 1.0f; }
+    for (int w = 0; w < thread_count; ++w) {
+        if (workers[w].failed) goto done;
+        compared += workers[w].compared;
+        for (size_t i = 0; i < workers[w].count; ++i) {
+            uint32_t root_a = dup_find_root(parent, workers[w].pairs[i].a), root_b = dup_find_root(parent, workers[w].pairs[i].b);
+            if (root_a != root_b) parent[root_b] = root_a;
+        }
+    }
+    // Each cluster is labelled with the weakest pair score that joined it.
+    for (int w = 0; w < thread_count; ++w) {
+        for (size_t i = 0; i < workers[w].count; ++i) {
+            uint32_t root = dup_find_root(parent, workers[w].pairs[i].a);
+            if (workers[w].pairs[i].score < cluster_score[root]) cluster_score[root] = workers[w].pairs[i].score;
+        }
+    }
+    uint32_t *cluster_size = (uint32_t*)calloc(record_count, sizeof(uint32_t));
+    if (!cluster_size) goto done;
+    for (size_t i = 0; i < record_count; ++i) cluster_size[dup_find_root(parent, i)]++;
+    members = malloc(record_count * sizeof(DupMember));
+    if (!members) { free(cluster_size); goto done; }
+    for (size_t i = 0; i < record_count; ++i) {
+        uint32_t root = dup_find_root(parent, i);
+        if (cluster_size[root] > 1) members[member_count++] = (DupMember){ root, records[i].filled, records[i].id };
+    }
+    free(cluster_size);
+    qsort(members, member_count, sizeof(DupMember), compare_dup_members);
+
+    sqlite3_finalize(stmt);
+    stmt = NULL;
+    out = fopen(path, "w");
+    if (!out) {
+        fprintf(stderr, "Cannot write '%s': %s\n", path, strerror(errno));
+        reported = true;
+        goto done;
+    }
+    if (sqlite3_prepare_v2(db, "SELECT business_name, email, phone, (SELECT name FROM cities WHERE id = city_id) FROM clients WHERE id = ?;", -1, &stmt, NULL) != SQLITE_OK) {
+        fprintf(stderr, "Cannot read customers: %s\n", sqlite3_errmsg(db));
+        reported = true;
+        goto done;
+    }
+    fprintf(out, "# Likely duplicate customers in %s. Each cluster is merged into its first customer by --merge-duplicates.\n"
+                 "# Delete the lines of customers that are not duplicates, or move the one to keep to the top of its cluster.\n"
+                 "cluster\tscore\tid\tbusiness_name\temail\tphone\tcity\n", db_path);
+    clusters = 0;
+    for (size_t i = 0; i < member_count; ++i) {
+        if (i == 0 || members[i].root != members[i - 1].root) {
+            if (i > 0) fputc('\n', out);
+            clusters++;
+        }
+        fprintf(out, "%lld\t%.2f\t%d", clusters, cluster_score[members[i].root], members[i].id);
+        sqlite3_bind_int(stmt, 1, members[i].id);
+        bool found = sqlite3_step(stmt) == SQLITE_ROW;
+        for (int col = 0; col < 4; ++col) {
+            fputc('\t', out);
+            const unsigned char *text = found ? sqlite3_column_text(stmt, col) : NULL;
+            for (const unsigned char *p = text ? text : (const unsigned char*)""; *p; ++p) fputc(*p == '\t' || *p == '\n' || *p == '\r' ? ' ' : *p, out);
+        }
+        fputc('\n', out);
+        sqlite3_reset(stmt);
+    }
+    if (fclose(out) != 0) {
+        fprintf(stderr, "Cannot write '%s': %s\n", path, strerror(errno));
+        clusters = -1;
+        reported = true;
+    }
+    out = NULL;
+    clock_gettime(CLOCK_MONOTONIC, &finished);
+    if (clusters >= 0) {
+        fprintf(stderr, "Scored %lld candidate pairs in %u blocks of %zu customers on %d threads in %.1f s; "
+                "%lld clusters of %zu customers written to '%s'.\n", compared, block_count, record_count, thread_count,
+                (finished.tv_sec - started.tv_sec) + (finished.tv_nsec - started.tv_nsec) / 1e9, clusters, member_count, path);
+    }
+
+done:
+    if (clusters < 0 && !reported) fprintf(stderr, "Out of memory while looking for duplicates.\n");
+    if (out) fclose(out);
+    sqlite3_finalize(stmt);
+    for (int i = 0; workers && i < thread_count; ++i) free(workers[i].pairs);
+    free(workers); free(members); free(cluster_score); free(parent); free(blocks); free(keys); free(records);
+    free(arena.data);
+    return clusters;
+}
+
+// Empty fields of the kept customer are filled from the others, in order, and their notes are appended; the others
+// are then deleted. Everything happens in one transaction, so a failure leaves all of them as they were.
+int db_merge_clients(const int *ids, int count) {
+    if (count < 2) return 1;
+    if (!db_begin_write()) return 0;
+    Client *keep = NULL, *other = NULL;
+    char *notes = NULL;
+    bool notes_changed = false;
+    int ok = fetch_client_by_id(ids[0], &keep);
+    if (!ok) show_error("No customer with ID %d.", ids[0]);
+    else if (!(notes = keep->notes_len > 0 ? db_read_client_notes(ids[0]) : calloc(1, 1))) ok = 0;
+    for (int i = 1; ok && i < count; ++i) {
+        if (ids[i] == ids[0]) continue;
+        client_free(other);
+        if (!fetch_client_by_id(ids[i], &other)) {
+            show_error("No customer with ID %d.", ids[i]);
+            ok = 0;
+            break;
+        }
+        for (size_t f = 0; f < sizeof(cli_client_fields) / sizeof(cli_client_fields[0]); ++f) {
+            const CliClientField *field = &cli_client_fields[f];
+            if (!field->writable) continue;
+            if (field->text_field < 0) {
+                int *dest = (int*)((char*)keep + field->offset);
+                if (*dest == 0) *dest = *(const int*)((const char*)other + field->offset);
+            } else if (client_text(keep, field->text_field)[0] == '\0' &&
+                       !client_set_text(&keep, field->text_field, client_text(other, field->text_field))) {
+                show_error("Memory allocation failed while merging customer %d.", ids[0]);
+                ok = 0;
+                break;
+            }
+        }
+        char *other_notes = ok && other->notes_len > 0 ? db_read_client_notes(ids[i]) : NULL;
+        if (other_notes && other_notes[0] && !strstr(notes, other_notes)) {
+            size_t len = strlen(notes), add = strlen(other_notes) + (len > 0);
+            char *joined = len + add < MAX_NOTES_LEN ? realloc(notes, len + add + 1) : NULL;
+            if (!joined) {
+                show_error("Merged notes of customer %d would exceed %d bytes.", ids[0], MAX_NOTES_LEN - 1);
+                ok = 0;
+            } else {
+                notes = joined;
+                sprintf(notes + len, "%s%s", len > 0 ? "\n" : "", other_notes);
+                notes_changed = true;
+            }
+        } else if (ok && other->notes_len > 0 && !other_notes) {
+            ok = 0;
+        }
+        free(other_notes);
+        if (ok) ok = db_delete_client(ids[i]);
+    }
+    if (ok) {
+        keep->notes = notes_changed ? notes : NULL;
+        ok = db_update_client(keep) == 1;
+    }
+    if (ok && sqlite3_exec(db, "COMMIT;", NULL, NULL, NULL) != SQLITE_OK) {
+        show_error("Merge of customer %d failed: %s", ids[0], sqlite3_errmsg(db));
+        ok = 0;
+    }
+    if (!ok) sqlite3_exec(db, "ROLLBACK;", NULL, NULL, NULL);
+    free(notes);
+    client_free(keep);
+    client_free(other);
+    query_cache_clear();
+    return ok;
+}
+
+long long merge_duplicate_clusters(const char *path) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        fprintf(stderr, "Cannot open '%s': %s\n", path, strerror(errno));
+        return -1;
+    }
+    char *line = NULL;
+    size_t line_cap = 0;
+    int *ids = NULL, id_count = 0, id_cap = 0;
+    long cluster = -1;
+    long long merged = 0, line_no = 0, failed = 0;
+    bool more = true;
+    // Lines are "cluster<TAB>score<TAB>id<TAB>..."; a cluster is merged once the next one starts.
+    while (more) {
+        long next_cluster = -1, id = 0;
+        more = getline(&line, &line_cap, fp) >= 0;
+        line_no++;
+        if (more) {
+            if (line[0] == '#' || line[0] == '\n' || line[0] == '\r' || strncmp(line, "cluster\t", 8) == 0) continue;
+            char *end_ptr, *id_field = strchr(line, '\t');
+            next_cluster = strtol(line, &end_ptr, 10);
+            id_field = id_field ? strchr(id_field + 1, '\t') : NULL;
+            if (id_field) id = strtol(id_field + 1, &end_ptr, 10);
+            if (next_cluster <= 0 || !id_field || id <= 0 || id > INT_MAX || (*end_ptr != '\t' && *end_ptr != '\n' && *end_ptr)) {
+                fprintf(stderr, "Line %lld of '%s' is not a cluster line; stopping.\n", line_no, path);
+                failed++;
+                break;
+            }
+        }
+        if (next_cluster != cluster && id_count > 1) {
+            if (db_merge_clients(ids, id_count)) merged += id_count - 1;
+            else {
+                fprintf(stderr, "Cluster %ld (%d customers, first %d) was not merged.\n", cluster, id_count, ids[0]);
+                failed++;
+            }
+        }
+        if (next_cluster != cluster) id_count = 0;
+        cluster = next_cluster;
+        if (!more) break;
+        if (id_count == id_cap) {
+            int new_cap = id_cap ? id_cap * 2 : 16;
+            int *new_ids = realloc(ids, new_cap * sizeof(int));
+            if (!new_ids) { failed++; break; }
+            ids = new_ids;
+            id_cap = new_cap;
+        }
+        ids[id_count++] = (int)id;
+    }
+    free(line);
+    free(ids);
+    fclose(fp);
+    if (failed > 0) {
+        // The clusters merged before stay merged; the failure still has to reach the exit status.
+        fprintf(stderr, "Clusters not merged: %lld; merged %lld duplicate customers of the others.\n", failed, merged);
+        return -1;
+    }
+    return merged;
+}
+
+// --- Online Backup ---
+int start_background_backup(const char *dest_path) {
+    if (shard_count == 0 || !shards[0].conn) return 0;
+    pthread_mutex_lock(&backup_job.lock);
+    if (backup_job.active) { pthread_mutex_unlock(&backup_job.lock); return 0; }
+    backup_job.src = shards[0].conn;
+    strncpy(backup_job.dest_path, dest_path, sizeof(backup_job.dest_path) - 1);
+    backup_job.dest_path[sizeof(backup_job.dest_path) - 1] = '\0';
+    backup_job.active = true;
+    backup_job.finished = false;
+    backup_job.remaining = backup_job.pagecount = 0;
+    backup_job.rc = SQLITE_OK;
+    backup_job.err_msg[0] = '\0';
+    pthread_mutex_unlock(&backup_job.lock);
+
+    if (pthread_create(&backup_job.thread, NULL, backup_worker, &backup_job) != 0) {
+        pthread_mutex_lock(&backup_job.lock);
+        backup_job.active = false;
+        pthread_mutex_unlock(&backup_job.lock);
+        return 0;
+    }
+    return 1;
+}
+
+// The source connection's mutex is held only during each step, so operator writes run between steps and are
+// copied by the backup itself instead of forcing it to restart.
+void *backup_worker(void *arg) {
+    BackupJob *job = (BackupJob*)arg;
+    sqlite3 *dest = NULL;
+    int rc = sqlite3_open(job->dest_path, &dest);
+    char err_msg[MAX_STR_LEN] = "";
+
+    if (rc == SQLITE_OK) {
+        sqlite3_backup *backup = sqlite3_backup_init(dest, "main", job->src, "main");
+        if (backup) {
+            do {
+                rc = sqlite3_backup_step(backup, BACKUP_STEP_PAGES);
+                pthread_mutex_lock(&job->lock);
+                job->remaining = sqlite3_backup_remaining(backup);
+                job->pagecount = sqlite3_backup_pagecount(backup);
+                pthread_mutex_unlock(&job->lock);
+                if (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED) sqlite3_sleep(BACKUP_STEP_SLEEP_MS);
+            } while (rc == SQLITE_OK || rc == SQLITE_BUSY || rc == SQLITE_LOCKED);
+            sqlite3_backup_finish(backup);
+        }
+        rc = sqlite3_errcode(dest);
+    }
+    if (rc != SQLITE_OK) snprintf(err_msg, sizeof(err_msg), "%s", dest ? sqlite3_errmsg(dest) : sqlite3_errstr(rc));
+    sqlite3_close(dest);
+
+    pthread_mutex_lock(&job->lock);
+    job->rc = rc;
+    snprintf(job->err_msg, sizeof(job->err_msg), "%s", err_msg);
+    job->finished = true;
+    pthread_mutex_unlock(&job->lock);
+    return NULL;
+}
+
+int get_backup_progress(int *percent) {
+    pthread_mutex_lock(&backup_job.lock);
+    int active = backup_job.active;
+    int pagecount = backup_job.pagecount, remaining = backup_job.remaining;
+    pthread_mutex_unlock(&backup_job.lock);
+    *percent = pagecount > 0 ? (int)(100LL * (pagecount - remaining) / pagecount) : 0;
+    return active;
+}
+
+void poll_background_backup() {
+    pthread_mutex_lock(&backup_job.lock);
+    bool done = backup_job.active && backup_job.finished;
+    pthread_mutex_unlock(&backup_job.lock);
+    if (!done) return;
+
+    int rc = wait_for_background_backup();
+    if (main_win) wtimeout(main_win, -1);
+    if (rc == SQLITE_OK) show_status("Backup to '%s' completed (%d pages).", backup_job.dest_path, backup_job.pagecount);
+    else show_error("Backup to '%s' failed: %s", backup_job.dest_path, backup_job.err_msg);
+}
+
+int wait_for_background_backup() {
+    pthread_mutex_lock(&backup_job.lock);
+    bool active = backup_job.active;
+    pthread_mutex_unlock(&backup_job.lock);
+    if (!active) return SQLITE_OK;
+
+    if (status_win) show_status("Waiting for the backup to finish...");
+    pthread_join(backup_job.thread, NULL);
+    pthread_mutex_lock(&backup_job.lock);
+    backup_job.active = false;
+    int rc = backup_job.rc;
+    pthread_mutex_unlock(&backup_job.lock);
+    return rc;
+}
+
+int run_headless_backup(const char *dest_path) {
+    if (!start_background_backup(dest_path)) {
+        fprintf(stderr, "Could not start backup to '%s'.\n", dest_path);
+        return 0;
+    }
+    int percent, last_percent = -1;
+    while (1) {
+        pthread_mutex_lock(&backup_job.lock);
+        bool finished = backup_job.finished;
+        pthread_mutex_unlock(&backup_job.lock);
+        get_backup_progress(&percent);
+        if (percent != last_percent) {
+            fprintf(stderr, "\rBacking up '%s' to '%s': %3d%%", shards[0].path, dest_path, percent);
+            last_percent = percent;
+        }
+        if (finished) break;
+        sqlite3_sleep(BACKGROUND_POLL_MS / 5);
+    }
+    fprintf(stderr, "\n");
+    if (wait_for_background_backup() != SQLITE_OK) {
+        fprintf(stderr, "Backup failed: %s\n", backup_job.err_msg);
+        return 0;
+    }
+    fprintf(stderr, "Backup completed (%d pages).\n", backup_job.pagecount);
+    return 1;
+}
+
+// --- Idle Maintenance ---
+// Statistics, optimization and returning free pages run on a worker thread with its own connection while nobody types,
+// each step small enough that a progress handler can abandon it the moment a key arrives; the key is then served
+// without waiting and the database is tried again at the next idle period.
+long long monotonic_ms() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000LL + now.tv_nsec / 1000000;
+}
+
+int read_key(WINDOW *win) {
+    int key = wgetch(win);
+    if (key != ERR) note_user_input();
+    return key;
+}
+
+void note_user_input() {
+    pthread_mutex_lock(&maintenance_job.lock);
+    maintenance_job.last_input_ms = monotonic_ms();
+    pthread_mutex_unlock(&maintenance_job.lock);
+}
+
+int init_maintenance_log() {
+    const char *sql_create_log =
+        "CREATE TABLE IF NOT EXISTS \"maintenance_log\" ("
+        "\"id\"	INTEGER PRIMARY KEY,"
+        "\"started_at\"	DATETIME NOT NULL,"
+        "\"trigger\"	TEXT NOT NULL CHECK(\"trigger\" IN ('idle', 'close', 'manual')),"
+        "\"duration_ms\"	REAL NOT NULL,"
+        "\"analyzed\"	INTEGER NOT NULL,"
+        "\"analyzed_rows\"	INTEGER,"
+        "\"pages_before\"	INTEGER NOT NULL,"
+        "\"pages_after\"	INTEGER NOT NULL,"
+        "\"free_pages_after\"	INTEGER NOT NULL,"
+        "\"bytes_reclaimed\"	INTEGER NOT NULL,"
+        "\"interrupted\"	INTEGER NOT NULL"
+        ");";
+    return db_execute(sql_create_log, NULL, NULL);
+}
+
+int maintenance_progress(void *arg) {
+    MaintenanceRun *run = (MaintenanceRun*)arg;
+    if (run->deadline_ms && monotonic_ms() >= run->deadline_ms) return 1;
+    pthread_mutex_lock(&maintenance_job.lock);
+    bool stop = maintenance_job.stop, typed = maintenance_job.last_input_ms > run->started_ms;
+    pthread_mutex_unlock(&maintenance_job.lock);
+    if (stop) return 1;
+    if (!run->yield_on_input) return 0;
+    struct pollfd terminal = { STDIN_FILENO, POLLIN, 0 }; // Catches keys typed while the UI thread is busy elsewhere.
+    return typed || poll(&terminal, 1, 0) > 0;
+}
+
+int maintenance_query(sqlite3 *conn, const char *sql, long long *value) {
+    sqlite3_stmt *stmt = NULL;
+    int rc = sqlite3_prepare_v2(conn, sql, -1, &stmt, NULL);
+    if (rc == SQLITE_OK) {
+        rc = sqlite3_step(stmt);
+        if (rc == SQLITE_ROW) *value = sqlite3_column_int64(stmt, 0);
+        rc = rc == SQLITE_ROW || rc == SQLITE_DONE ? SQLITE_OK : rc;
+    }
+    sqlite3_finalize(stmt);
+    return rc;
+}
+
+int run_maintenance(sqlite3 *conn, MaintenanceRun *run) {
+    run->started_ms = monotonic_ms();
+    run->started_at = time(NULL);
+    run->analyzed = run->interrupted = run->converted = false;
+    run->analyzed_rows = 0;
+    long long page_size = 0, pages = 0, free_pages = 0, auto_vacuum = 0, rows = 0, last_rows = -1, vacuum_pages = -1;
+    maintenance_query(conn, "PRAGMA page_size;", &page_size);
+    maintenance_query(conn, "PRAGMA page_count;", &pages);
+    maintenance_query(conn, "SELECT analyzed_rows FROM maintenance_log WHERE analyzed ORDER BY id DESC LIMIT 1;", &last_rows);
+    run->pages_before = (int)pages;
+
+    sqlite3_progress_handler(conn, MAINTENANCE_PROGRESS_OPS, maintenance_progress, run);
+    // A sampled ANALYZE reads at most MAINTENANCE_ANALYSIS_LIMIT rows of each index, and runs only once the number of
+    // customers has moved enough since the last one to change the plans.
+    int rc = maintenance_query(conn, "SELECT count(*) FROM clients;", &rows);
+    if (rc == SQLITE_OK && (last_rows < 0 || llabs(rows - last_rows) * 100 > last_rows * MAINTENANCE_RESTATS_PERCENT)) {
+        char *sql = sqlite3_mprintf("PRAGMA analysis_limit = %d; ANALYZE;", MAINTENANCE_ANALYSIS_LIMIT);
+        rc = sql ? sqlite3_exec(conn, sql, NULL, NULL, NULL) : SQLITE_NOMEM;
+        sqlite3_free(sql);
+        if (rc == SQLITE_OK) {
+            run->analyzed = true;
+            run->analyzed_rows = rows;
+        }
+    }
+    if (rc == SQLITE_OK) rc = sqlite3_exec(conn, "PRAGMA optimize;", NULL, NULL, NULL);
+    if (rc == SQLITE_OK) rc = maintenance_query(conn, "PRAGMA auto_vacuum;", &auto_vacuum);
+    if (rc == SQLITE_OK) rc = maintenance_query(conn, "PRAGMA freelist_count;", &free_pages);
+    // ANALYZE can add pages (sqlite_stat1), so only what the vacuum step below takes off the file counts as reclaimed.
+    if (rc == SQLITE_OK) rc = maintenance_query(conn, "PRAGMA page_count;", &vacuum_pages);
+    if (rc == SQLITE_OK && auto_vacuum == 2) {
+        // Each step is its own short transaction, so other editors' writes slip in between.
+        char *sql = sqlite3_mprintf("PRAGMA incremental_vacuum(%d);", MAINTENANCE_VACUUM_STEP_PAGES);
+        if (!sql) rc = SQLITE_NOMEM;
+        while (rc == SQLITE_OK && free_pages > 0) {
+            rc = sqlite3_exec(conn, sql, NULL, NULL, NULL);
+            if (rc == SQLITE_OK) rc = maintenance_query(conn, "PRAGMA freelist_count;", &free_pages);
+        }
+        sqlite3_free(sql);
+    } else if (rc == SQLITE_OK && auto_vacuum == 0 && run->allow_convert && free_pages > 0 &&
+               free_pages * 100 >= pages * MAINTENANCE_CONVERT_FREE_PERCENT) {
+        // Databases created before auto_vacuum was set can only switch with a full rebuild.
+        rc = sqlite3_exec(conn, "PRAGMA auto_vacuum = INCREMENTAL; VACUUM;", NULL, NULL, NULL);
+        run->converted = rc == SQLITE_OK;
+    }
+    sqlite3_progress_handler(conn, 0, NULL, NULL);
+    if (rc == SQLITE_INTERRUPT) run->interrupted = true;
+    else if (rc != SQLITE_OK) return 0;
+
+    maintenance_query(conn, "PRAGMA page_count;", &pages);
+    maintenance_query(conn, "PRAGMA freelist_count;", &free_pages);
+    run->pages_after = (int)pages;
+    run->free_after = (int)free_pages;
+    run->bytes_reclaimed = vacuum_pages > pages ? (vacuum_pages - pages) * page_size : 0; // Never negative.
+    run->duration_ms = (double)(monotonic_ms() - run->started_ms);
+
+    sqlite3_stmt *stmt = NULL;
+    const char *sql_log =
+        "INSERT INTO maintenance_log (started_at, \"trigger\", duration_ms, analyzed, analyzed_rows, pages_before, "
+        "pages_after, free_pages_after, bytes_reclaimed, interrupted) "
+        "VALUES (datetime(?, 'unixepoch'), ?, ?, ?, ?, ?, ?, ?, ?, ?);";
+    rc = sqlite3_prepare_v2(conn, sql_log, -1, &stmt, NULL);
+    if (rc == SQLITE_OK) {
+        sqlite3_bind_int64(stmt, 1, (sqlite3_int64)run->started_at);
+        sqlite3_bind_text(stmt, 2, run->trigger, -1, SQLITE_STATIC);
+        sqlite3_bind_double(stmt, 3, run->duration_ms);
+        sqlite3_bind_int(stmt, 4, run->analyzed);
+        if (run->analyzed) sqlite3_bind_int64(stmt, 5, run->analyzed_rows);
+        sqlite3_bind_int(stmt, 6, run->pages_before);
+        sqlite3_bind_int(stmt, 7, run->pages_after);
+        sqlite3_bind_int(stmt, 8, run->free_after);
+        sqlite3_bind_int64(stmt, 9, run->bytes_reclaimed);
+        sqlite3_bind_int(stmt, 10, run->interrupted);
+        rc = sqlite3_step(stmt) == SQLITE_DONE ? SQLITE_OK : sqlite3_errcode(conn);
+    }
+    sqlite3_finalize(stmt);
+    if (rc != SQLITE_OK) return 0;
+    char *sql_trim = sqlite3_mprintf("DELETE FROM maintenance_log WHERE id <= (SELECT max(id) FROM maintenance_log) - %d;", MAINTENANCE_LOG_ROWS);
+    if (sql_trim) sqlite3_exec(conn, sql_trim, NULL, NULL, NULL);
+    sqlite3_free(sql_trim);
+    return 1;
+}
+
+void *maintenance_worker(void *arg) {
+    MaintenanceJob *job = (MaintenanceJob*)arg;
+    pthread_mutex_lock(&job->lock);
+    while (!job->stop) {
+        long long now = monotonic_ms(), wake_at = job->last_input_ms + job->idle_ms, due_at = LLONG_MAX;
+        int shard = -1;
+        for (int i = 0; i < shard_count; ++i) {
+            if (job->next_run_ms[i] < due_at) { due_at = job->next_run_ms[i]; shard = i; }
+        }
+        if (due_at > wake_at) wake_at = due_at;
+        if (shard < 0 || now < wake_at) {
+            long long wait_ms = shard < 0 ? job->idle_ms : wake_at - now;
+            struct timespec until;
+            clock_gettime(CLOCK_REALTIME, &until); // The condition variable's clock.
+            until.tv_sec += wait_ms / 1000;
+            until.tv_nsec += (wait_ms % 1000) * 1000000L;
+            if (until.tv_nsec >= 1000000000L) { until.tv_sec++; until.tv_nsec -= 1000000000L; }
+            pthread_cond_timedwait(&job->wake, &job->lock, &until);
+            continue;
+        }
+        pthread_mutex_unlock(&job->lock);
+
+        // A write from another connection would make a running backup start over.
+        pthread_mutex_lock(&backup_job.lock);
+        bool backing_up = backup_job.active;
+        pthread_mutex_unlock(&backup_job.lock);
+        MaintenanceRun run = { .trigger = "idle", .yield_on_input = true };
+        sqlite3 *conn = NULL;
+        bool done = false;
+        if (!backing_up && sqlite3_open_v2(shards[shard].path, &conn, SQLITE_OPEN_READWRITE, NULL) == SQLITE_OK) {
+            sqlite3_busy_handler(conn, db_busy_backoff, NULL);
+            done = run_maintenance(conn, &run);
+        }
+        sqlite3_close(conn);
+
+        pthread_mutex_lock(&job->lock);
+        now = monotonic_ms();
+        if (backing_up) job->next_run_ms[shard] = now + job->idle_ms;
+        else if (done && run.interrupted) {
+            job->next_run_ms[shard] = 0;
+            if (job->last_input_ms < now) job->last_input_ms = now; // The key may not have been read yet.
+        } else job->next_run_ms[shard] = now + MAINTENANCE_INTERVAL_SECONDS * 1000LL; // Failed runs wait as long as completed ones.
+    }
+    pthread_mutex_unlock(&job->lock);
+    return NULL;
+}
+
+void start_idle_maintenance(int idle_seconds) {
+    if (idle_seconds <= 0 || maintenance_job.started) return;
+    pthread_mutex_lock(&maintenance_job.lock);
+    maintenance_job.idle_ms = idle_seconds * 1000LL;
+    maintenance_job.last_input_ms = monotonic_ms();
+    maintenance_job.stop = false; // next_run_ms is left as is; switch_db_shards sets it for the databases it switches to.
+    maintenance_job.started = pthread_create(&maintenance_job.thread, NULL, maintenance_worker, &maintenance_job) == 0;
+    pthread_mutex_unlock(&maintenance_job.lock);
+}
+
+void stop_idle_maintenance() {
+    pthread_mutex_lock(&maintenance_job.lock);
+    bool started = maintenance_job.started;
+    maintenance_job.stop = true;
+    pthread_cond_signal(&maintenance_job.wake);
+    pthread_mutex_unlock(&maintenance_job.lock);
+    if (started) pthread_join(maintenance_job.thread, NULL);
+    maintenance_job.started = false;
+    maintenance_job.stop = false;
+}
+
+// Databases the idle worker did not get to this session get what fits in MAINTENANCE_CLOSE_MAX_MS; an unfinished run
+// leaves them due again next time.
+void run_close_maintenance() {
+    if (maintenance_job.idle_ms <= 0) return;
+    long long now = monotonic_ms(), deadline = now + MAINTENANCE_CLOSE_MAX_MS;
+    for (int i = 0; i < shard_count && monotonic_ms() < deadline; ++i) {
+        if (!shards[i].conn || maintenance_job.next_run_ms[i] > now) continue;
+        MaintenanceRun run = { .trigger = "close", .deadline_ms = deadline };
+        run_maintenance(shards[i].conn, &run);
+    }
+}
+
+int run_headless_maintenance() {
+    int ok = 1;
+    for (int i = 0; i < shard_count; ++i) {
+        MaintenanceRun run = { .trigger = "manual", .allow_convert = true };
+        if (!run_maintenance(shards[i].conn, &run)) {
+            fprintf(stderr, "Maintenance of '%s' failed: %s\n", shards[i].path, sqlite3_errmsg(shards[i].conn));
+            ok = 0;
+            continue;
+        }
+        fprintf(stderr, "Maintained '%s' in %.0f ms: ", shards[i].path, run.duration_ms);
+        if (run.analyzed) fprintf(stderr, "statistics gathered (%lld customers), ", run.analyzed_rows);
+        fprintf(stderr, "%lld bytes reclaimed, %d free pages left%s.\n", run.bytes_reclaimed, run.free_after,
+                run.converted ? ", switched to incremental auto_vacuum" : "");
+    }
+    return ok;
+}
+
+// --- Input Helpers ---
+// Text is entered with a small line editor: wide characters with their widths and UTF-8 lengths sit in a gap buffer,
+// so editing at the cursor costs the same in 16 KB of notes as in a name, and each keystroke writes only the visible
+// cells that changed.
+int gap_buffer_length(const GapBuffer *gb) {
+    return gb->capacity - (gb->gap_end - gb->gap_start);
+}
+
+EditChar *gap_buffer_at(GapBuffer *gb, int index) {
+    return &gb->chars[index < gb->gap_start ? index : index + (gb->gap_end - gb->gap_start)];
+}
+
+void gap_buffer_move(GapBuffer *gb, int position) {
+    if (position < gb->gap_start) {
+        int count = gb->gap_start - position;
+        memmove(gb->chars + gb->gap_end - count, gb->chars + position, count * sizeof(EditChar));
+        gb->gap_start -= count;
+        gb->gap_end -= count;
+    } else if (position > gb->gap_start) {
+        int count = position - gb->gap_start;
+        memmove(gb->chars + gb->gap_start, gb->chars + gb->gap_end, count * sizeof(EditChar));
+        gb->gap_start += count;
+        gb->gap_end += count;
+    }
+}
+
+int gap_buffer_insert(GapBuffer *gb, wchar_t wc, int max_bytes) {
+    char encoded[MB_LEN_MAX];
+    mbstate_t state;
+    memset(&state, 0, sizeof(state));
+    size_t bytes = wcrtomb(encoded, wc, &state);
+    if (bytes == (size_t)-1 || gb->bytes + (int)bytes > max_bytes) return 0;
+    if (gb->gap_start == gb->gap_end) {
+        int capacity = gb->capacity ? gb->capacity * 2 : GAP_BUFFER_INITIAL_CAPACITY;
+        EditChar *chars = realloc(gb->chars, capacity * sizeof(EditChar));
+        if (!chars) return 0;
+        int tail = gb->capacity - gb->gap_end;
+        memmove(chars + capacity - tail, chars + gb->gap_end, tail * sizeof(EditChar));
+        gb->chars = chars;
+        gb->gap_end = capacity - tail;
+        gb->capacity = capacity;
+    }
+    int width = wcwidth(wc);
+    gb->chars[gb->gap_start++] = (EditChar){ wc, width > 0 ? width : 1, (unsigned char)bytes };
+    gb->bytes += (int)bytes;
+    return 1;
+}
+
+void gap_buffer_delete(GapBuffer *gb, int from, int to) {
+    if (from < 0) from = 0;
+    if (from >= to) return;
+    gap_buffer_move(gb, to);
+    for (int i = from; i < to; ++i) gb->bytes -= gb->chars[i].bytes;
+    gb->gap_start = from;
+}
+
+void gap_buffer_set_text(GapBuffer *gb, const char *text, int max_bytes) {
+    gb->gap_start = 0;
+    gb->gap_end = gb->capacity;
+    gb->bytes = 0;
+    mbstate_t state;
+    memset(&state, 0, sizeof(state));
+    size_t len = strlen(text);
+    while (len > 0) {
+        wchar_t wc;
+        size_t used = mbrtowc(&wc, text, len, &state);
+        if (used == 0) break;
+        if (used == (size_t)-1 || used == (size_t)-2) { // Invalid UTF-8 is shown (and kept) as '?'.
+            wc = L'?';
+            used = 1;
+            memset(&state, 0, sizeof(state));
+        }
+        if (!gap_buffer_insert(gb, wc, max_bytes)) break;
+        text += used;
+        len -= used;
+    }
+}
+
+void gap_buffer_to_utf8(GapBuffer *gb, char *out, int from, int to) {
+    mbstate_t state;
+    memset(&state, 0, sizeof(state));
+    size_t len = 0;
+    for (int i = from; i < to; ++i) len += wcrtomb(out + len, gap_buffer_at(gb, i)->wc, &state);
+    out[len] = '\0';
+}
+
+int gap_buffer_word_boundary(GapBuffer *gb, int from, int direction) {
+    int length = gap_buffer_length(gb), pos = from;
+    if (direction < 0) {
+        while (pos > 0 && !iswalnum(gap_buffer_at(gb, pos - 1)->wc)) pos--;
+        while (pos > 0 && iswalnum(gap_buffer_at(gb, pos - 1)->wc)) pos--;
+    } else {
+        while (pos < length && iswalnum(gap_buffer_at(gb, pos)->wc)) pos++;
+        while (pos < length && !iswalnum(gap_buffer_at(gb, pos)->wc)) pos++;
+    }
+    return pos;
+}
+
+// shown[] holds what each cell of the field displays (L'\0' for the right half of a wide character), so unchanged
+// cells are skipped; the view scrolls just far enough to keep the cursor in the field.
+void draw_line_editor(WINDOW *win, int y, int x, int width, GapBuffer *gb, int *view_start, wchar_t *shown) {
+    int cursor = gb->gap_start, length = gap_buffer_length(gb);
+    if (cursor < *view_start) *view_start = cursor;
+    int cursor_col = 0;
+    for (int i = *view_start; i < cursor; ++i) cursor_col += gap_buffer_at(gb, i)->width;
+    while (cursor_col > width - 1 && *view_start < cursor) cursor_col -= gap_buffer_at(gb, (*view_start)++)->width;
+
+    int col = 0;
+    for (int i = *view_start; i < length && col < width; ++i) {
+        const EditChar *c = gap_buffer_at(gb, i);
+        if (col + c->width > width) break;
+        wchar_t wc = wcwidth(c->wc) > 0 ? c->wc : L'?';
+        if (shown[col] != wc) {
+            cchar_t cell;
+            setcchar(&cell, (const wchar_t[]){wc, L'\0'}, A_NORMAL, 0, NULL);
+            mvwadd_wch(win, y, x + col, &cell);
+            shown[col] = wc;
+        }
+        for (int k = 1; k < c->width; ++k) shown[col + k] = L'\0';
+        col += c->width;
+    }
+    for (; col < width; ++col) {
+        if (shown[col] != L' ') {
+            mvwaddch(win, y, x + col, ' ');
+            shown[col] = L' ';
+        }
+    }
+    wmove(win, y, x + cursor_col);
+}
+
+void input_history_add(const char *prompt, const char *text) {
+    // Notes may be private and are rarely typed twice, so none are kept, whatever their length; nor are aborts.
+    if (strcmp(prompt, NOTES_PROMPT) == 0 || strcmp(text, CANCEL_INPUT_STRING) == 0) return;
+    char key[INPUT_HISTORY_PROMPT_LEN];
+    snprintf(key, sizeof(key), "%s", prompt);
+    char *copy = strdup(text);
+    if (!copy) return;
+    for (int i = 0; i < input_history_count; ++i) { // A line entered again moves to the newest place.
+        if (strcmp(input_history[i].prompt, key) == 0 && strcmp(input_history[i].text, text) == 0) {
+            free(input_history[i].text);
+            memmove(&input_history[i], &input_history[i + 1], (input_history_count - i - 1) * sizeof(InputHistoryEntry));
+            input_history_count--;
+            break;
+        }
+    }
+    if (input_history_count == INPUT_HISTORY_SIZE) {
+        free(input_history[0].text);
+        memmove(&input_history[0], &input_history[1], (INPUT_HISTORY_SIZE - 1) * sizeof(InputHistoryEntry));
+        input_history_count--;
+    }
+    InputHistoryEntry *entry = &input_history[input_history_count++];
+    snprintf(entry->prompt, sizeof(entry->prompt), "%s", key);
+    entry->text = copy;
+}
+
+void input_history_clear() {
+    for (int i = 0; i < input_history_count; ++i) free(input_history[i].text);
+    input_history_count = 0;
+}
+
+int collect_input_completions(const char *prefix, const char *const *recall, int recall_count, const char *dictionary, char ***completions) {
+    size_t prefix_len = strlen(prefix);
+    int count = 0, capacity = recall_count + (dictionary ? DICTIONARY_COMPLETION_LIMIT : 0);
+    *completions = NULL;
+    if (capacity == 0) return 0;
+    char **found = malloc(capacity * sizeof(char*));
+    if (!found) return -1;
+    for (int i = 0; i < recall_count; ++i) {
+        if (strncasecmp(recall[i], prefix, prefix_len) == 0 && (found[count] = strdup(recall[i]))) count++;
+    }
+    // The name index orders the lookup table by name regardless of case, so LIKE reads just the matching range.
+    char sql[128], *pattern = dictionary ? malloc(2 * prefix_len + 2) : NULL;
+    sqlite3_stmt *stmt = NULL;
+    if (pattern && db) {
+        snprintf(sql, sizeof(sql), "SELECT name FROM \"%s\" WHERE name LIKE ?1 ESCAPE '\\' ORDER BY name LIMIT ?2;", dictionary);
+        size_t len = 0;
+        for (const char *c = prefix; *c; ++c) {
+            if (*c == '%' || *c == '_' || *c == '\\') pattern[len++] = '\\';
+            pattern[len++] = *c;
+        }
+        pattern[len++] = '%';
+        if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) == SQLITE_OK) {
+            sqlite3_bind_text(stmt, 1, pattern, (int)len, SQLITE_STATIC);
+            sqlite3_bind_int(stmt, 2, DICTIONARY_COMPLETION_LIMIT);
+            while (count < capacity && sqlite3_step(stmt) == SQLITE_ROW) {
+                const char *name = (const char*)sqlite3_column_text(stmt, 0);
+                bool seen = false;
+                for (int i = 0; i < count && !seen; ++i) seen = strcasecmp(found[i], name) == 0;
+                if (!seen && (found[count] = strdup(name))) count++;
+            }
+        }
+        sqlite3_finalize(stmt);
+    }
+    free(pattern);
+    *completions = found;
+    return count;
+}
+
+int get_string_input(WINDOW *win, int y, int x, const char *prompt, char *buffer, int max_len, bool allow_empty, const char *current_value_display) {
+    return get_dictionary_string_input(win, y, x, prompt, buffer, max_len, allow_empty, current_value_display, NULL);
+}
+
+int get_dictionary_string_input(WINDOW *win, int y, int x, const char *prompt, char *buffer, int max_len, bool allow_empty, const char *current_value_display, const char *dictionary) {
+    if (max_len <= 0) {
+        if(status_win) show_error("Internal error: max_len <= 0 in get_string_input for %s", prompt);
+        return 0;
+    }
+    char *text = NULL;
+    int res = get_allocated_string_input(win, y, x, prompt, max_len - 1, allow_empty, current_value_display, dictionary, &text);
+    if (text) {
+        strncpy(buffer, text, max_len - 1);
+        buffer[max_len - 1] = '\0';
+        free(text);
+    } else buffer[0] = '\0';
+    return res;
+}
+
+int get_allocated_string_input(WINDOW *win, int y, int x, const char *prompt, int max_bytes, bool allow_empty, const char *current_value_display, const char *dictionary, char **text) {
+    *text = NULL;
+    if (!win) return -2;
+    curs_set(1);
+    noecho();
+
+    // Up and Down recall the current value, then the lines entered at this prompt before (newest first); Tab
+    // completes the text before the cursor from the same lines and the dictionary's values, and pressed again
+    // cycles through the matches.
+    char prompt_key[INPUT_HISTORY_PROMPT_LEN];
+    snprintf(prompt_key, sizeof(prompt_key), "%s", prompt);
+    const char *recall[INPUT_HISTORY_SIZE + 1];
+    int recall_count = 0;
+    if (current_value_display && current_value_display[0]) recall[recall_count++] = current_value_display;
+    for (int i = input_history_count - 1; i >= 0; --i) {
+        if (strcmp(input_history[i].prompt, prompt_key) != 0) continue;
+        if (recall_count > 0 && strcmp(recall[0], input_history[i].text) == 0) continue;
+        recall[recall_count++] = input_history[i].text;
+    }
+
+    GapBuffer gb;
+    memset(&gb, 0, sizeof(gb));
+    wchar_t *shown = NULL;
+    int ctrl_left = key_defined("kLFT5"), ctrl_right = key_defined("kRIT5");
+    int field_x = 0, field_width = 0, view_start = 0, recall_index = -1, completion_index = -1, completion_count = -1, result = 1;
+    bool match_shown = false, redraw = true;
+    char *draft = NULL, **completions = NULL;
+    wtimeout(win, BACKGROUND_POLL_MS); // Wake up to follow a resize.
+
+    while (1) {
+        if (redraw) { // The prompt and the field's width follow the window's size.
+            werase(win); draw_custom_box(win);
+            wmove(win, y, x);
+            int prompt_text_visual_len = RF_INPUT_PROMPT_VISUAL_LEN + strlen(prompt) + 1;
+
+            wprintw(win, "%s%s ", RF_INPUT_PROMPT_STR, prompt);
+            if (current_value_display && strlen(current_value_display) > 0) {
+                if(has_colors()) wattron(win, COLOR_PAIR(COLOR_PAIR_INPUT_CURRENT));
+
+                int available_for_current = getmaxx(win) - x - prompt_text_visual_len - 3 - 2;
+                if (available_for_current < 3) available_for_current = 3;
+
+                TextWidth current_tw = measure_text_width(current_value_display);
+                bool truncated = current_tw.cols > available_for_current;
+                wprintw(win, "[");
+                draw_text_cols(win, current_value_display, &current_tw, available_for_current - (truncated ? 2 : 0), false);
+                wprintw(win, "%s]", truncated ? ".." : "");
+
+                if(has_colors()) wattroff(win, COLOR_PAIR(COLOR_PAIR_INPUT_CURRENT));
+            }
+            wprintw(win, ": ");
+
+            field_x = getcurx(win);
+            field_width = getmaxx(win) - MAIN_WIN_BORDER_WIDTH - field_x;
+            if (field_width < 1) {
+                field_x = getmaxx(win) - MAIN_WIN_BORDER_WIDTH - 1;
+                field_width = 1;
+            }
+            wchar_t *resized = realloc(shown, field_width * sizeof(wchar_t));
+            if (!resized) {
+                show_error("Memory allocation failed for input of %s.", prompt);
+                result = 0;
+                break;
+            }
+            shown = resized;
+            for (int i = 0; i < field_width; ++i) shown[i] = (wchar_t)WEOF;
+            redraw = false;
+        }
+        draw_line_editor(win, y, field_x, field_width, &gb, &view_start, shown);
+        refresh_window(win);
+        wint_t ch;
+        int kind = wget_wch(win, &ch);
+        if (kind != ERR) note_user_input();
+        if (kind == ERR) {
+            if (exit_requested) { result = -1; break; }
+            if (resize_pending) {
+                check_and_handle_resize();
+                if (!input_win) { win = NULL; result = -1; break; } // Too small for any window; the text is dropped.
+                redraw = true;
+            }
+            continue;
+        }
+        if (kind == KEY_CODE_YES && ch == KEY_RESIZE) { redraw = true; continue; }
+        int cursor = gb.gap_start, length = gap_buffer_length(&gb);
+        bool completing = false;
+        if ((kind == OK && (ch == L'\n' || ch == L'\r')) || (kind == KEY_CODE_YES && ch == KEY_ENTER)) break;
+        if (kind == OK && ch == KEY_ESC) { result = -1; break; }
+
+        if (kind == KEY_CODE_YES) {
+            switch (ch) {
+                case KEY_LEFT: gap_buffer_move(&gb, cursor > 0 ? cursor - 1 : 0); break;
+                case KEY_RIGHT: gap_buffer_move(&gb, cursor < length ? cursor + 1 : length); break;
+                case KEY_HOME: gap_buffer_move(&gb, 0); break;
+                case KEY_END: gap_buffer_move(&gb, length); break;
+                case KEY_BACKSPACE: gap_buffer_delete(&gb, cursor - 1, cursor); break;
+                case KEY_DC: if (cursor < length) gap_buffer_delete(&gb, cursor, cursor + 1); break;
+                case KEY_UP: case KEY_DOWN: {
+                    int next = recall_index + (ch == KEY_UP ? 1 : -1);
+                    if (next < -1 || next >= recall_count) { beep(); break; }
+                    if (recall_index == -1) { // Keeps the line being typed to come back to.
+                        free(draft);
+                        if ((draft = malloc(gb.bytes + 1))) gap_buffer_to_utf8(&gb, draft, 0, length);
+                    }
+                    recall_index = next;
+                    gap_buffer_set_text(&gb, next >= 0 ? recall[next] : draft ? draft : "", max_bytes);
+                    break;
+                }
+                default:
+                    if (ctrl_left > 0 && (int)ch == ctrl_left) gap_buffer_move(&gb, gap_buffer_word_boundary(&gb, cursor, -1));
+                    else if (ctrl_right > 0 && (int)ch == ctrl_right) gap_buffer_move(&gb, gap_buffer_word_boundary(&gb, cursor, 1));
+                    else beep();
+                    break;
+            }
+        } else {
+            switch (ch) {
+                case KEY_CTRL('a'): gap_buffer_move(&gb, 0); break;
+                case KEY_CTRL('e'): gap_buffer_move(&gb, length); break;
+                case KEY_CTRL('h'): case 127: gap_buffer_delete(&gb, cursor - 1, cursor); break;
+                case KEY_CTRL('w'): gap_buffer_delete(&gb, gap_buffer_word_boundary(&gb, cursor, -1), cursor); break;
+                case KEY_CTRL('u'): gap_buffer_delete(&gb, 0, cursor); break;
+                case KEY_CTRL('k'): gap_buffer_delete(&gb, cursor, length); break;
+                case L'\t': {
+                    completing = true;
+                    if (completion_count < 0) {
+                        char *prefix = malloc(gb.bytes + 1);
+                        if (!prefix) break;
+                        gap_buffer_to_utf8(&gb, prefix, 0, cursor);
+                        completion_count = collect_input_completions(prefix, recall, recall_count, dictionary, &completions);
+                        free(prefix);
+                    }
+                    if (completion_count <= 0) { beep(); break; }
+                    completion_index = (completion_index + 1) % completion_count;
+                    gap_buffer_set_text(&gb, completions[completion_index], max_bytes);
+                    if (completion_count > 1) {
+                        show_status("Match %d of %d; Tab for the next.", completion_index + 1, completion_count);
+                        match_shown = true;
+                    }
+                    break;
+                }
+                default:
+                    if (!iswprint(ch) || !gap_buffer_insert(&gb, ch, max_bytes)) beep();
+                    break;
+            }
+        }
+        if (!completing && completion_count >= 0) {
+            for (int i = 0; i < completion_count; ++i) free(completions[i]);
+            free(completions);
+            completions = NULL;
+            completion_count = completion_index = -1;
+        }
+    }
+
+    char *entered = result == 0 ? NULL : malloc(gb.bytes + 1);
+    if (entered) gap_buffer_to_utf8(&gb, entered, 0, gap_buffer_length(&gb));
+    for (int i = 0; i < completion_count; ++i) free(completions[i]);
+    free(gb.chars); free(shown); free(draft); free(completions);
+    if (match_shown) show_status("");
+    curs_set(0);
+    if (win) {
+        wtimeout(win, -1);
+        werase(win); draw_custom_box(win); refresh_window(win);
+    }
+    if (result == 0) return 0;
+    if (!entered) {
+        show_error("Memory allocation failed for input of %s.", prompt);
+        return 0;
+    }
+
+    if (result == -1 || entered[0] == '\0') {
+        if (result == 1 && !current_value_display && !allow_empty) {
+            show_error("Input for '%s' cannot be empty.", prompt);
+            free(entered);
+            return 0;
+        }
+        if (current_value_display) {
+            free(entered);
+            if (!(entered = strdup(current_value_display))) {
+                show_error("Memory allocation failed for input of %s.", prompt);
+                return 0;
+            }
+        } else entered[0] = '\0';
+        *text = entered;
+        return result;
+    }
+
+    input_history_add(prompt, entered);
+    *text = entered;
+    return 1;
+}
+
+int get_int_input(WINDOW *win, int y, int x, const char *prompt, int *value_ptr, int current_value) {
+    char buffer[MAX_STR_LEN];
+    char current_val_str[32];
+    snprintf(current_val_str, sizeof(current_val_str), "%d", current_value);
+
+    int res = get_string_input(win, y, x, prompt, buffer, sizeof(buffer), true, current_val_str);
+
+    if (res == -1) return -1;
+    if (res == 0 ) return 0;
+
+    if (strlen(buffer) == 0 || strcmp(buffer, current_val_str) == 0) {
+        *value_ptr = current_value;
+        return 1;
+    }
+
+    char *endptr;
+    long num = strtol(buffer, &endptr, 10);
+
+    if (*endptr != '\0' || endptr == buffer) {
+        show_error("Invalid number for '%s': %s", prompt, buffer);
+        *value_ptr = current_value;
+        return 0;
+    }
+    *value_ptr = (int)num;
+    return 1;
+}
+
+int select_client_status(char *selected_status, const char *current_status) {
+    const char *statuses[] = {"Active", "Inactive", "Prospect", "Lead", "Former", "(Cancel)"};
+    int n_statuses = sizeof(statuses) / sizeof(statuses[0]);
+    int choice = 0;
+    int key;
 
     if (current_status && strlen(current_status) > 0) {
         for (int i = 0; i < n_statuses - 1; ++i) {
@@ -914,16 +4389,16 @@ int select_client_status(char *selected_status, const char *current_status) {
             }
             current_x_pos += strlen(statuses[i]) + 3;
         }
-        wrefresh(input_win);
+        refresh_window(input_win);
 
-        key = wgetch(input_win);
+        key = read_key(input_win);
 
         switch(key) {
             case KEY_NAV_LEFT: choice = (choice - 1 + n_statuses) % n_statuses; break;
             case KEY_NAV_RIGHT: choice = (choice + 1) % n_statuses; break;
             case KEY_ACTION_SELECT:
             case KEY_ACTION_ENTER:
-                werase(input_win); draw_custom_box(input_win); wrefresh(input_win);
+                werase(input_win); draw_custom_box(input_win); refresh_window(input_win);
                 if (choice == n_statuses - 1) {
                     if (current_status) strncpy(selected_status, current_status, MAX_STR_LEN -1);
                     else strcpy(selected_status, "Active");
@@ -934,7 +4409,7 @@ int select_client_status(char *selected_status, const char *current_status) {
                 selected_status[MAX_STR_LEN - 1] = '\0';
                 return 1;
             case KEY_ESC:
-                werase(input_win); draw_custom_box(input_win); wrefresh(input_win);
+                werase(input_win); draw_custom_box(input_win); refresh_window(input_win);
                 if (current_status) strncpy(selected_status, current_status, MAX_STR_LEN -1);
                 else strcpy(selected_status, "Active");
                 selected_status[MAX_STR_LEN-1] = '\0';
@@ -943,6 +4418,20 @@ int select_client_status(char *selected_status, const char *current_status) {
     }
 }
 
+// Fields have no length limit: the text is edited in a string of its own and copied into the record, so neither a long
+// current value nor newly typed text is cut short.
+int get_client_text_input(const char *prompt, Client **client, ClientTextField field, bool allow_empty, const char *current) {
+    char *text = NULL;
+    int res = get_allocated_string_input(input_win, INPUT_PROMPT_Y, INPUT_PROMPT_X, prompt, INT_MAX - 1, allow_empty, current,
+                                         client_field_dictionary(field), &text);
+    if ((res == 1 || res == -1) && text && !client_set_text(client, field, text)) {
+        show_error("Memory allocation failed for %s.", prompt);
+        res = 0;
+    }
+    free(text);
+    return res;
+}
+
 // --- Core Screens & UI Logic ---
 void display_editor_main_menu() {
     const char *options[] = {
@@ -950,6 +4439,8 @@ void display_editor_main_menu() {
         "2. Edit/Search/View Customer",
         "3. Delete Customer",
         "4. Return to Main Program",
+        "5. Back Up Database",
+        "6. Switch Database",
         "Q. Quit"
     };
     int n_options = sizeof(options) / sizeof(options[0]);
@@ -962,6 +4453,7 @@ void display_editor_main_menu() {
 
     while (!exit_requested) {
         check_and_handle_resize();
+        output_profile.main_region = OUTPUT_REGION_MENU;
         if (!main_win || !input_win || !status_win) {
             if(exit_requested) break;
             napms(100);
@@ -1000,12 +4492,14 @@ void display_editor_main_menu() {
             }
         }
         mvwprintw(main_win, getmaxy(main_win) - 2, MAIN_WIN_BORDER_WIDTH, "Use UP/DOWN, ENTER, Number, or Q.");
-        wrefresh(main_win);
+        refresh_window(main_win);
 
-        werase(input_win); draw_custom_box(input_win); wrefresh(input_win);
+        werase(input_win); draw_custom_box(input_win); refresh_window(input_win);
         clear_status();
+        poll_background_backup();
+        end_output_frame();
 
-        key = wgetch(main_win);
+        key = read_key(main_win);
         if (key == ERR && !exit_requested) { continue; }
 
         switch (key) {
@@ -1014,35 +4508,120 @@ void display_editor_main_menu() {
             case KEY_ACTION_SELECT:
             case KEY_ACTION_ENTER:
                 if (choice == 0) add_new_customer_screen();
-                else if (choice == 1) customer_search_workflow("EDIT CUSTOMER SEARCH", "Enter ID or part of Name, Contact, Email, City.", INTERACTIVE_LIST_ACTION_EDIT);
-                else if (choice == 2) customer_search_workflow("DELETE CUSTOMER SEARCH", "Enter ID or part of Name, Contact, Email, City.", INTERACTIVE_LIST_ACTION_DELETE);
+                else if (choice == 1) customer_search_workflow("EDIT CUSTOMER SEARCH", "Enter ID or part of Name, Contact, Email, City; @ZIP [km] nearby; + (newest), +DAYS or +FROM..TO by date added.", INTERACTIVE_LIST_ACTION_EDIT);
+                else if (choice == 2) customer_search_workflow("DELETE CUSTOMER SEARCH", "Enter ID or part of Name, Contact, Email, City; @ZIP [km] nearby; + (newest), +DAYS or +FROM..TO by date added.", INTERACTIVE_LIST_ACTION_DELETE);
                 else if (choice == 3) { execute_gextux_crm(); return; }
-                else if (choice == 4) exit_requested = 1;
+                else if (choice == 4) backup_database_screen();
+                else if (choice == 5) switch_database_screen();
+                else if (choice == 6) exit_requested = 1;
                 break;
             case '1': add_new_customer_screen(); break;
-            case '2': customer_search_workflow("EDIT CUSTOMER SEARCH", "Enter ID or part of Name, Contact, Email, City.", INTERACTIVE_LIST_ACTION_EDIT); break;
-            case '3': customer_search_workflow("DELETE CUSTOMER SEARCH", "Enter ID or part of Name, Contact, Email, City.", INTERACTIVE_LIST_ACTION_DELETE); break;
+            case '2': customer_search_workflow("EDIT CUSTOMER SEARCH", "Enter ID or part of Name, Contact, Email, City; @ZIP [km] nearby; + (newest), +DAYS or +FROM..TO by date added.", INTERACTIVE_LIST_ACTION_EDIT); break;
+            case '3': customer_search_workflow("DELETE CUSTOMER SEARCH", "Enter ID or part of Name, Contact, Email, City; @ZIP [km] nearby; + (newest), +DAYS or +FROM..TO by date added.", INTERACTIVE_LIST_ACTION_DELETE); break;
             case '4': execute_gextux_crm(); return;
+            case '5': backup_database_screen(); break;
+            case '6': switch_database_screen(); break;
+            case KEY_ACTION_PROFILER: toggle_output_overlay(); break;
+            case KEY_ACTION_MEMORY: case KEY_ACTION_MEMORY_ALT: show_memory_usage(); napms(2500); break;
             case KEY_ACTION_QUIT:
             case KEY_ACTION_QUIT_ALT:
                 exit_requested = 1;
                 break;
             default:
-                 if (key >= '1' && key <= '4') {
+                 if (key >= '1' && key <= '6') {
                     choice = key - '1';
                     ungetch(KEY_ACTION_SELECT);
                  } else {
-                    show_status("Invalid choice. Use Arrows, Numbers (1-4), or Q."); beep(); napms(1000);
+                    show_status("Invalid choice. Use Arrows, Numbers (1-6), or Q."); beep(); napms(1000);
                  }
                  break;
         }
     }
 }
 
+void backup_database_screen() {
+    output_profile.main_region = OUTPUT_REGION_FORM;
+    int percent;
+    if (get_backup_progress(&percent)) {
+        show_status("A backup is already running (%d%%).", percent); napms(1000);
+        return;
+    }
+
+    char default_dest[MAX_STR_LEN + 24], dest[MAX_STR_LEN];
+    char stamp[20];
+    time_t now = time(NULL);
+    strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", localtime(&now));
+    snprintf(default_dest, sizeof(default_dest), "%s.%s.bak", shards[0].path, stamp);
+
+    int input_res = get_string_input(input_win, INPUT_PROMPT_Y, INPUT_PROMPT_X, "Backup file (replaced if it exists)", dest, sizeof(dest), false, default_dest);
+    if (input_res != 1 || strcmp(dest, CANCEL_INPUT_STRING) == 0) {
+        show_status("Backup cancelled."); napms(700);
+        return;
+    }
+    if (strcmp(dest, shards[0].path) == 0) {
+        show_error("The backup file must differ from the database itself."); napms(1000);
+        return;
+    }
+
+    if (!start_background_backup(dest)) {
+        show_error("Could not start the backup to '%s'.", dest); napms(1000);
+        return;
+    }
+    wtimeout(main_win, BACKGROUND_POLL_MS); // Wake the screens up to redraw the progress until the backup is done.
+    show_status("Backing up '%s' to '%s' in the background...", shards[0].path, dest);
+}
+
+void switch_database_screen() {
+    output_profile.main_region = OUTPUT_REGION_FORM;
+    cchar_t title_sep_char;
+    setcchar(&title_sep_char, (const wchar_t[]){WC_RF_TITLE_SEP_CHAR, L'\0'}, A_NORMAL, 0, NULL);
+
+    werase(main_win); draw_custom_box(main_win);
+    const char *form_title_text = "SWITCH DATABASE";
+    mvwprintw(main_win, SCREEN_TITLE_Y, (getmaxx(main_win) - strlen(form_title_text)) / 2, "%s", form_title_text);
+    int sep_len = strlen(form_title_text);
+    if (sep_len < MIN_SEPARATOR_WIDTH) sep_len = MIN_SEPARATOR_WIDTH;
+    int max_sep_len = getmaxx(main_win) - (2 * MAIN_WIN_BORDER_WIDTH);
+    if (max_sep_len < 0) max_sep_len = 0;
+    if (sep_len > max_sep_len) sep_len = max_sep_len;
+    if (sep_len > 0) {
+        wmove(main_win, SCREEN_SEPARATOR_Y, (getmaxx(main_win) - sep_len) / 2);
+        for (int k = 0; k < sep_len; ++k) wadd_wch(main_win, &title_sep_char);
+    }
+
+    // The current databases are the default answer, as a comma-separated list like -d takes.
+    char current[MAX_STR_LEN] = "", paths[MAX_STR_LEN];
+    int y = SCREEN_CONTENT_Y_STD, text_w = getmaxx(main_win) - 2 * MAIN_WIN_BORDER_WIDTH - 4;
+    mvwprintw(main_win, y++, MAIN_WIN_BORDER_WIDTH, "Open:");
+    for (int i = 0; i < shard_count; ++i) {
+        if (i > 0) strncat(current, ",", sizeof(current) - strlen(current) - 1);
+        strncat(current, shards[i].path, sizeof(current) - strlen(current) - 1);
+        if (y < getmaxy(main_win) - 2) { wmove(main_win, y++, MAIN_WIN_BORDER_WIDTH + 2); draw_text_cols(main_win, shards[i].path, NULL, text_w, false); }
+    }
+    if (y < getmaxy(main_win) - 2) mvwprintw(main_win, y++, MAIN_WIN_BORDER_WIDTH, "Kept open (instant to switch back to):%s", db_pool_count == 0 ? " none" : "");
+    for (int i = 0; i < db_pool_count && y < getmaxy(main_win) - 2; ++i) {
+        wmove(main_win, y++, MAIN_WIN_BORDER_WIDTH + 2);
+        draw_text_cols(main_win, db_pool[i].path, NULL, text_w, false);
+    }
+    refresh_window(main_win);
+
+    int input_res = get_string_input(input_win, INPUT_PROMPT_Y, INPUT_PROMPT_X, "Database file(s), comma-separated", paths, sizeof(paths), false, current);
+    if (input_res != 1 || strcmp(paths, CANCEL_INPUT_STRING) == 0) {
+        show_status("Switch cancelled."); napms(700);
+        return;
+    }
+    long long started_ms = monotonic_ms();
+    show_loading_indicator(true);
+    int switched = switch_db_shards(paths);
+    show_loading_indicator(false);
+    if (!switched) { napms(1500); return; }
+    show_status("Switched to '%s' in %lld ms.", paths, monotonic_ms() - started_ms); napms(1000);
+}
+
 void add_new_customer_screen() {
-    Client new_client;
-    memset(&new_client, 0, sizeof(Client));
-    strcpy(new_client.status, "Active");
+    output_profile.main_region = OUTPUT_REGION_FORM;
+    Client *new_client = client_new();
+    if (!new_client) { show_error("Memory allocation failed for the new customer."); return; }
 
     cchar_t title_sep_char;
     setcchar(&title_sep_char, (const wchar_t[]){WC_RF_TITLE_SEP_CHAR, L'\0'}, A_NORMAL, 0, NULL);
@@ -1064,64 +4643,316 @@ void add_new_customer_screen() {
     }
 
     mvwprintw(main_win, SCREEN_CONTENT_Y_STD, MAIN_WIN_BORDER_WIDTH, "ESC cancels field, type '%s' and Enter to abort all.", CANCEL_INPUT_STRING);
-    wrefresh(main_win);
+    refresh_window(main_win);
 
     int input_res;
-    #define GET_STR_FIELD(prompt_str, field_name, max_len_val, allow_empty_val, current_val_display_ptr) \
-        input_res = get_string_input(input_win, INPUT_PROMPT_Y, INPUT_PROMPT_X, prompt_str, new_client.field_name, max_len_val, allow_empty_val, current_val_display_ptr); \
+    #define GET_STR_FIELD(prompt_str, field, allow_empty_val) \
+        input_res = get_client_text_input(prompt_str, &new_client, field, allow_empty_val, NULL); \
         if (input_res == -1) { \
             show_status("Field input cancelled. Field is empty/default."); napms(700); \
         } else if (input_res == 0) { \
-            show_status("Aborting add customer due to invalid input."); napms(1000); return; \
+            show_status("Aborting add customer due to invalid input."); napms(1000); client_free(new_client); return; \
         } \
-        if (input_res == 1 && strcmp(new_client.field_name, CANCEL_INPUT_STRING) == 0) { \
-            show_status("Add customer cancelled by user."); napms(1000); return; \
+        if (input_res == 1 && strcmp(client_text(new_client, field), CANCEL_INPUT_STRING) == 0) { \
+            show_status("Add customer cancelled by user."); napms(1000); client_free(new_client); return; \
         }
 
-    GET_STR_FIELD("Business Name*", business_name, MAX_STR_LEN, false, NULL);
-    GET_STR_FIELD("Email", email, MAX_STR_LEN, true, NULL);
-    GET_STR_FIELD("Phone", phone, MAX_STR_LEN, true, NULL);
-    GET_STR_FIELD("Website", website, MAX_STR_LEN, true, NULL);
-    GET_STR_FIELD("Street", street, MAX_STR_LEN, true, NULL);
-    GET_STR_FIELD("City", city, MAX_STR_LEN, true, NULL);
-    GET_STR_FIELD("State", state, MAX_STR_LEN, true, NULL);
-    GET_STR_FIELD("Zip Code", zip_code, sizeof(new_client.zip_code), true, NULL);
-    GET_STR_FIELD("Country", country, MAX_STR_LEN, true, NULL);
-    GET_STR_FIELD("Tax Number", tax_number, MAX_STR_LEN, true, NULL);
+    GET_STR_FIELD("Business Name*", CF_BUSINESS_NAME, false);
+    GET_STR_FIELD("Email", CF_EMAIL, true);
+    GET_STR_FIELD("Phone", CF_PHONE, true);
+    GET_STR_FIELD("Website", CF_WEBSITE, true);
+    GET_STR_FIELD("Street", CF_STREET, true);
+    GET_STR_FIELD("City", CF_CITY, true);
+    GET_STR_FIELD("State", CF_STATE, true);
+    GET_STR_FIELD("Zip Code", CF_ZIP_CODE, true);
+    GET_STR_FIELD("Country", CF_COUNTRY, true);
+    GET_STR_FIELD("Tax Number", CF_TAX_NUMBER, true);
+
+    input_res = get_int_input(input_win, INPUT_PROMPT_Y, INPUT_PROMPT_X, "Num Employees", &new_client->num_employees, 0);
+    if (input_res == -1) { show_status("Field input cancelled. Using default 0."); new_client->num_employees = 0; napms(700); }
+    else if (input_res == 0) { show_status("Aborting add customer due to invalid input."); napms(1000); client_free(new_client); return; }
+
+    GET_STR_FIELD("Industry", CF_INDUSTRY, true);
+    GET_STR_FIELD("Contact Person", CF_CONTACT_PERSON, true);
+    GET_STR_FIELD("Contact Email", CF_CONTACT_EMAIL, true);
+    GET_STR_FIELD("Contact Phone", CF_CONTACT_PHONE, true);
+
+    char status[MAX_STR_LEN] = "Active";
+    input_res = select_client_status(status, "Active");
+    if (input_res == -1) { strcpy(status, "Active"); show_status("Status selection cancelled. Defaulting to 'Active'."); napms(700); }
+    if (!client_set_text(&new_client, CF_STATUS, status)) { show_error("Memory allocation failed for the new customer."); client_free(new_client); return; }
 
-    input_res = get_int_input(input_win, INPUT_PROMPT_Y, INPUT_PROMPT_X, "Num Employees", &new_client.num_employees, 0);
-    if (input_res == -1) { show_status("Field input cancelled. Using default 0."); new_client.num_employees = 0; napms(700); }
-    else if (input_res == 0) { show_status("Aborting add customer due to invalid input."); napms(1000); return; }
-
-    GET_STR_FIELD("Industry", industry, MAX_STR_LEN, true, NULL);
-    GET_STR_FIELD("Contact Person", contact_person, MAX_STR_LEN, true, NULL);
-    GET_STR_FIELD("Contact Email", contact_email, MAX_STR_LEN, true, NULL);
-    GET_STR_FIELD("Contact Phone", contact_phone, MAX_STR_LEN, true, NULL);
-
-    input_res = select_client_status(new_client.status, "Active");
-    if (input_res == -1) { strcpy(new_client.status, "Active"); show_status("Status selection cancelled. Defaulting to 'Active'."); napms(700); }
+    #undef GET_STR_FIELD
 
+    char *notes_buf = malloc(MAX_NOTES_LEN);
+    if (!notes_buf) { show_error("Memory allocation failed for notes."); client_free(new_client); return; }
     show_status("Enter Notes (up to %d chars):", MAX_NOTES_LEN -1); napms(500);
-    GET_STR_FIELD("Notes", notes, MAX_NOTES_LEN, true, NULL);
-    #undef GET_STR_FIELD
+    input_res = get_string_input(input_win, INPUT_PROMPT_Y, INPUT_PROMPT_X, NOTES_PROMPT, notes_buf, MAX_NOTES_LEN, true, NULL);
+    if (input_res == -1) { show_status("Field input cancelled. Field is empty/default."); napms(700); }
+    if (input_res == 1 && strcmp(notes_buf, CANCEL_INPUT_STRING) == 0) {
+        free(notes_buf); client_free(new_client);
+        show_status("Add customer cancelled by user."); napms(1000); return;
+    }
+    new_client->notes = notes_buf;
 
     werase(input_win); draw_custom_box(input_win);
-    mvwprintw(input_win, INPUT_PROMPT_Y, INPUT_PROMPT_X, "Save new customer '%s'? (Y/N): ", new_client.business_name);
-    wrefresh(input_win);
-    int confirm_key = wgetch(input_win);
-    werase(input_win); draw_custom_box(input_win); wrefresh(input_win);
+    mvwprintw(input_win, INPUT_PROMPT_Y, INPUT_PROMPT_X, "Save new customer '%s'? (Y/N): ", client_text(new_client, CF_BUSINESS_NAME));
+    refresh_window(input_win);
+    int confirm_key = read_key(input_win);
+    werase(input_win); draw_custom_box(input_win); refresh_window(input_win);
 
     if (toupper(confirm_key) == 'Y') {
         show_loading_indicator(true);
-        if (db_insert_client(&new_client)) show_status("Customer '%s' added.", new_client.business_name);
+        if (db_insert_client(new_client)) show_status("Customer '%s' added.", client_text(new_client, CF_BUSINESS_NAME));
         show_loading_indicator(false);
     } else {
         show_status("Add customer cancelled.");
     }
+    free(notes_buf);
+    client_free(new_client);
     napms(1500);
 }
 
+char *build_radius_search_sql(const char *search_term, unsigned columns) {
+    // "@ZIP" or "@ZIP RADIUS[km]"; zip codes may contain spaces, so only a numeric last word is the radius.
+    char zip[MAX_STR_LEN];
+    snprintf(zip, sizeof(zip), "%s", search_term + 1);
+    double radius_km = RADIUS_DEFAULT_KM;
+    char *last_space = strrchr(zip, ' ');
+    if (last_space) {
+        char *end_ptr;
+        double value = strtod(last_space + 1, &end_ptr);
+        if (end_ptr != last_space + 1 && (*end_ptr == '\0' || strcasecmp(end_ptr, "km") == 0)) {
+            radius_km = value;
+            while (last_space > zip && last_space[-1] == ' ') last_space--;
+            *last_space = '\0';
+        }
+    }
+    size_t zip_start = strspn(zip, " ");
+    if (zip[zip_start] == '\0') {
+        show_error("Radius search needs a zip code: %cZIP [km].", RADIUS_SEARCH_PREFIX);
+        return NULL;
+    }
+    if (!(radius_km > 0 && radius_km <= RADIUS_MAX_KM)) {
+        show_error("Radius must be between 0 and %.0f km.", RADIUS_MAX_KM);
+        return NULL;
+    }
+
+    // The code is looked up once, in the first database that knows it; the coordinates then go into the query text,
+    // so every shard ranks its customers around the same point.
+    double lat = 0, lon = 0;
+    int found = 0;
+    for (int i = 0; i < shard_count && !found; ++i) {
+        sqlite3_stmt *stmt = NULL;
+        if (sqlite3_prepare_v2(shards[i].conn, "SELECT latitude, longitude FROM zip_locations WHERE zip_code = ?1;", -1, &stmt, NULL) == SQLITE_OK) {
+            sqlite3_bind_text(stmt, 1, zip + zip_start, -1, SQLITE_STATIC);
+            if (sqlite3_step(stmt) == SQLITE_ROW) {
+                lat = sqlite3_column_double(stmt, 0);
+                lon = sqlite3_column_double(stmt, 1);
+                found = 1;
+            }
+        }
+        sqlite3_finalize(stmt);
+    }
+    if (!found) {
+        show_error("Unknown zip code '%s' (load coordinates with --import-zips).", zip + zip_start);
+        return NULL;
+    }
+
+    // The R*Tree only sees the bounding box of the circle; the exact distance then filters and ranks the candidates.
+    double dlat = radius_km / KM_PER_DEGREE_LAT;
+    double cos_lat = cos(lat * M_PI / 180.0);
+    double dlon = cos_lat > 0.01 ? radius_km / (KM_PER_DEGREE_LAT * cos_lat) : 360.0;
+    double lon_lo = lon - dlon, lon_hi = lon + dlon;
+    if (lon_lo < -180.0 || lon_hi > 180.0) { lon_lo = -180.0; lon_hi = 180.0; } // The box wraps around: scan every longitude.
+    char select_list[LIST_SELECT_SQL_LEN];
+    build_list_columns_sql(columns, "c.", select_list, sizeof(select_list));
+    return sqlite3_mprintf(
+        "SELECT %s, distance_km(%.7f, %.7f, l.min_lat, l.min_lon) AS km "
+        "FROM client_locations l JOIN clients c ON c.id = l.id "
+        "WHERE l.min_lat <= %.7f AND l.max_lat >= %.7f AND l.min_lon <= %.7f AND l.max_lon >= %.7f "
+        "AND distance_km(%.7f, %.7f, l.min_lat, l.min_lon) <= %.3f%z "
+        "ORDER BY km, c.business_name COLLATE NOCASE;",
+        select_list, lat, lon, lat + dlat, lat - dlat, lon_hi, lon_lo, lat, lon, radius_km, build_status_filter_sql("c.status"));
+}
+
+int created_stamp(const char *time_value, const char *modifier, char out[DATETIME_STR_LEN + 1]) {
+    // A day must come back unchanged from a no-op modifier: SQLite would quietly roll 2025-02-30 over into March.
+    sqlite3_stmt *stmt = NULL;
+    int ok = 0;
+    if (sqlite3_prepare_v2(db, "SELECT datetime(?1, ?2) WHERE ?1 = 'now' OR date(?1, '+0 days') IS ?1;", -1, &stmt, NULL) == SQLITE_OK) {
+        sqlite3_bind_text(stmt, 1, time_value, -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, modifier, -1, SQLITE_STATIC);
+        if (sqlite3_step(stmt) == SQLITE_ROW && sqlite3_column_type(stmt, 0) == SQLITE_TEXT) {
+            snprintf(out, DATETIME_STR_LEN + 1, "%s", (const char*)sqlite3_column_text(stmt, 0));
+            ok = 1;
+        }
+    }
+    sqlite3_finalize(stmt);
+    return ok;
+}
+
+int parse_created_search_term(const char *search_term, CreatedRange *range) {
+    // "+" lists everyone, "+N" those added in the last N days, "+DAY" one day and "+FROM..TO" whole days, either end
+    // optional. Days are YYYY-MM-DD in UTC, like the CURRENT_TIMESTAMP values in created_at.
+    const char *spec = search_term + 1;
+    memset(range, 0, sizeof(CreatedRange));
+    if (*spec == '\0') return 1;
+
+    char *end_ptr;
+    long days = strtol(spec, &end_ptr, 10);
+    if (end_ptr != spec && *end_ptr == '\0') {
+        if (days < 1 || days > CREATED_MAX_DAYS) {
+            show_error("Give between 1 and %d days: %cDAYS.", CREATED_MAX_DAYS, CREATED_SEARCH_PREFIX);
+            return 0;
+        }
+        char modifier[32];
+        snprintf(modifier, sizeof(modifier), "-%ld days", days);
+        return created_stamp("now", modifier, range->from);
+    }
+
+    char from_day[MAX_STR_LEN], to_day[MAX_STR_LEN];
+    const char *dots = strstr(spec, "..");
+    if (dots) {
+        snprintf(from_day, sizeof(from_day), "%.*s", (int)(dots - spec), spec);
+        snprintf(to_day, sizeof(to_day), "%s", dots + 2);
+    } else {
+        snprintf(from_day, sizeof(from_day), "%s", spec);
+        snprintf(to_day, sizeof(to_day), "%s", spec);
+    }
+    if ((from_day[0] && !created_stamp(from_day, "+0 days", range->from)) ||
+        (to_day[0] && !created_stamp(to_day, "+1 days", range->to))) {
+        show_error("Dates are YYYY-MM-DD: %cDAYS, %cDAY or %cFROM..TO.", CREATED_SEARCH_PREFIX, CREATED_SEARCH_PREFIX, CREATED_SEARCH_PREFIX);
+        return 0;
+    }
+    if (range->from[0] && range->to[0] && strcmp(range->from, range->to) >= 0) {
+        show_error("The date range ends before it starts.");
+        return 0;
+    }
+    return 1;
+}
+
+char *build_created_range_sql(const CreatedRange *range, const CreatedCursor *cursor, int limit, unsigned columns) {
+    // Every part is a range on idx_clients_created_at read in index order, so a page costs the rows it returns and
+    // is never sorted. After a cursor, the rest of the cursor's second comes first, seeking on created_at and id (a
+    // row value comparison would only seek on created_at and skip a bulk import's rows one by one), then the older
+    // rows; UNION ALL returns its parts in order. The cursor row itself is included; see fetch_created_page.
+    char select_list[LIST_SELECT_SQL_LEN];
+    build_list_columns_sql(columns, "", select_list, sizeof(select_list));
+    char lower[64], upper[64] = "", limit_clause[32] = "";
+    if (range->from[0]) sqlite3_snprintf(sizeof(lower), lower, "created_at >= %Q", range->from);
+    else sqlite3_snprintf(sizeof(lower), lower, "created_at IS NOT NULL");
+    if (range->to[0]) sqlite3_snprintf(sizeof(upper), upper, " AND created_at < %Q", range->to);
+    if (limit > 0) snprintf(limit_clause, sizeof(limit_clause), " LIMIT %d", limit);
+    if (!cursor) {
+        return sqlite3_mprintf("SELECT %s, -CAST(strftime('%%s', created_at) AS INTEGER) FROM clients WHERE %s%s%z ORDER BY created_at DESC, id DESC%s;",
+                               select_list, lower, upper, build_status_filter_sql("status"), limit_clause);
+    }
+    return sqlite3_mprintf(
+        "SELECT * FROM (SELECT %s, -CAST(strftime('%%s', created_at) AS INTEGER) FROM clients "
+        "WHERE created_at = datetime(%lld, 'unixepoch') AND id <= %d%z ORDER BY id DESC%s) "
+        "UNION ALL SELECT * FROM (SELECT %s, -CAST(strftime('%%s', created_at) AS INTEGER) FROM clients "
+        "WHERE %s%s AND created_at < datetime(%lld, 'unixepoch')%z ORDER BY created_at DESC, id DESC%s)%s;",
+        select_list, cursor->created, cursor->id, build_status_filter_sql("status"), limit_clause,
+        select_list, lower, upper, cursor->created, build_status_filter_sql("status"), limit_clause, limit_clause);
+}
+
+int fetch_created_page(const CreatedRange *range, const CreatedCursor *cursor, unsigned columns, ClientList *list, bool *more) {
+    // Another database may hold a row with the cursor's time and id, which sorts after the cursor, so the query keeps
+    // rows equal to it. The ones from the cursor's database or an earlier one were on the previous page: drop them.
+    // Each database returns two rows extra: one such duplicate and one to tell whether another page follows.
+    char *sql_query = build_created_range_sql(range, cursor, CREATED_PAGE_SIZE + 2, columns);
+    if (!sql_query) { show_error("Memory allocation failed for the page query."); return 0; }
+    int ok = fetch_client_list(sql_query, LIST_ORDER_CREATED, list);
+    sqlite3_free(sql_query);
+    if (!ok) return 0;
+    while (cursor && list->count > 0) {
+        const ClientListItem *first = client_list_item(list, 0);
+        if (first->sort_key != -(double)cursor->created || first->id != cursor->id || first->shard > cursor->shard) break;
+        client_list_remove(list, 0);
+    }
+    *more = list->count > CREATED_PAGE_SIZE;
+    if (*more) list->count = CREATED_PAGE_SIZE; // The rows past the page stay unread in the array or spill table.
+    return 1;
+}
+
+// Columns the list does not show are selected as '' so that callbacks, spill tables and the search cache keep one row
+// layout. SQLite then neither reads nor copies them, and a query whose remaining columns an index holds never reads
+// the table. An empty lookup field (a NULL id) is selected as '' too, not as the "N/A" of a missing value.
+void build_list_columns_sql(unsigned columns, const char *prefix, char *buf, size_t size) {
+    int len = snprintf(buf, size, "%sid, %sbusiness_name", prefix, prefix);
+    for (int i = 0; i < LIST_COLUMN_COUNT && len < (int)size; ++i) {
+        const char *table = dictionary_table_for(list_column_specs[i].name);
+        if (!(columns & (1u << i))) len += snprintf(buf + len, size - len, ", ''");
+        else if (table) len += snprintf(buf + len, size - len, ", coalesce((SELECT name FROM %s WHERE id = %s%s_id), '')", table, prefix, list_column_specs[i].name);
+        else len += snprintf(buf + len, size - len, ", %s%s", prefix, list_column_specs[i].name);
+    }
+}
+
+int parse_list_columns(const char *spec, unsigned *columns) {
+    *columns = 0;
+    if (strcmp(spec, "none") == 0) return 1;
+    const char *p = spec;
+    while (*p) {
+        size_t len = strcspn(p, ",");
+        int found = -1;
+        for (int i = 0; i < LIST_COLUMN_COUNT; ++i) {
+            if (strlen(list_column_specs[i].name) == len && strncasecmp(p, list_column_specs[i].name, len) == 0) found = i;
+        }
+        if (found < 0) return 0;
+        *columns |= 1u << found;
+        p += len;
+        if (*p == ',') p++;
+    }
+    return *columns != 0;
+}
+
+char *build_status_filter_sql(const char *column) {
+    // The status is spelled out as a literal: SQLite only uses a partial index if the query names its exact condition.
+    if (list_status_filter < 0) return sqlite3_mprintf("");
+    return sqlite3_mprintf(" AND %s = %Q", column, client_statuses[list_status_filter]);
+}
+
+char *build_customer_search_sql(const char *search_term, unsigned columns, ListOrder *order, CreatedRange *range) {
+    *order = LIST_ORDER_NAME;
+    if (search_term[0] == RADIUS_SEARCH_PREFIX) {
+        *order = LIST_ORDER_DISTANCE;
+        return build_radius_search_sql(search_term, columns);
+    }
+    if (search_term[0] == CREATED_SEARCH_PREFIX) {
+        *order = LIST_ORDER_CREATED;
+        if (!parse_created_search_term(search_term, range)) return NULL;
+        return build_created_range_sql(range, NULL, 0, columns);
+    }
+
+    char *end_ptr;
+    long id_val = strtol(search_term, &end_ptr, 10);
+    char select_list[LIST_SELECT_SQL_LEN];
+    build_list_columns_sql(columns, "", select_list, sizeof(select_list));
+
+    if (*end_ptr == '\0' && search_term != end_ptr) { // An ID names one customer, whatever the status filter.
+        return sqlite3_mprintf("SELECT %s FROM clients WHERE id = %ld ORDER BY business_name COLLATE NOCASE;", select_list, id_val);
+    }
+    if (search_term[0] == '\0') { // Browse every customer with the filtered status.
+        return sqlite3_mprintf("SELECT %s FROM clients WHERE 1%z "
+                               "ORDER BY business_name COLLATE NOCASE;", select_list, build_status_filter_sql("status"));
+    }
+    char *pattern = sqlite3_mprintf("%%%s%%", search_term);
+    if (!pattern) { show_error("Memory allocation failed for search pattern."); return NULL; }
+    char *sql_query = sqlite3_mprintf(
+        "SELECT %s FROM clients "
+        "WHERE (business_name LIKE %Q "
+        "OR contact_person LIKE %Q "
+        "OR email LIKE %Q "
+        "OR city_id IN (SELECT id FROM cities WHERE name LIKE %Q))%z "
+        "ORDER BY business_name COLLATE NOCASE;",
+        select_list, pattern, pattern, pattern, pattern, build_status_filter_sql("status"));
+    sqlite3_free(pattern);
+    return sql_query;
+}
+
 void customer_search_workflow(const char *screen_title, const char *search_prompt_detail, InteractiveListAction action) {
+    output_profile.main_region = OUTPUT_REGION_FORM;
     char search_term[MAX_STR_LEN];
     char *sql_query = NULL;
 
@@ -1144,140 +4975,819 @@ void customer_search_workflow(const char *screen_title, const char *search_promp
     }
 
     mvwprintw(main_win, SCREEN_CONTENT_Y_STD, MAIN_WIN_BORDER_WIDTH, "%s", search_prompt_detail);
-    wrefresh(main_win);
+    if (list_status_filter >= 0) {
+        mvwprintw(main_win, SCREEN_CONTENT_Y_STD + 1, MAIN_WIN_BORDER_WIDTH,
+                  "Only %s customers are listed (F in the list changes this); leave the term empty to browse them all.",
+                  client_statuses[list_status_filter]);
+    } else {
+        mvwprintw(main_win, SCREEN_CONTENT_Y_STD + 1, MAIN_WIN_BORDER_WIDTH, "Customers of every status are listed (F in the list filters them).");
+    }
+    refresh_window(main_win);
 
-    if (get_string_input(input_win, INPUT_PROMPT_Y, INPUT_PROMPT_X, "Search", search_term, MAX_STR_LEN, false, NULL) <= 0) {
+    if (get_string_input(input_win, INPUT_PROMPT_Y, INPUT_PROMPT_X, "Search", search_term, MAX_STR_LEN, list_status_filter >= 0, NULL) <= 0) {
         show_status("Search cancelled or empty input."); napms(1000);
         return;
     }
-    if (strlen(search_term) == 0) {
+    size_t term_len = strlen(search_term);
+    while (term_len > 0 && isspace((unsigned char)search_term[term_len - 1])) search_term[--term_len] = '\0';
+    size_t term_start = strspn(search_term, " \t");
+    if (term_start > 0) memmove(search_term, search_term + term_start, term_len - term_start + 1);
+    if (strlen(search_term) == 0 && list_status_filter < 0) {
         show_status("Search term cannot be empty."); napms(1000);
         return;
     }
 
-    char *end_ptr;
-    long id_val = strtol(search_term, &end_ptr, 10);
+    bool refilter = true;
+    while (refilter) { // The list returns when F changed the status filter; the same search then runs again.
+        ListOrder order;
+        CreatedRange range;
+        unsigned columns = visible_list_columns(); // Only what the list pane can show is fetched.
+        sql_query = build_customer_search_sql(search_term, columns, &order, &range);
+        if (!sql_query) return; // The reason was already shown.
+
+        char *cache_key = build_search_cache_key(search_term, action, columns);
+        refilter = display_interactive_client_list(screen_title, sql_query, cache_key, action, order, columns, order == LIST_ORDER_CREATED ? &range : NULL);
+        select_db_shard(0);
+        sqlite3_free(cache_key);
+        sqlite3_free(sql_query);
+    }
+}
+
+
+void edit_customer_form_screen(int client_id) {
+    output_profile.main_region = OUTPUT_REGION_FORM;
+    Client *client, *original_client;
+
+    cchar_t title_sep_char;
+    setcchar(&title_sep_char, (const wchar_t[]){WC_RF_TITLE_SEP_CHAR, L'\0'}, A_NORMAL, 0, NULL);
+
+    if (!fetch_client_by_id(client_id, &original_client)) {
+        show_error("Could not fetch details for customer ID %d to edit.", client_id);
+        return;
+    }
+    client = client_ref(original_client); // Shares the fetched record until a field changes.
+
+    werase(main_win); draw_custom_box(main_win);
+    char form_title_text[MAX_STR_LEN + 50];
+    snprintf(form_title_text, sizeof(form_title_text), "--- Edit Customer: %s (ID: %d) ---", client_text(client, CF_BUSINESS_NAME), client->id);
+    TextWidth form_title_tw = measure_text_width(form_title_text);
+    int form_title_max = getmaxx(main_win) - 2;
+    wmove(main_win, SCREEN_TITLE_Y, form_title_tw.cols < form_title_max ? (getmaxx(main_win) - form_title_tw.cols) / 2 : 1);
+    draw_text_cols(main_win, form_title_text, &form_title_tw, form_title_max, false);
+
+    int sep_len = form_title_tw.cols;
+    if (sep_len < MIN_SEPARATOR_WIDTH) sep_len = MIN_SEPARATOR_WIDTH;
+    int max_sep_len = getmaxx(main_win) - (2 * MAIN_WIN_BORDER_WIDTH);
+    if (max_sep_len < 0) max_sep_len = 0;
+    if (sep_len > max_sep_len) sep_len = max_sep_len;
+
+    if (sep_len > 0) {
+        int sep_x = (getmaxx(main_win) - sep_len) / 2;
+        wmove(main_win, SCREEN_SEPARATOR_Y, sep_x);
+        for (int k = 0; k < sep_len; ++k) wadd_wch(main_win, &title_sep_char);
+    }
+
+    mvwprintw(main_win, SCREEN_CONTENT_Y_STD, MAIN_WIN_BORDER_WIDTH, "Enter to keep current, ESC cancels field, type '%s' and Enter to abort all.", CANCEL_INPUT_STRING);
+    refresh_window(main_win);
+
+    int input_res;
+    #define EDIT_STR_FIELD(prompt_str, field, allow_empty_val) \
+        input_res = get_client_text_input(prompt_str, &client, field, allow_empty_val, client_text(original_client, field)); \
+        if (input_res == -1) { \
+            show_status("Field edit cancelled, value reverted."); napms(700); \
+        } else if (input_res == 0) { \
+            show_status("Aborting edit due to invalid input."); napms(1000); client_free(client); client_free(original_client); return; \
+        } \
+        if (input_res == 1 && strcmp(client_text(client, field), CANCEL_INPUT_STRING) == 0) { \
+            show_status("Edit customer cancelled by user."); napms(1000); client_free(client); client_free(original_client); return; \
+        }
+
+    EDIT_STR_FIELD("Business Name*", CF_BUSINESS_NAME, false);
+    EDIT_STR_FIELD("Email", CF_EMAIL, true);
+    EDIT_STR_FIELD("Phone", CF_PHONE, true);
+    EDIT_STR_FIELD("Website", CF_WEBSITE, true);
+    EDIT_STR_FIELD("Street", CF_STREET, true);
+    EDIT_STR_FIELD("City", CF_CITY, true);
+    EDIT_STR_FIELD("State", CF_STATE, true);
+    EDIT_STR_FIELD("Zip Code", CF_ZIP_CODE, true);
+    EDIT_STR_FIELD("Country", CF_COUNTRY, true);
+    EDIT_STR_FIELD("Tax Number", CF_TAX_NUMBER, true);
+
+    int num_employees = original_client->num_employees;
+    input_res = get_int_input(input_win, INPUT_PROMPT_Y, INPUT_PROMPT_X, "Num Employees", &num_employees, original_client->num_employees);
+    if (input_res == -1) { num_employees = original_client->num_employees; show_status("Field edit cancelled, value reverted."); napms(700); }
+    else if (input_res == 0) { show_status("Aborting edit due to invalid input."); napms(1000); client_free(client); client_free(original_client); return; }
+    if (num_employees != client->num_employees) {
+        if (!client_mutable(&client)) { show_error("Memory allocation failed while editing."); client_free(client); client_free(original_client); return; }
+        client->num_employees = num_employees;
+    }
+
+    EDIT_STR_FIELD("Industry", CF_INDUSTRY, true);
+    EDIT_STR_FIELD("Contact Person", CF_CONTACT_PERSON, true);
+    EDIT_STR_FIELD("Contact Email", CF_CONTACT_EMAIL, true);
+    EDIT_STR_FIELD("Contact Phone", CF_CONTACT_PHONE, true);
+
+    char status[MAX_STR_LEN];
+    snprintf(status, sizeof(status), "%s", client_text(original_client, CF_STATUS));
+    input_res = select_client_status(status, client_text(original_client, CF_STATUS));
+    if (input_res == -1) { show_status("Status selection cancelled, value reverted."); napms(700); }
+    else if (!client_set_text(&client, CF_STATUS, status)) { show_error("Memory allocation failed while editing."); client_free(client); client_free(original_client); return; }
+
+    #undef EDIT_STR_FIELD
+
+    char *original_notes = client->notes_len > 0 ? db_read_client_notes(client->id) : calloc(1, 1);
+    char *notes_buf = malloc(MAX_NOTES_LEN);
+    if (!original_notes || !notes_buf || !client_mutable(&client)) {
+        free(original_notes); free(notes_buf);
+        show_error("Could not load notes for customer ID %d.", client->id);
+        client_free(client); client_free(original_client);
+        return;
+    }
+    show_status("Edit Notes (up to %d chars):", MAX_NOTES_LEN -1); napms(500);
+    input_res = get_string_input(input_win, INPUT_PROMPT_Y, INPUT_PROMPT_X, NOTES_PROMPT, notes_buf, MAX_NOTES_LEN, true, original_notes);
+    if (input_res == -1) { show_status("Field edit cancelled, value reverted."); napms(700); }
+    if (input_res == 1 && strcmp(notes_buf, CANCEL_INPUT_STRING) == 0) {
+        free(original_notes); free(notes_buf); client_free(client); client_free(original_client);
+        show_status("Edit customer cancelled by user."); napms(1000); return;
+    }
+    client->notes = strcmp(notes_buf, original_notes) == 0 ? NULL : notes_buf; // NULL leaves the stored notes untouched.
+
+    werase(input_win); draw_custom_box(input_win);
+    mvwprintw(input_win, INPUT_PROMPT_Y, INPUT_PROMPT_X, "Save changes to '%s'? (Y/N): ", client_text(client, CF_BUSINESS_NAME));
+    refresh_window(input_win);
+    int confirm_key = read_key(input_win);
+    werase(input_win); draw_custom_box(input_win); refresh_window(input_win);
+
+    if (toupper(confirm_key) == 'Y') {
+        show_loading_indicator(true);
+        int saved = db_update_client(client);
+        bool merged = false;
+        // Another user saved this customer while it was being edited: merge their version and save on top of it.
+        while (saved == DB_UPDATE_CONFLICT) {
+            Client *theirs;
+            if (!fetch_client_by_id(client->id, &theirs)) {
+                show_error("Customer ID %d was deleted by another user; changes not saved.", client->id);
+                break;
+            }
+            char *their_notes = theirs->notes_len > 0 ? db_read_client_notes(client->id) : calloc(1, 1);
+            if (!their_notes) {
+                client_free(theirs);
+                show_error("Could not load notes for customer ID %d.", client->id);
+                break;
+            }
+            show_loading_indicator(false);
+            show_status("Another user saved this customer meanwhile; merging their changes.");
+            int merge_res = merge_client_edits(original_client, original_notes, &client, theirs, their_notes);
+            free(original_notes);
+            original_notes = their_notes;
+            client_free(original_client);
+            original_client = theirs;
+            if (!merge_res) {
+                show_status("Edit customer cancelled. No changes saved.");
+                break;
+            }
+            merged = true;
+            show_loading_indicator(true);
+            saved = db_update_client(client);
+        }
+        show_loading_indicator(false);
+        if (saved == 1) show_status(merged ? "Customer '%s' updated, merged with another user's changes." : "Customer '%s' updated.", client_text(client, CF_BUSINESS_NAME));
+    } else {
+        show_status("Edit customer cancelled. No changes saved.");
+    }
+    free(original_notes); free(notes_buf);
+    client_free(client); client_free(original_client);
+    napms(1500);
+}
+
+// Fields changed only by the other user take their value; the user picks for each field both sides changed differently.
+int merge_client_edits(const Client *base, const char *base_notes, Client **mine, const Client *theirs, const char *their_notes) {
+    size_t field_count = sizeof(cli_client_fields) / sizeof(cli_client_fields[0]);
+    if (!client_mutable(mine)) return 0;
+    for (size_t i = 0; i <= field_count; ++i) {
+        const CliClientField *field = i < field_count ? &cli_client_fields[i] : NULL; // NULL stands for the notes.
+        if (field && !field->writable) continue;
+        char my_text[MAX_STR_LEN], their_text[MAX_STR_LEN];
+        bool take_theirs = false;
+        if (!field) {
+            if (!(*mine)->notes || strcmp(base_notes, their_notes) == 0 || strcmp((*mine)->notes, their_notes) == 0) continue;
+            snprintf(my_text, sizeof(my_text), "%zu bytes", strlen((*mine)->notes));
+            snprintf(their_text, sizeof(their_text), "%zu bytes", strlen(their_notes));
+        } else if (field->text_field >= 0) {
+            const char *base_value = client_text(base, field->text_field), *their_value = client_text(theirs, field->text_field);
+            const char *my_value = client_text(*mine, field->text_field);
+            if (strcmp(base_value, their_value) == 0) continue;
+            take_theirs = strcmp(base_value, my_value) == 0 || strcmp(my_value, their_value) == 0;
+            snprintf(my_text, sizeof(my_text), "%s", my_value);
+            snprintf(their_text, sizeof(their_text), "%s", their_value);
+        } else {
+            int base_value = *(const int*)((const char*)base + field->offset), their_value = *(const int*)((const char*)theirs + field->offset);
+            int my_value = *(const int*)((const char*)*mine + field->offset);
+            if (base_value == their_value) continue;
+            take_theirs = base_value == my_value || my_value == their_value;
+            snprintf(my_text, sizeof(my_text), "%d", my_value);
+            snprintf(their_text, sizeof(their_text), "%d", their_value);
+        }
+
+        if (!take_theirs) {
+            char prompt[3 * MAX_STR_LEN];
+            snprintf(prompt, sizeof(prompt), "Both changed %s - keep (M)ine or (T)heirs? ESC cancels. Mine: '%s' Theirs: '%s'",
+                     field ? field->name : "notes", my_text, their_text);
+            TextWidth prompt_tw = measure_text_width(prompt);
+            int key;
+            bool redraw = true;
+            wtimeout(input_win, BACKGROUND_POLL_MS); // Wake up to follow a resize and to report a finished backup.
+            do {
+                if (resize_pending) { check_and_handle_resize(); redraw = true; }
+                if (!input_win) return 0;
+                if (redraw) {
+                    werase(input_win); draw_custom_box(input_win);
+                    wmove(input_win, INPUT_PROMPT_Y, INPUT_PROMPT_X);
+                    draw_text_cols(input_win, prompt, &prompt_tw, getmaxx(input_win) - 2 * INPUT_PROMPT_X, false);
+                    refresh_window(input_win);
+                    redraw = false;
+                }
+                poll_background_backup();
+                key = read_key(input_win);
+                if (key == KEY_RESIZE) redraw = true;
+                else if (key >= 0 && key <= UCHAR_MAX) key = toupper(key);
+            } while (key != 'M' && key != 'T' && key != KEY_ESC && !exit_requested);
+            wtimeout(input_win, -1);
+            werase(input_win); draw_custom_box(input_win); refresh_window(input_win);
+            if (key != 'M' && key != 'T') return 0;
+            take_theirs = key == 'T';
+        }
+        if (!take_theirs) continue;
+        if (!field) {
+            (*mine)->notes = NULL; // NULL keeps the stored notes, which are theirs.
+        } else if (field->text_field < 0) {
+            *(int*)((char*)*mine + field->offset) = *(const int*)((const char*)theirs + field->offset);
+        } else if (!client_set_text(mine, field->text_field, client_text(theirs, field->text_field))) {
+            return 0;
+        }
+    }
+    (*mine)->row_version = theirs->row_version;
+    return 1;
+}
+
+void show_client_notes_pager(int client_id, const char *business_name) {
+    sqlite3_blob *blob;
+    int notes_size;
+    if (!db_open_client_notes_blob(client_id, &blob, &notes_size) || notes_size == 0) {
+        sqlite3_blob_close(blob);
+        show_status("No notes stored for '%s'.", business_name); napms(1000);
+        return;
+    }
+
+    cchar_t title_sep_char;
+    setcchar(&title_sep_char, (const wchar_t[]){WC_RF_TITLE_SEP_CHAR, L'\0'}, A_NORMAL, 0, NULL);
+    char title[MAX_STR_LEN + 50];
+    snprintf(title, sizeof(title), "NOTES: %s (ID: %d)", business_name, client_id);
+
+    int page_start = 0;
+    int *page_history = NULL, history_len = 0, history_cap = 0; // Start offsets of previous pages, for PgUp.
+    char *page_buf = NULL;
+    bool done = false;
+
+    while (!exit_requested && !done) {
+        check_and_handle_resize();
+        output_profile.main_region = OUTPUT_REGION_PAGER;
+        if (!main_win || !input_win || !status_win) break;
+
+        int win_w = getmaxx(main_win);
+        int text_rows = getmaxy(main_win) - SCREEN_CONTENT_Y_STD - (MAIN_WIN_BORDER_WIDTH - 1);
+        int text_width = win_w - (2 * MAIN_WIN_BORDER_WIDTH);
+        if (text_rows < 1) text_rows = 1;
+        if (text_width < 1) text_width = 1;
+
+        werase(main_win); draw_custom_box(main_win);
+        TextWidth title_tw = measure_text_width(title);
+        wmove(main_win, SCREEN_TITLE_Y, title_tw.cols < win_w - 2 ? (win_w - title_tw.cols) / 2 : 1);
+        draw_text_cols(main_win, title, &title_tw, win_w - 2, false);
+
+        int sep_len = title_tw.cols;
+        if (sep_len < MIN_SEPARATOR_WIDTH) sep_len = MIN_SEPARATOR_WIDTH;
+        int max_sep_len = win_w - (2 * MAIN_WIN_BORDER_WIDTH);
+        if (max_sep_len < 0) max_sep_len = 0;
+        if (sep_len > max_sep_len) sep_len = max_sep_len;
+
+        if (sep_len > 0) {
+            int sep_x = (win_w - sep_len) / 2;
+            wmove(main_win, SCREEN_SEPARATOR_Y, sep_x);
+            for (int k = 0; k < sep_len; ++k) wadd_wch(main_win, &title_sep_char);
+        }
+
+        // Read just the piece of the BLOB that can fill this page.
+        int want = text_rows * text_width * (int)MB_CUR_MAX;
+        if (want > notes_size - page_start) want = notes_size - page_start;
+        char *new_buf = realloc(page_buf, want + 1);
+        if (!new_buf) { show_error("Memory allocation failed for notes page."); break; }
+        page_buf = new_buf;
+        if (sqlite3_blob_read(blob, page_buf, want, page_start) != SQLITE_OK) {
+            show_error("Notes could not be read (changed meanwhile?): %s", sqlite3_errmsg(db));
+            break;
+        }
+
+        int shown = 0;
+        for (int y = SCREEN_CONTENT_Y_STD; shown < want && y < SCREEN_CONTENT_Y_STD + text_rows; ++y) {
+            int print_bytes;
+            int consumed = wrap_text_line(page_buf + shown, want - shown, text_width, &print_bytes);
+            if (consumed <= 0) {
+                if (page_start + want >= notes_size) shown = want; // Truncated character at the very end of the notes.
+                break;
+            }
+            if (print_bytes > 0) mvwaddnstr(main_win, y, MAIN_WIN_BORDER_WIDTH, page_buf + shown, print_bytes);
+            shown += consumed;
+        }
+        int next_start = page_start + shown;
+        refresh_window(main_win);
+
+        werase(input_win); draw_custom_box(input_win);
+        char instruction_buf[MAX_STR_LEN];
+        snprintf(instruction_buf, sizeof(instruction_buf),
+                 "PgDn/Space: Next | PgUp: Prev | Home: Top | Q/ESC: Back | Bytes %d-%d of %d",
+                 page_start + 1, next_start, notes_size);
+        mvwprintw(input_win, 1, 1, "%.*s", getmaxx(input_win) - 2, instruction_buf);
+        refresh_window(input_win);
+        clear_status();
+        poll_background_backup();
+        end_output_frame();
+
+        int key = read_key(main_win);
+        if (key == ERR && !exit_requested) continue;
+
+        switch (key) {
+            case KEY_NAV_NPAGE: case KEY_NAV_DOWN: case ' ':
+                if (next_start < notes_size && shown > 0) {
+                    if (history_len >= history_cap) {
+                        int new_cap = history_cap == 0 ? 16 : history_cap * 2;
+                        int *new_history = realloc(page_history, new_cap * sizeof(int));
+                        if (!new_history) { beep(); break; }
+                        page_history = new_history;
+                        history_cap = new_cap;
+                    }
+                    page_history[history_len++] = page_start;
+                    page_start = next_start;
+                } else beep();
+                break;
+            case KEY_NAV_PPAGE: case KEY_NAV_UP:
+                if (history_len > 0) page_start = page_history[--history_len];
+                else beep();
+                break;
+            case KEY_NAV_HOME:
+                history_len = 0;
+                page_start = 0;
+                break;
+            case KEY_ACTION_PROFILER: toggle_output_overlay(); break;
+            case KEY_ACTION_QUIT: case KEY_ACTION_QUIT_ALT: case KEY_ESC:
+                done = true;
+                break;
+            default: beep(); break;
+        }
+    }
+
+    free(page_history);
+    free(page_buf);
+    sqlite3_blob_close(blob);
+    if (input_win) { werase(input_win); draw_custom_box(input_win); refresh_window(input_win); }
+}
+
+// --- New Interactive List with Detail Pane ---
+void wclr_pane_line(WINDOW *win, int y, int x, int width) {
+    wmove(win, y, x);
+    for (int i = 0; i < width; ++i) {
+        if (x + i >= getmaxx(win)) break;
+        waddch(win, ' ');
+    }
+}
 
-    if (*end_ptr == '\0' && search_term != end_ptr) {
-        sql_query = sqlite3_mprintf("SELECT id, business_name, city, phone, email, contact_person FROM clients WHERE id = %ld ORDER BY business_name COLLATE NOCASE;", id_val);
+// Lists are ordered by business_name COLLATE NOCASE, so sqlite3_strnicmp gives the same ordering for a lower-bound search.
+int find_first_list_item_with_prefix(ClientList *list, const char *prefix) {
+    if (list->spill_db) {
+        // The spill table has an index on (business_name, pos), so this is one index seek rather than a scan.
+        char *sql = sqlite3_mprintf("SELECT pos FROM temp.%s WHERE business_name >= ?1 ORDER BY business_name, pos LIMIT 1;", list->spill_table);
+        sqlite3_stmt *stmt = NULL;
+        int index = list->count;
+        if (sql && sqlite3_prepare_v2(list->spill_db, sql, -1, &stmt, NULL) == SQLITE_OK) {
+            sqlite3_bind_text(stmt, 1, prefix, -1, SQLITE_TRANSIENT);
+            if (sqlite3_step(stmt) == SQLITE_ROW) {
+                int pos = sqlite3_column_int(stmt, 0);
+                index = pos;
+                for (int i = 0; i < list->deleted_count && list->deleted[i] < pos; ++i) index--;
+            }
+        }
+        sqlite3_finalize(stmt);
+        sqlite3_free(sql);
+        return index;
+    }
+    int prefix_len = strlen(prefix);
+    int lo = 0, hi = list->count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (sqlite3_strnicmp(list->items[mid].business_name, prefix, prefix_len) < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+void build_list_letter_index(ClientList *list, int *letter_index) {
+    char initial[2] = {0, 0};
+    int total_items = list->count;
+    for (int i = 0; i < LIST_LETTER_INDEX_SIZE - 1; ++i) {
+        initial[0] = 'a' + i;
+        int pos = find_first_list_item_with_prefix(list, initial);
+        letter_index[i] = (pos < total_items && tolower((unsigned char)client_list_item(list, pos)->business_name[0]) == initial[0]) ? pos : -1;
+    }
+    // NOCASE folds to lower case, so non-letter initials sort either before 'a' or after 'z'.
+    if (total_items > 0 && !isalpha((unsigned char)client_list_item(list, 0)->business_name[0])) {
+        letter_index[LIST_LETTER_INDEX_SIZE - 1] = 0;
     } else {
-        char *pattern = sqlite3_mprintf("%%%s%%", search_term);
-        if (!pattern) { show_error("Memory allocation failed for search pattern."); return; }
-        sql_query = sqlite3_mprintf(
-            "SELECT id, business_name, city, phone, email, contact_person FROM clients "
-            "WHERE business_name LIKE %Q "
-            "OR contact_person LIKE %Q "
-            "OR email LIKE %Q "
-            "OR city LIKE %Q "
-            "ORDER BY business_name COLLATE NOCASE;",
-            pattern, pattern, pattern, pattern);
-        sqlite3_free(pattern);
-    }
-
-    if (!sql_query) { show_error("Failed to construct search query."); return; }
-
-    display_interactive_client_list(screen_title, sql_query, action);
-    sqlite3_free(sql_query);
+        int pos = find_first_list_item_with_prefix(list, "{");
+        letter_index[LIST_LETTER_INDEX_SIZE - 1] = pos < total_items ? pos : -1;
+    }
+}
+
+// --- Bounded List Memory ---
+// Lists keep at most memory_budget.max_list_items rows in memory. Past that, the rows move to a TEMP table keyed by
+// their list position and the UI reads LIST_SPILL_WINDOW rows at a time, so a broad search over a large database
+// costs a bounded amount of memory instead of about 1.4 KB per matching customer.
+void copy_list_text(char dest[MAX_STR_LEN], const char *src) {
+    size_t len = strlen(src);
+    if (len < MAX_STR_LEN) { memcpy(dest, src, len + 1); return; }
+    // Cut before the character the limit falls in, never inside it, and mark the cut.
+    size_t cut = MAX_STR_LEN - sizeof(LIST_TEXT_CUT_MARK);
+    while (cut > 0 && ((unsigned char)src[cut] & 0xC0) == 0x80) cut--;
+    memcpy(dest, src, cut);
+    memcpy(dest + cut, LIST_TEXT_CUT_MARK, sizeof(LIST_TEXT_CUT_MARK));
+}
+
+void fill_client_list_item(ClientListItem *item, int id, const char *const fields[5], int shard) {
+    char *targets[5] = { item->business_name, item->city, item->phone, item->email, item->contact_person };
+    TextWidth *widths[5] = { &item->business_name_tw, &item->city_tw, &item->phone_tw, &item->email_tw, &item->contact_person_tw };
+    memset(item, 0, sizeof(ClientListItem));
+    item->id = id;
+    item->shard = shard;
+    for (int i = 0; i < 5; ++i) {
+        if (fields[i]) copy_list_text(targets[i], fields[i]); else { strcpy(targets[i], "N/A"); item->null_fields |= 1u << i; }
+        *widths[i] = measure_text_width(targets[i]);
+    }
+}
+
+int client_list_max_items(const ClientList *list) {
+    return list->max_items > 0 ? list->max_items : memory_budget.max_list_items;
+}
+
+void list_memory_add(ptrdiff_t items) {
+    pthread_mutex_lock(&list_memory_lock);
+    list_memory_bytes += (size_t)items * sizeof(ClientListItem); // Wraps correctly for negative counts.
+    pthread_mutex_unlock(&list_memory_lock);
+}
+
+int client_list_grow(ClientList *list, int min_capacity) {
+    if (list->capacity >= min_capacity) return 1;
+    int new_capacity = list->capacity == 0 ? 50 : list->capacity * 2;
+    if (new_capacity > client_list_max_items(list)) new_capacity = client_list_max_items(list); // Never outgrow the budget by doubling.
+    if (new_capacity < min_capacity) new_capacity = min_capacity;
+    ClientListItem *new_items = realloc(list->items, (size_t)new_capacity * sizeof(ClientListItem));
+    if (!new_items) return 0;
+    list_memory_add(new_capacity - list->capacity);
+    list->items = new_items;
+    list->capacity = new_capacity;
+    return 1;
+}
+
+int client_list_spill(ClientList *list) {
+    // The table lives in a connection of its own: creating it on the connection whose query is filling the list
+    // would abort that query ("abort due to ROLLBACK") after the first row past the budget.
+    sqlite3 *conn = NULL;
+    if (sqlite3_open_v2("", &conn, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL) != SQLITE_OK) {
+        sqlite3_close(conn);
+        return 0;
+    }
+    list->spill_db = conn;
+    pthread_mutex_lock(&list_memory_lock);
+    unsigned serial = ++list_spill_serial;
+    pthread_mutex_unlock(&list_memory_lock);
+    snprintf(list->spill_table, sizeof(list->spill_table), "list_spill_%u", serial);
+    char *sql = sqlite3_mprintf("CREATE TEMP TABLE %s (pos INTEGER PRIMARY KEY, id INTEGER, business_name TEXT COLLATE NOCASE, "
+                                "city TEXT, phone TEXT, email TEXT, contact_person TEXT, shard INTEGER, sort_key REAL);", list->spill_table);
+    int ok = sql && sqlite3_exec(conn, sql, NULL, NULL, NULL) == SQLITE_OK;
+    sqlite3_free(sql);
+    if (!ok) return 0;
+    list->spill_txn = sqlite3_exec(conn, "BEGIN;", NULL, NULL, NULL) == SQLITE_OK; // Batches the inserts.
+
+    sql = sqlite3_mprintf("INSERT INTO temp.%s VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9);", list->spill_table);
+    ok = sql && sqlite3_prepare_v2(conn, sql, -1, &list->spill_insert, NULL) == SQLITE_OK;
+    sqlite3_free(sql);
+    if (!ok) return 0;
+
+    int in_memory = list->count;
+    list->count = 0;
+    for (int i = 0; i < in_memory; ++i) {
+        if (!client_list_append(list, &list->items[i])) return 0;
+    }
+    // Shrink the array to the window the list is read through from now on.
+    ClientListItem *window = realloc(list->items, LIST_SPILL_WINDOW * sizeof(ClientListItem));
+    if (window) {
+        list_memory_add(LIST_SPILL_WINDOW - list->capacity);
+        list->items = window;
+        list->capacity = LIST_SPILL_WINDOW;
+    }
+    list->window_count = 0;
+    return 1;
+}
+
+int client_list_append(ClientList *list, const ClientListItem *item) {
+    if (!list->spill_db && list->count >= client_list_max_items(list) && !client_list_spill(list)) return 0;
+    if (list->spill_db) {
+        sqlite3_stmt *stmt = list->spill_insert;
+        const char *fields[5] = { item->business_name, item->city, item->phone, item->email, item->contact_person };
+        sqlite3_bind_int(stmt, 1, list->count);
+        sqlite3_bind_int(stmt, 2, item->id);
+        for (int i = 0; i < 5; ++i) {
+            if (item->null_fields & (1u << i)) sqlite3_bind_null(stmt, 3 + i); // Read back as NULL, so the flag survives.
+            else sqlite3_bind_text(stmt, 3 + i, fields[i], -1, SQLITE_STATIC);
+        }
+        sqlite3_bind_int(stmt, 8, item->shard);
+        sqlite3_bind_double(stmt, 9, item->sort_key);
+        int rc = sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+        if (rc != SQLITE_DONE) return 0;
+    } else {
+        if (list->count >= list->capacity && !client_list_grow(list, list->count + 1)) return 0;
+        list->items[list->count] = *item;
+    }
+    list->count++;
+    return 1;
+}
+
+int client_list_finish(ClientList *list) {
+    if (!list->spill_db) return 1;
+    sqlite3_finalize(list->spill_insert);
+    list->spill_insert = NULL;
+    char *sql = sqlite3_mprintf("CREATE INDEX temp.%s_name ON %s (business_name, pos);", list->spill_table, list->spill_table);
+    int ok = sql && sqlite3_exec(list->spill_db, sql, NULL, NULL, NULL) == SQLITE_OK;
+    sqlite3_free(sql);
+    if (list->spill_txn) {
+        if (sqlite3_exec(list->spill_db, "COMMIT;", NULL, NULL, NULL) != SQLITE_OK) ok = 0;
+        list->spill_txn = false;
+    }
+    return ok;
+}
+
+int client_list_spill_pos(const ClientList *list, int index) {
+    int pos = index;
+    for (int i = 0; i < list->deleted_count && list->deleted[i] <= pos; ++i) pos++;
+    return pos;
+}
+
+ClientListItem *client_list_item(ClientList *list, int index) {
+    if (!list->spill_db) return &list->items[index];
+    if (index >= list->window_start && index < list->window_start + list->window_count) return &list->items[index - list->window_start];
+
+    // Start the window a little before the requested row so that scrolling back up does not reload it at once.
+    int start = index - LIST_SPILL_WINDOW / 4;
+    if (start < 0) start = 0;
+    list->window_start = start;
+    list->window_count = 0;
+    char *sql = sqlite3_mprintf("SELECT id, business_name, city, phone, email, contact_person, shard, sort_key FROM temp.%s "
+                                "WHERE pos >= ?1 ORDER BY pos LIMIT %d;", list->spill_table, LIST_SPILL_WINDOW);
+    sqlite3_stmt *stmt = NULL;
+    if (sql && sqlite3_prepare_v2(list->spill_db, sql, -1, &stmt, NULL) == SQLITE_OK) {
+        sqlite3_bind_int(stmt, 1, client_list_spill_pos(list, start));
+        while (list->window_count < LIST_SPILL_WINDOW && sqlite3_step(stmt) == SQLITE_ROW) {
+            const char *fields[5];
+            for (int i = 0; i < 5; ++i) fields[i] = (const char*)sqlite3_column_text(stmt, 1 + i);
+            fill_client_list_item(&list->items[list->window_count], sqlite3_column_int(stmt, 0), fields, sqlite3_column_int(stmt, 6));
+            list->items[list->window_count++].sort_key = sqlite3_column_double(stmt, 7);
+        }
+    }
+    sqlite3_finalize(stmt);
+    sqlite3_free(sql);
+    if (index >= list->window_start + list->window_count) {
+        // The spill table could not be read; show a placeholder rather than stale data.
+        static ClientListItem unreadable;
+        const char *fields[5] = { "(unavailable)", "", "", "", "" };
+        fill_client_list_item(&unreadable, 0, fields, 0);
+        return &unreadable;
+    }
+    return &list->items[index - list->window_start];
 }
 
+void client_list_set_name(ClientList *list, int index, const char *name, TextWidth name_tw) {
+    if (list->spill_db) {
+        char *sql = sqlite3_mprintf("UPDATE temp.%s SET business_name = %Q WHERE pos = %d;", list->spill_table, name, client_list_spill_pos(list, index));
+        if (sql) sqlite3_exec(list->spill_db, sql, NULL, NULL, NULL);
+        sqlite3_free(sql);
+    }
+    ClientListItem *item = client_list_item(list, index);
+    copy_list_text(item->business_name, name);
+    item->business_name_tw = strlen(name) < MAX_STR_LEN ? name_tw : measure_text_width(item->business_name);
+}
 
-void edit_customer_form_screen(int client_id) {
-    Client client, original_client;
-
-    cchar_t title_sep_char;
-    setcchar(&title_sep_char, (const wchar_t[]){WC_RF_TITLE_SEP_CHAR, L'\0'}, A_NORMAL, 0, NULL);
-
-    if (!fetch_client_by_id(client_id, &client)) {
-        show_error("Could not fetch details for customer ID %d to edit.", client_id);
+void client_list_remove(ClientList *list, int index) {
+    if (index < 0 || index >= list->count) return;
+    if (!list->spill_db) {
+        memmove(&list->items[index], &list->items[index + 1], (list->count - 1 - index) * sizeof(ClientListItem));
+        list->count--;
         return;
     }
-    original_client = client;
+    int pos = client_list_spill_pos(list, index);
+    int *deleted = realloc(list->deleted, (list->deleted_count + 1) * sizeof(int));
+    if (!deleted) return;
+    int at = list->deleted_count;
+    while (at > 0 && deleted[at - 1] > pos) { deleted[at] = deleted[at - 1]; at--; }
+    deleted[at] = pos;
+    list->deleted = deleted;
+    list->deleted_count++;
+    char *sql = sqlite3_mprintf("DELETE FROM temp.%s WHERE pos = %d;", list->spill_table, pos);
+    if (sql) sqlite3_exec(list->spill_db, sql, NULL, NULL, NULL);
+    sqlite3_free(sql);
+    list->count--;
+    list->window_count = 0;
+}
 
-    werase(main_win); draw_custom_box(main_win);
-    char form_title_text[MAX_STR_LEN + 50];
-    snprintf(form_title_text, sizeof(form_title_text), "--- Edit Customer: %s (ID: %d) ---", client.business_name, client.id);
-    mvwprintw(main_win, SCREEN_TITLE_Y, (getmaxx(main_win) - strlen(form_title_text)) / 2, "%s", form_title_text);
+void client_list_free(ClientList *list) {
+    if (list->spill_db) {
+        sqlite3_finalize(list->spill_insert);
+        sqlite3_close(list->spill_db); // Drops the temporary table with it.
+    }
+    list_memory_add(-(ptrdiff_t)list->capacity);
+    free(list->items);
+    free(list->deleted);
+    memset(list, 0, sizeof(ClientList));
+}
 
-    int sep_len = strlen(form_title_text);
-    if (sep_len < MIN_SEPARATOR_WIDTH) sep_len = MIN_SEPARATOR_WIDTH;
-    int max_sep_len = getmaxx(main_win) - (2 * MAIN_WIN_BORDER_WIDTH);
-    if (max_sep_len < 0) max_sep_len = 0;
-    if (sep_len > max_sep_len) sep_len = max_sep_len;
+void apply_memory_budget(long megabytes) {
+    memory_budget.budget_bytes = (sqlite3_int64)megabytes * 1024 * 1024;
+    // Half goes to SQLite (page caches of every connection, including the spill tables), a quarter to each of the
+    // in-memory list rows and the search result cache.
+    sqlite3_soft_heap_limit64(memory_budget.budget_bytes / 2);
+    sqlite3_int64 list_items = memory_budget.budget_bytes / 4 / (sqlite3_int64)sizeof(ClientListItem);
+    memory_budget.max_list_items = list_items < LIST_SPILL_MIN_ITEMS ? LIST_SPILL_MIN_ITEMS : list_items > INT_MAX ? INT_MAX : (int)list_items;
+    if ((size_t)(memory_budget.budget_bytes / 4) < memory_budget.query_cache_max_bytes) memory_budget.query_cache_max_bytes = (size_t)(memory_budget.budget_bytes / 4);
+}
 
-    if (sep_len > 0) {
-        int sep_x = (getmaxx(main_win) - sep_len) / 2;
-        wmove(main_win, SCREEN_SEPARATOR_Y, sep_x);
-        for (int k = 0; k < sep_len; ++k) wadd_wch(main_win, &title_sep_char);
+void show_memory_usage() {
+    sqlite3_int64 heap_used = 0, heap_peak = 0, cache_used = 0;
+    sqlite3_status64(SQLITE_STATUS_MEMORY_USED, &heap_used, &heap_peak, 0);
+    for (int i = 0; i < shard_count + db_pool_count; ++i) {
+        sqlite3 *conn = i < shard_count ? shards[i].conn : db_pool[i - shard_count].conn;
+        int cur = 0, hiwtr = 0;
+        if (conn && sqlite3_db_status(conn, SQLITE_DBSTATUS_CACHE_USED, &cur, &hiwtr, 0) == SQLITE_OK) cache_used += cur;
     }
+    char budget[32];
+    if (memory_budget.budget_bytes > 0) snprintf(budget, sizeof(budget), "%.1fM", memory_budget.budget_bytes / 1048576.0);
+    else snprintf(budget, sizeof(budget), "none");
+    pthread_mutex_lock(&list_memory_lock);
+    size_t list_bytes = list_memory_bytes;
+    pthread_mutex_unlock(&list_memory_lock);
+    show_status("Heap %.1fM (peak %.1fM), pages %.1fM (%d pooled DBs), lists %.1fM, cache %.1fM, budget %s",
+                heap_used / 1048576.0, heap_peak / 1048576.0, cache_used / 1048576.0, db_pool_count,
+                list_bytes / 1048576.0, query_cache_bytes / 1048576.0, budget);
+}
 
-    mvwprintw(main_win, SCREEN_CONTENT_Y_STD, MAIN_WIN_BORDER_WIDTH, "Enter to keep current, ESC cancels field, type '%s' and Enter to abort all.", CANCEL_INPUT_STRING);
-    wrefresh(main_win);
+TextWidth measure_text_width(const char *text) {
+    TextWidth tw;
+    size_t len = strlen(text);
+    size_t i = 0;
 
-    int input_res;
-    #define EDIT_STR_FIELD(prompt_str, field_name, max_len_val, allow_empty_val) \
-        input_res = get_string_input(input_win, INPUT_PROMPT_Y, INPUT_PROMPT_X, prompt_str, client.field_name, max_len_val, allow_empty_val, original_client.field_name); \
-        if (input_res == -1) { \
-            show_status("Field edit cancelled, value reverted."); napms(700); \
-        } else if (input_res == 0) { \
-            show_status("Aborting edit due to invalid input."); napms(1000); return; \
-        } \
-        if (input_res == 1 && strcmp(client.field_name, CANCEL_INPUT_STRING) == 0) { \
-            show_status("Edit customer cancelled by user."); napms(1000); return; \
+    // ASCII fast path: find the first byte with the high bit set, 16 (SSE2) or 8 bytes per step.
+#if defined(__SSE2__)
+    for (; i + 16 <= len; i += 16) {
+        if (_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)(text + i))) != 0) break;
+    }
+#endif
+    for (; i + 8 <= len; i += 8) {
+        uint64_t chunk;
+        memcpy(&chunk, text + i, sizeof(chunk));
+        if (chunk & 0x8080808080808080ULL) break;
+    }
+    while (i < len && !((unsigned char)text[i] & 0x80)) i++;
+
+    tw.bytes = (int)len;
+    tw.cols = (int)i;
+    tw.ascii = (i == len);
+    if (tw.ascii) return tw;
+
+    mbstate_t state;
+    memset(&state, 0, sizeof(state));
+    while (i < len) {
+        wchar_t wch;
+        size_t mb_len = mbrtowc(&wch, text + i, len - i, &state);
+        int char_width = 1;
+        if (mb_len == (size_t)-1 || mb_len == (size_t)-2 || mb_len == 0) {
+            mb_len = 1;
+            memset(&state, 0, sizeof(state));
+        } else {
+            char_width = wcwidth(wch);
+            if (char_width < 0) char_width = 1;
         }
+        tw.cols += char_width;
+        i += mb_len;
+    }
+    return tw;
+}
 
-    EDIT_STR_FIELD("Business Name*", business_name, MAX_STR_LEN, false);
-    EDIT_STR_FIELD("Email", email, MAX_STR_LEN, true);
-    EDIT_STR_FIELD("Phone", phone, MAX_STR_LEN, true);
-    EDIT_STR_FIELD("Website", website, MAX_STR_LEN, true);
-    EDIT_STR_FIELD("Street", street, MAX_STR_LEN, true);
-    EDIT_STR_FIELD("City", city, MAX_STR_LEN, true);
-    EDIT_STR_FIELD("State", state, MAX_STR_LEN, true);
-    EDIT_STR_FIELD("Zip Code", zip_code, sizeof(client.zip_code), true);
-    EDIT_STR_FIELD("Country", country, MAX_STR_LEN, true);
-    EDIT_STR_FIELD("Tax Number", tax_number, MAX_STR_LEN, true);
+int text_prefix_bytes_for_cols(const char *text, const TextWidth *tw, int max_cols, int *cols_used) {
+    if (max_cols <= 0) { *cols_used = 0; return 0; }
+    if (tw->cols <= max_cols) { *cols_used = tw->cols; return tw->bytes; }
+    if (tw->ascii) { *cols_used = max_cols; return max_cols; }
+
+    int bytes = 0, cols = 0;
+    mbstate_t state;
+    memset(&state, 0, sizeof(state));
+    while (bytes < tw->bytes) {
+        wchar_t wch;
+        size_t mb_len = mbrtowc(&wch, text + bytes, tw->bytes - bytes, &state);
+        int char_width = 1;
+        if (mb_len == (size_t)-1 || mb_len == (size_t)-2 || mb_len == 0) {
+            mb_len = 1;
+            memset(&state, 0, sizeof(state));
+        } else {
+            char_width = wcwidth(wch);
+            if (char_width < 0) char_width = 1;
+        }
+        if (cols + char_width > max_cols) break;
+        cols += char_width;
+        bytes += mb_len;
+    }
+    *cols_used = cols;
+    return bytes;
+}
 
-    input_res = get_int_input(input_win, INPUT_PROMPT_Y, INPUT_PROMPT_X, "Num Employees", &client.num_employees, original_client.num_employees);
-    if (input_res == -1) { client.num_employees = original_client.num_employees; show_status("Field edit cancelled, value reverted."); napms(700); }
-    else if (input_res == 0) { show_status("Aborting edit due to invalid input."); napms(1000); return; }
+// tw may be NULL for strings that are not cached; they are measured on the spot.
+void draw_text_cols(WINDOW *win, const char *text, const TextWidth *tw, int max_cols, bool pad) {
+    TextWidth measured;
+    if (!tw) { measured = measure_text_width(text); tw = &measured; }
 
-    EDIT_STR_FIELD("Industry", industry, MAX_STR_LEN, true);
-    EDIT_STR_FIELD("Contact Person", contact_person, MAX_STR_LEN, true);
-    EDIT_STR_FIELD("Contact Email", contact_email, MAX_STR_LEN, true);
-    EDIT_STR_FIELD("Contact Phone", contact_phone, MAX_STR_LEN, true);
+    int cols_used;
+    int bytes = text_prefix_bytes_for_cols(text, tw, max_cols, &cols_used);
+    if (bytes > 0) waddnstr(win, text, bytes);
+    if (pad) {
+        for (; cols_used < max_cols; ++cols_used) waddch(win, ' ');
+    }
+}
 
-    input_res = select_client_status(client.status, original_client.status);
-    if (input_res == -1) { strncpy(client.status, original_client.status, MAX_STR_LEN-1); client.status[MAX_STR_LEN-1]='\0'; show_status("Status selection cancelled, value reverted."); napms(700); }
+// A character that is wider than the whole line is skipped rather than printed, so callers always make progress.
+int wrap_text_line(const char *text, int text_len, int max_width, int *print_bytes) {
+    int bytes = 0, visual_width = 0;
+    bool skip_wide_char = false;
+    mbstate_t state;
+    memset(&state, 0, sizeof(state));
+
+    while (bytes < text_len && text[bytes] != '\n') {
+        wchar_t wch;
+        size_t mb_len = mbrtowc(&wch, text + bytes, text_len - bytes, &state);
+        int char_width = 1;
+
+        if (mb_len == (size_t)-2) break; // Incomplete character at the end of the piece.
+        if (mb_len == (size_t)-1 || mb_len == 0) {
+            mb_len = 1; // Invalid byte: advance past it and reset the conversion state.
+            memset(&state, 0, sizeof(state));
+        } else {
+            char_width = wcwidth(wch);
+            if (char_width < 0) char_width = 1;
+        }
 
-    show_status("Edit Notes (up to %d chars):", MAX_NOTES_LEN -1); napms(500);
-    EDIT_STR_FIELD("Notes", notes, MAX_NOTES_LEN, true);
-    #undef EDIT_STR_FIELD
+        if (visual_width + char_width > max_width) {
+            if (bytes == 0) { bytes = mb_len; skip_wide_char = true; }
+            break;
+        }
+        visual_width += char_width;
+        bytes += mb_len;
+    }
 
-    werase(input_win); draw_custom_box(input_win);
-    mvwprintw(input_win, INPUT_PROMPT_Y, INPUT_PROMPT_X, "Save changes to '%s'? (Y/N): ", client.business_name);
-    wrefresh(input_win);
-    int confirm_key = wgetch(input_win);
-    werase(input_win); draw_custom_box(input_win); wrefresh(input_win);
+    *print_bytes = skip_wide_char ? 0 : bytes;
+    if (bytes < text_len && text[bytes] == '\n') bytes++; // Consume the newline.
+    return bytes;
+}
 
-    if (toupper(confirm_key) == 'Y') {
-        show_loading_indicator(true);
-        if (db_update_client(&client)) show_status("Customer '%s' updated.", client.business_name);
-        show_loading_indicator(false);
-    } else {
-        show_status("Edit customer cancelled. No changes saved.");
+void calculate_list_pane_widths(int main_win_width, int *list_pane_w, int *detail_pane_w) {
+    int available_content_width = main_win_width - (2 * MAIN_WIN_BORDER_WIDTH);
+    *list_pane_w = (int)(available_content_width * LIST_PANE_PERCENT);
+    *detail_pane_w = available_content_width - *list_pane_w - PANE_SEPARATOR_WIDTH;
+
+    if (*detail_pane_w < DETAIL_PANE_MIN_WIDTH && *list_pane_w > (DETAIL_PANE_MIN_WIDTH + PANE_SEPARATOR_WIDTH + 20)) {
+        *detail_pane_w = DETAIL_PANE_MIN_WIDTH;
+        *list_pane_w = available_content_width - *detail_pane_w - PANE_SEPARATOR_WIDTH;
+    } else if (*list_pane_w < 30 && *detail_pane_w > (30 + PANE_SEPARATOR_WIDTH + DETAIL_PANE_MIN_WIDTH)) {
+        *list_pane_w = 30;
+        *detail_pane_w = available_content_width - *list_pane_w - PANE_SEPARATOR_WIDTH;
     }
-    napms(1500);
+    if (*list_pane_w < 0) *list_pane_w = 0;
+    if (*detail_pane_w < 0) *detail_pane_w = 0;
 }
 
-// --- New Interactive List with Detail Pane ---
-void wclr_pane_line(WINDOW *win, int y, int x, int width) {
-    wmove(win, y, x);
-    for (int i = 0; i < width; ++i) {
-        if (x + i >= getmaxx(win)) break;
-        waddch(win, ' ');
-    }
+unsigned visible_list_columns() {
+    if (!main_win) return list_columns;
+    int list_pane_w, detail_pane_w;
+    ListColumnWidths widths;
+    calculate_list_pane_widths(getmaxx(main_win), &list_pane_w, &detail_pane_w);
+    calculate_list_column_widths_for_pane(&widths, list_pane_w, list_columns);
+    return widths.shown;
 }
 
-void calculate_list_column_widths_for_pane(ListColumnWidths *widths, int pane_content_width) {
+void calculate_list_column_widths_for_pane(ListColumnWidths *widths, int pane_content_width, unsigned columns) {
     int min_id_w = 4;
     int padding = LIST_COL_PADDING;
 
@@ -1296,6 +5806,33 @@ void calculate_list_column_widths_for_pane(ListColumnWidths *widths, int pane_co
         if (widths->name_width < 0) widths->name_width = 0;
         widths->name_col_start = widths->id_width + padding;
     }
+
+    if (shard_count > 1) { // Source column between ID and Name, only while the name keeps a usable width.
+        int source_w = 2;
+        for (int i = 0; i < shard_count; ++i) {
+            int label_len = strlen(shards[i].label);
+            if (label_len > source_w) source_w = label_len;
+        }
+        if (widths->name_width - source_w - padding >= 10) {
+            widths->source_width = source_w;
+            widths->source_col_start = widths->name_col_start;
+            widths->name_col_start += source_w + padding;
+            widths->name_width -= source_w + padding;
+        }
+    }
+    // Optional columns go right of the name, each only if the name keeps LIST_NAME_MIN_WIDTH.
+    for (int i = 0; i < LIST_COLUMN_COUNT; ++i) {
+        int column_w = list_column_specs[i].width;
+        if (!(columns & (1u << i)) || widths->name_width - column_w - padding < LIST_NAME_MIN_WIDTH) continue;
+        widths->name_width -= column_w + padding;
+        widths->shown |= 1u << i;
+    }
+    int column_x = widths->name_col_start + widths->name_width + padding;
+    for (int i = 0; i < LIST_COLUMN_COUNT; ++i) {
+        if (!(widths->shown & (1u << i))) continue;
+        widths->column_start[i] = column_x;
+        column_x += list_column_specs[i].width + padding;
+    }
     if (widths->id_width < 0) widths->id_width = 0;
     if (widths->name_width < 0) widths->name_width = 0;
 }
@@ -1319,11 +5856,19 @@ void draw_list_header_in_pane(WINDOW *win, const ListColumnWidths *col_widths, i
     if (col_widths->id_width > 0) {
         mvwprintw(win, pane_start_y, pane_start_x, "%-*.*s", col_widths->id_width, col_widths->id_width, "ID");
     }
+    if (col_widths->source_width > 0) {
+        mvwprintw(win, pane_start_y, pane_start_x + col_widths->source_col_start, "%-*.*s", col_widths->source_width, col_widths->source_width, "DB");
+    }
     if (col_widths->name_width > 0) {
         if (pane_start_x + col_widths->name_col_start < pane_start_x + pane_content_width) {
              mvwprintw(win, pane_start_y, pane_start_x + col_widths->name_col_start, "%-*.*s", col_widths->name_width, col_widths->name_width, "Business Name");
         }
     }
+    for (int i = 0; i < LIST_COLUMN_COUNT; ++i) {
+        if (!(col_widths->shown & (1u << i))) continue;
+        mvwprintw(win, pane_start_y, pane_start_x + col_widths->column_start[i], "%-*.*s",
+                  list_column_specs[i].width, list_column_specs[i].width, list_column_specs[i].header);
+    }
 
     if (has_colors()) {
         wattroff(win, COLOR_PAIR(COLOR_PAIR_LIST_HEADER) | A_BOLD);
@@ -1341,16 +5886,27 @@ void draw_list_item_in_pane(WINDOW *win, int y_on_screen, const ClientListItem *
     if (col_widths->id_width > 0) {
         mvwprintw(win, y_on_screen, pane_start_x, "%-*d", col_widths->id_width, item->id);
     }
+    if (col_widths->source_width > 0 && item->shard >= 0 && item->shard < shard_count) {
+        wmove(win, y_on_screen, pane_start_x + col_widths->source_col_start);
+        draw_text_cols(win, shards[item->shard].label, NULL, col_widths->source_width, false);
+    }
     if (col_widths->name_width > 0) {
         if (pane_start_x + col_widths->name_col_start < pane_start_x + pane_content_width) {
-            mvwprintw(win, y_on_screen, pane_start_x + col_widths->name_col_start, "%.*s", col_widths->name_width, item->business_name);
+            wmove(win, y_on_screen, pane_start_x + col_widths->name_col_start);
+            draw_text_cols(win, item->business_name, &item->business_name_tw, col_widths->name_width, false);
         }
     }
+    for (int i = 0; i < LIST_COLUMN_COUNT; ++i) {
+        if (!(col_widths->shown & (1u << i))) continue;
+        const ListColumnSpec *spec = &list_column_specs[i];
+        wmove(win, y_on_screen, pane_start_x + col_widths->column_start[i]);
+        draw_text_cols(win, (const char *)item + spec->offset, (const TextWidth *)((const char *)item + spec->width_offset), spec->width, false);
+    }
 
     if (highlighted) wattroff(win, has_colors() ? COLOR_PAIR(COLOR_PAIR_HIGHLIGHT) : A_REVERSE);
 }
 
-void draw_client_details_in_pane(WINDOW *win, const Client *client, int pane_start_y, int pane_start_x, int pane_content_width) {
+void draw_client_details_in_pane(WINDOW *win, const Client *client, const RelatedEntry *related, int pane_start_y, int pane_start_x, int pane_content_width) {
     if (!win) return;
 
     bool color_was_set = false;
@@ -1377,98 +5933,94 @@ void draw_client_details_in_pane(WINDOW *win, const Client *client, int pane_sta
     int value_w = pane_content_width - label_w - 2;
     if (value_w < 1) value_w = 1;
 
-    #define PRINT_PANE_DETAIL(label, value_fmt, ...) \
+    // Values are truncated by terminal columns using the widths cached when the client was fetched.
+    #define PRINT_PANE_DETAIL(label, value, value_tw) \
     do { \
         if (y >= getmaxy(win) - (MAIN_WIN_BORDER_WIDTH -1)) break; \
         mvwprintw(win, y, pane_start_x, "%-*.*s: ", label_w, label_w, label); \
-        char temp_val_buf[MAX_STR_LEN*2]; \
-        snprintf(temp_val_buf, sizeof(temp_val_buf), value_fmt, ##__VA_ARGS__); \
-        wprintw(win, "%.*s", value_w, temp_val_buf); \
+        draw_text_cols(win, value, value_tw, value_w, false); \
         y++; \
     } while(0)
+    #define PRINT_PANE_FIELD(label, field) PRINT_PANE_DETAIL(label, client_text(client, field), &client->text_widths[field])
 
     char num_buf[32];
 
-    PRINT_PANE_DETAIL("ID", "%d", client->id);
-    PRINT_PANE_DETAIL("Business Name", "%s", client->business_name);
-    PRINT_PANE_DETAIL("Email", "%s", client->email);
-    PRINT_PANE_DETAIL("Phone", "%s", client->phone);
-    PRINT_PANE_DETAIL("Website", "%s", client->website);
-    PRINT_PANE_DETAIL("Street", "%s", client->street);
-    PRINT_PANE_DETAIL("City", "%s", client->city);
-    PRINT_PANE_DETAIL("State", "%s", client->state);
-    PRINT_PANE_DETAIL("Zip Code", "%s", client->zip_code);
-    PRINT_PANE_DETAIL("Country", "%s", client->country);
-    PRINT_PANE_DETAIL("Tax Number", "%s", client->tax_number);
+    snprintf(num_buf, sizeof(num_buf), "%d", client->id);
+    PRINT_PANE_DETAIL("ID", num_buf, NULL);
+    PRINT_PANE_FIELD("Business Name", CF_BUSINESS_NAME);
+    PRINT_PANE_FIELD("Email", CF_EMAIL);
+    PRINT_PANE_FIELD("Phone", CF_PHONE);
+    PRINT_PANE_FIELD("Website", CF_WEBSITE);
+    PRINT_PANE_FIELD("Street", CF_STREET);
+    PRINT_PANE_FIELD("City", CF_CITY);
+    PRINT_PANE_FIELD("State", CF_STATE);
+    PRINT_PANE_FIELD("Zip Code", CF_ZIP_CODE);
+    PRINT_PANE_FIELD("Country", CF_COUNTRY);
+    PRINT_PANE_FIELD("Tax Number", CF_TAX_NUMBER);
     snprintf(num_buf, sizeof(num_buf), "%d", client->num_employees);
-    PRINT_PANE_DETAIL("Num Employees", "%s", num_buf);
-    PRINT_PANE_DETAIL("Industry", "%s", client->industry);
-    PRINT_PANE_DETAIL("Contact Person", "%s", client->contact_person);
-    PRINT_PANE_DETAIL("Contact Email", "%s", client->contact_email);
-    PRINT_PANE_DETAIL("Contact Phone", "%s", client->contact_phone);
-    PRINT_PANE_DETAIL("Status", "%s", client->status);
-    PRINT_PANE_DETAIL("Created At", "%s", client->created_at);
+    PRINT_PANE_DETAIL("Num Employees", num_buf, NULL);
+    PRINT_PANE_FIELD("Industry", CF_INDUSTRY);
+    PRINT_PANE_FIELD("Contact Person", CF_CONTACT_PERSON);
+    PRINT_PANE_FIELD("Contact Email", CF_CONTACT_EMAIL);
+    PRINT_PANE_FIELD("Contact Phone", CF_CONTACT_PHONE);
+    PRINT_PANE_FIELD("Status", CF_STATUS);
+    PRINT_PANE_FIELD("Created At", CF_CREATED_AT);
+
+    if (client->id > 0) {
+        const char *related_labels[RELATED_KIND_COUNT] = { "Same City+Industry", "Same Email Domain" };
+        RelatedRequest keys;
+        related_request_for_client(0, client, &keys);
+        for (int kind = 0; kind < RELATED_KIND_COUNT; ++kind) {
+            if (!(kind == RELATED_CITY_INDUSTRY ? keys.city : keys.domain)[0]) continue;
+            char related_buf[RELATED_LIMIT * (MAX_STR_LEN + 16)];
+            int len = 0;
+            if (!related) {
+                snprintf(related_buf, sizeof(related_buf), "(loading)");
+            } else if (related->count[kind] < 0) {
+                snprintf(related_buf, sizeof(related_buf), "(unavailable)");
+            } else if (related->count[kind] == 0) {
+                snprintf(related_buf, sizeof(related_buf), "(none)");
+            }
+            for (int i = 0; related && i < related->count[kind]; ++i) {
+                len += snprintf(related_buf + len, sizeof(related_buf) - len, "%s%s (#%d)", i ? ", " : "",
+                                related->names[kind][i], related->ids[kind][i]);
+            }
+            PRINT_PANE_DETAIL(related_labels[kind], related_buf, NULL);
+        }
+    }
 
     if (y < getmaxy(win) - (MAIN_WIN_BORDER_WIDTH -1) -1) {
+        int notes_label_y = y;
         mvwprintw(win, y++, pane_start_x, "%-*.*s:", label_w, label_w, "Notes");
-        const char *notes_ptr = client->notes;
         int notes_text_start_x = pane_start_x + 2;
         int notes_available_width = pane_content_width - 2;
         if (notes_available_width < 1) notes_available_width = 1;
 
+        // Only the bytes that can fill the remaining rows are read from the notes BLOB.
+        int rows_left = getmaxy(win) - (MAIN_WIN_BORDER_WIDTH -1) - y;
+        const char *notes_ptr = NULL;
+        int notes_bytes = 0, shown_bytes = 0;
+        if (client->notes_len > 0 && rows_left > 0) {
+            notes_ptr = get_client_notes_preview(client->id, rows_left * notes_available_width * (int)MB_CUR_MAX);
+            if (notes_ptr) notes_bytes = strlen(notes_ptr);
+        }
 
-        while (*notes_ptr && y < getmaxy(win) - (MAIN_WIN_BORDER_WIDTH -1)) {
-            wmove(win, y, notes_text_start_x);
-            int bytes_to_print_this_line = 0;
-            int current_visual_width = 0;
-            const char* line_start_ptr = notes_ptr;
-
-            const char* temp_ptr = notes_ptr;
-            while (*temp_ptr && *temp_ptr != '\n') {
-                wchar_t wch;
-                int mb_len = mbtowc(&wch, temp_ptr, MB_CUR_MAX);
-
-                if (mb_len <= 0) {
-                    if (mb_len < 0) {
-                        bytes_to_print_this_line++; temp_ptr++;
-                    }
-                    break;
-                }
-
-                int char_width = wcwidth(wch); // wcwidth warning might still appear if not resolved by macro
-                if (char_width < 0) char_width = 1;
-
-                if (current_visual_width + char_width > notes_available_width) {
-                    break;
-                }
-                current_visual_width += char_width;
-                bytes_to_print_this_line += mb_len;
-                temp_ptr += mb_len;
-            }
-
+        while (shown_bytes < notes_bytes && y < getmaxy(win) - (MAIN_WIN_BORDER_WIDTH -1)) {
+            int bytes_to_print_this_line;
+            int consumed = wrap_text_line(notes_ptr + shown_bytes, notes_bytes - shown_bytes, notes_available_width, &bytes_to_print_this_line);
+            if (consumed <= 0) break;
             if (bytes_to_print_this_line > 0) {
-                waddnstr(win, line_start_ptr, bytes_to_print_this_line);
+                mvwaddnstr(win, y, notes_text_start_x, notes_ptr + shown_bytes, bytes_to_print_this_line);
             }
-
+            shown_bytes += consumed;
             y++;
-            notes_ptr += bytes_to_print_this_line;
-            // --- BEGIN MODIFIED SECTION for infinite loop fix ---
-            if (*notes_ptr == '\n') {
-                notes_ptr++; // Consume the newline
-            } else if (bytes_to_print_this_line == 0 && *notes_ptr != '\0') {
-                // This condition is met if:
-                // 1. No bytes were actually processed for printing on the current line
-                //    (e.g., the first character was too wide, or it was an encoding error
-                //     that the inner loop didn't convert to printable bytes).
-                // 2. We are not at the end of the notes string.
-                //
-                // To prevent an infinite loop, we MUST advance notes_ptr.
-                notes_ptr++; // Advance past the problematic byte/character.
-                mbtowc(NULL, NULL, 0); // Reset mbtowc's internal shift state, as we've skipped a byte.
-            }
-            // --- END MODIFIED SECTION ---
+        }
+
+        if (shown_bytes < client->notes_len) {
+            mvwprintw(win, notes_label_y, pane_start_x + label_w, ": %.*s", value_w, "[more - N to read all]");
         }
     }
+    #undef PRINT_PANE_FIELD
     #undef PRINT_PANE_DETAIL
 
     if (color_was_set) {
@@ -1476,12 +6028,15 @@ void draw_client_details_in_pane(WINDOW *win, const Client *client, int pane_sta
     }
 }
 
-void display_interactive_client_list(const char *title, const char *sql_query, InteractiveListAction action_type) {
+bool display_interactive_client_list(const char *title, const char *sql_query, const char *cache_key, InteractiveListAction action_type, ListOrder order, unsigned columns, const CreatedRange *pages) {
     check_and_handle_resize();
-    if (!main_win || !input_win || !status_win) return;
+    if (!main_win || !input_win || !status_win) return false;
 
-    ClientListItem *items = NULL; int total_items = 0, capacity = 0;
-    FetchListData list_data = { &items, &total_items, &capacity };
+    ClientList list;
+    memset(&list, 0, sizeof(list));
+    CreatedCursor *page_starts = NULL; // page_starts[p] is where page p (from 0) starts; page 0 starts at the top.
+    int page = 0;
+    bool more_pages = false;
 
     cchar_t title_sep_char;
     setcchar(&title_sep_char, (const wchar_t[]){WC_RF_TITLE_SEP_CHAR, L'\0'}, A_NORMAL, 0, NULL);
@@ -1489,11 +6044,36 @@ void display_interactive_client_list(const char *title, const char *sql_query, I
     setcchar(&pane_sep_char, (const wchar_t[]){WC_RF_PANE_VSEP, L'\0'}, A_NORMAL, 0, NULL);
 
 
-    show_loading_indicator(true); show_status("Searching customers...");
-    bool fetch_success = db_execute(sql_query, fetch_list_items_callback, &list_data);
-    show_loading_indicator(false); clear_status();
+    bool fetch_success;
+    const QueryCacheEntry *cached = pages ? NULL : query_cache_lookup(cache_key);
+    if (pages) {
+        // Pages are read straight from the index and never cached: they are cheap, and the newest rows change most.
+        show_loading_indicator(true); show_status("Searching customers...");
+        fetch_success = fetch_created_page(pages, NULL, columns, &list, &more_pages);
+        show_loading_indicator(false); clear_status();
+    } else if (cached) {
+        fetch_success = true;
+        if (cached->count > 0) {
+            if (client_list_grow(&list, cached->count)) {
+                memcpy(list.items, cached->items, cached->count * sizeof(ClientListItem));
+                list.count = cached->count;
+            } else {
+                show_error("Failed to allocate memory for cached results.");
+                return false;
+            }
+        }
+    } else {
+        show_loading_indicator(true); show_status("Searching customers...");
+        fetch_success = fetch_client_list(sql_query, order, &list);
+        show_loading_indicator(false); clear_status();
+        if (fetch_success && !list.spill_db) query_cache_store(cache_key, list.items, list.count); // Spilled lists are too big to cache.
+    }
+
+    if (!fetch_success) { client_list_free(&list); return false; }
+    int total_items = list.count;
+    int letter_index[LIST_LETTER_INDEX_SIZE];
+    if (order == LIST_ORDER_NAME) build_list_letter_index(&list, letter_index);
 
-    if (!fetch_success) { free(items); return; }
     if (total_items == 0) {
         werase(main_win); draw_custom_box(main_win);
         mvwprintw(main_win, SCREEN_TITLE_Y, (getmaxx(main_win) - strlen(title)) / 2, "%s", title);
@@ -1511,22 +6091,32 @@ void display_interactive_client_list(const char *title, const char *sql_query, I
         }
 
         mvwprintw(main_win, SCREEN_CONTENT_Y_MENU, MENU_INDENT, "No customers found matching your search criteria.");
-        wrefresh(main_win);
+        if (list_status_filter >= 0) {
+            mvwprintw(main_win, SCREEN_CONTENT_Y_MENU + 1, MENU_INDENT, "Only %s customers were searched.", client_statuses[list_status_filter]);
+        }
+        refresh_window(main_win);
 
         werase(input_win); draw_custom_box(input_win);
-        mvwprintw(input_win, 1, 1, "Press any key to return...");
-        wrefresh(input_win);
-
-        wgetch(main_win);
-        free(items);
-        return;
+        mvwprintw(input_win, 1, 1, "F: Change status filter | Any other key to return...");
+        refresh_window(input_win);
+
+        int empty_key;
+        while ((empty_key = read_key(main_win)) == ERR && !exit_requested) poll_background_backup();
+        client_list_free(&list);
+        if (empty_key == KEY_ACTION_FILTER || empty_key == KEY_ACTION_FILTER_ALT) {
+            list_status_filter = list_status_filter + 1 < CLIENT_STATUS_COUNT ? list_status_filter + 1 : -1;
+            return true;
+        }
+        return false;
     }
 
     int top_item_index = 0, selected_item_index = 0;
-    Client current_detailed_client;
+    Client *current_detailed_client = NULL;
     bool details_loaded_for_selected = false;
     int prev_selected_item_index = -1;
     int key;
+    bool seek_active = false;
+    char seek_prefix[LIST_SEEK_MAX_LEN + 1] = "";
 
     ListColumnWidths list_col_widths;
     int main_win_height, main_win_width;
@@ -1536,10 +6126,14 @@ void display_interactive_client_list(const char *title, const char *sql_query, I
     int instruction_h = 0;
 
     while (!exit_requested) {
+        bool related_loading = false;
         check_and_handle_resize();
+        output_profile.main_region = OUTPUT_REGION_LIST;
         if (!main_win || !input_win || !status_win) {
-            if (items) free(items);
-            return;
+            client_list_free(&list);
+            free(page_starts);
+            client_free(current_detailed_client);
+            return false;
         }
 
         main_win_height = getmaxy(main_win);
@@ -1553,19 +6147,8 @@ void display_interactive_client_list(const char *title, const char *sql_query, I
         if (list_pane_content_height < 1) list_pane_content_height = 1;
 
 
-        int available_content_width = main_win_width - (2 * MAIN_WIN_BORDER_WIDTH);
-        int list_pane_w = (int)(available_content_width * LIST_PANE_PERCENT);
-        int detail_pane_w = available_content_width - list_pane_w - PANE_SEPARATOR_WIDTH;
-
-        if (detail_pane_w < DETAIL_PANE_MIN_WIDTH && list_pane_w > (DETAIL_PANE_MIN_WIDTH + PANE_SEPARATOR_WIDTH + 20)) {
-            detail_pane_w = DETAIL_PANE_MIN_WIDTH;
-            list_pane_w = available_content_width - detail_pane_w - PANE_SEPARATOR_WIDTH;
-        } else if (list_pane_w < 30 && detail_pane_w > (30 + PANE_SEPARATOR_WIDTH + DETAIL_PANE_MIN_WIDTH)) {
-            list_pane_w = 30;
-            detail_pane_w = available_content_width - list_pane_w - PANE_SEPARATOR_WIDTH;
-        }
-        if (list_pane_w < 0) list_pane_w = 0;
-        if (detail_pane_w < 0) detail_pane_w = 0;
+        int list_pane_w, detail_pane_w;
+        calculate_list_pane_widths(main_win_width, &list_pane_w, &detail_pane_w);
 
         int list_pane_start_x = MAIN_WIN_BORDER_WIDTH;
         int separator_x_pane = list_pane_start_x + list_pane_w;
@@ -1599,7 +6182,7 @@ void display_interactive_client_list(const char *title, const char *sql_query, I
 
 
         if (list_pane_w > 0 && total_items > 0) {
-            calculate_list_column_widths_for_pane(&list_col_widths, list_pane_w);
+            calculate_list_column_widths_for_pane(&list_col_widths, list_pane_w, columns);
             draw_list_header_in_pane(main_win, &list_col_widths, content_below_separator_y, list_pane_start_x, list_pane_w);
 
             int last_visible_on_page = top_item_index + items_per_page_list - 1;
@@ -1608,10 +6191,10 @@ void display_interactive_client_list(const char *title, const char *sql_query, I
             for (int i = top_item_index; i <= last_visible_on_page; ++i) {
                 int screen_y = list_items_start_y + (i - top_item_index);
                 if (screen_y >= content_below_separator_y + list_pane_content_height) break;
-                draw_list_item_in_pane(main_win, screen_y, &items[i], &list_col_widths, (i == selected_item_index), list_pane_start_x, list_pane_w);
+                draw_list_item_in_pane(main_win, screen_y, client_list_item(&list, i), &list_col_widths, (i == selected_item_index), list_pane_start_x, list_pane_w);
             }
         } else if (list_pane_w > 0 && total_items == 0) {
-             calculate_list_column_widths_for_pane(&list_col_widths, list_pane_w);
+             calculate_list_column_widths_for_pane(&list_col_widths, list_pane_w, columns);
              draw_list_header_in_pane(main_win, &list_col_widths, content_below_separator_y, list_pane_start_x, list_pane_w);
              if (list_items_start_y < content_below_separator_y + list_pane_content_height) {
                 mvwprintw(main_win, list_items_start_y, list_pane_start_x + 1, "(No items)");
@@ -1621,48 +6204,127 @@ void display_interactive_client_list(const char *title, const char *sql_query, I
         if (total_items > 0 && selected_item_index >= 0 && selected_item_index < total_items) {
             if (selected_item_index != prev_selected_item_index || !details_loaded_for_selected) {
                 show_loading_indicator(true);
-                if (fetch_client_by_id(items[selected_item_index].id, &current_detailed_client)) {
+                const ClientListItem *selected = client_list_item(&list, selected_item_index);
+                int selected_id = selected->id;
+                select_db_shard(selected->shard);
+                client_free(current_detailed_client);
+                if (fetch_client_by_id(selected_id, &current_detailed_client)) {
                     details_loaded_for_selected = true;
                 } else {
                     details_loaded_for_selected = false;
-                    memset(&current_detailed_client, 0, sizeof(Client));
-                    snprintf(current_detailed_client.business_name, MAX_STR_LEN, "Error loading ID %d", items[selected_item_index].id);
+                    char error_name[MAX_STR_LEN];
+                    snprintf(error_name, sizeof(error_name), "Error loading ID %d", selected_id);
+                    current_detailed_client = client_create((const char *const[CLIENT_TEXT_FIELD_COUNT]){ [CF_BUSINESS_NAME] = error_name }, NULL);
                 }
                 prev_selected_item_index = selected_item_index;
                 show_loading_indicator(false);
             }
             if (detail_pane_w > 0) {
-                 draw_client_details_in_pane(main_win, &current_detailed_client, content_below_separator_y, detail_pane_start_x, detail_pane_w);
+                 RelatedEntry related;
+                 bool related_ready = details_loaded_for_selected && get_related_customers(client_list_item(&list, selected_item_index)->shard, current_detailed_client, &related);
+                 related_loading = details_loaded_for_selected && !related_ready;
+                 draw_client_details_in_pane(main_win, current_detailed_client, related_ready ? &related : NULL, content_below_separator_y, detail_pane_start_x, detail_pane_w);
             }
         } else if (detail_pane_w > 0) {
-            draw_client_details_in_pane(main_win, NULL, content_below_separator_y, detail_pane_start_x, detail_pane_w);
+            draw_client_details_in_pane(main_win, NULL, NULL, content_below_separator_y, detail_pane_start_x, detail_pane_w);
         }
 
-        wrefresh(main_win);
+        int detail_pane_h = main_win_height - MAIN_WIN_BORDER_WIDTH - content_below_separator_y;
+        if (detail_pane_start_x + detail_pane_w > main_win_width - MAIN_WIN_BORDER_WIDTH) detail_pane_w = main_win_width - MAIN_WIN_BORDER_WIDTH - detail_pane_start_x;
+        refresh_window_area(main_win, content_below_separator_y, detail_pane_start_x, detail_pane_h, detail_pane_w, OUTPUT_REGION_DETAIL);
+        refresh_window(main_win);
 
         werase(input_win); draw_custom_box(input_win);
         char instruction_buf[MAX_STR_LEN];
-        const char* action_key_str = (action_type == INTERACTIVE_LIST_ACTION_EDIT) ? "E/Enter: Edit" : "D/Enter: Delete";
-        snprintf(instruction_buf, sizeof(instruction_buf),
-                 "Arrows/PgUp/PgDn | %s | Q/ESC: Back | Item %d/%d",
-                 action_key_str,
-                 total_items > 0 ? selected_item_index + 1 : 0, total_items);
-        mvwprintw(input_win, 1, 1, "%.*s", getmaxx(input_win) - 2, instruction_buf);
-        wrefresh(input_win);
+        if (seek_active) {
+            int len = snprintf(instruction_buf, sizeof(instruction_buf), "%s%s_ |", RF_INPUT_PROMPT_STR, seek_prefix);
+            for (int i = 0; i < LIST_LETTER_INDEX_SIZE && len < (int)sizeof(instruction_buf) - 1; ++i) {
+                if (letter_index[i] < 0) continue;
+                len += snprintf(instruction_buf + len, sizeof(instruction_buf) - len, " %c:%d",
+                                i < LIST_LETTER_INDEX_SIZE - 1 ? 'A' + i : '#', letter_index[i] + 1);
+            }
+        } else {
+            const char* action_key_str = (action_type == INTERACTIVE_LIST_ACTION_EDIT) ? "E/Enter: Edit" : "D/Enter: Delete";
+            int len = snprintf(instruction_buf, sizeof(instruction_buf),
+                     "Arrows/PgUp/PgDn | %s%s | N: Notes | F: Status %s | Q/ESC: Back | Item %d/%d",
+                     order == LIST_ORDER_NAME ? "/: Seek | " : "", action_key_str,
+                     list_status_filter >= 0 ? client_statuses[list_status_filter] : "(all)",
+                     total_items > 0 ? selected_item_index + 1 : 0, total_items);
+            if (order == LIST_ORDER_DISTANCE && total_items > 0) {
+                snprintf(instruction_buf + len, sizeof(instruction_buf) - len, " | %.1f km",
+                         client_list_item(&list, selected_item_index)->sort_key);
+            } else if (order == LIST_ORDER_CREATED) {
+                len += snprintf(instruction_buf + len, sizeof(instruction_buf) - len, " | Page %d%s", page + 1, more_pages ? "+" : "");
+                if (total_items > 0) {
+                    time_t added = (time_t)-client_list_item(&list, selected_item_index)->sort_key;
+                    struct tm added_tm;
+                    gmtime_r(&added, &added_tm);
+                    strftime(instruction_buf + len, sizeof(instruction_buf) - len, " | Added %Y-%m-%d", &added_tm);
+                }
+            }
+        }
+        wmove(input_win, 1, 1);
+        draw_text_cols(input_win, instruction_buf, NULL, getmaxx(input_win) - 2, false);
+        refresh_window(input_win);
 
         clear_status();
-
-        key = wgetch(main_win);
+        poll_background_backup();
+        end_output_frame();
+
+        if (related_loading) wtimeout(main_win, RELATED_POLL_MS); // Wake up to draw the related customers once they are found.
+        key = read_key(main_win);
+        if (related_loading) {
+            int backup_percent;
+            wtimeout(main_win, get_backup_progress(&backup_percent) ? BACKGROUND_POLL_MS : -1);
+        }
         if (key == ERR && !exit_requested) continue;
 
         int items_per_page_nav = items_per_page_list > 0 ? items_per_page_list : 1;
 
-        switch (key) {
+        bool key_consumed = false;
+        int page_step = 0; // -1 or 1 when the selection moves off either end of a page of a date-added list.
+        if (seek_active) {
+            size_t seek_len = strlen(seek_prefix);
+            if (key == KEY_ESC || key == KEY_ACTION_SELECT || key == KEY_ACTION_ENTER) {
+                seek_active = false;
+                key_consumed = true;
+            } else if (key == KEY_BACKSPACE || key == 127 || key == 8) {
+                while (seek_len > 0 && ((unsigned char)seek_prefix[seek_len - 1] & 0xC0) == 0x80) seek_len--; // UTF-8 continuation bytes.
+                if (seek_len > 0) seek_len--;
+                seek_prefix[seek_len] = '\0';
+                key_consumed = true;
+            } else if (key >= 32 && key < 256) {
+                if (seek_len < LIST_SEEK_MAX_LEN) {
+                    seek_prefix[seek_len] = (char)key;
+                    seek_prefix[seek_len + 1] = '\0';
+                } else beep();
+                key_consumed = true;
+            } else {
+                seek_active = false; // Navigation keys end the seek and are handled normally.
+            }
+
+            if (key_consumed && seek_prefix[0] != '\0' && total_items > 0) {
+                int seek_pos;
+                if (seek_prefix[1] == '\0' && isalpha((unsigned char)seek_prefix[0])) {
+                    seek_pos = letter_index[tolower((unsigned char)seek_prefix[0]) - 'a'];
+                    if (seek_pos < 0) seek_pos = find_first_list_item_with_prefix(&list, seek_prefix);
+                } else {
+                    seek_pos = find_first_list_item_with_prefix(&list, seek_prefix);
+                }
+                if (seek_pos >= total_items) seek_pos = total_items - 1;
+                if (sqlite3_strnicmp(client_list_item(&list, seek_pos)->business_name, seek_prefix, strlen(seek_prefix)) != 0) beep();
+                selected_item_index = seek_pos;
+                top_item_index = seek_pos;
+            }
+        }
+
+        if (!key_consumed) switch (key) {
             case KEY_NAV_UP:
                 if (total_items > 0 && selected_item_index > 0) {
                     selected_item_index--;
                     if (selected_item_index < top_item_index) top_item_index = selected_item_index;
-                } else beep();
+                } else if (page > 0) page_step = -1;
+                else beep();
                 break;
             case KEY_NAV_DOWN:
                 if (total_items > 0 && selected_item_index < total_items - 1) {
@@ -1671,17 +6333,20 @@ void display_interactive_client_list(const char *title, const char *sql_query, I
                         top_item_index = selected_item_index - items_per_page_nav + 1;
                         if (top_item_index < 0) top_item_index = 0;
                     }
-                } else beep();
+                } else if (more_pages) page_step = 1;
+                else beep();
                 break;
             case KEY_NAV_PPAGE:
-                if (total_items > 0) {
+                if (selected_item_index == 0 && page > 0) page_step = -1;
+                else if (total_items > 0) {
                     selected_item_index -= items_per_page_nav;
                     if (selected_item_index < 0) selected_item_index = 0;
                     top_item_index = selected_item_index;
                 } else beep();
                 break;
             case KEY_NAV_NPAGE:
-                if (total_items > 0) {
+                if (selected_item_index == total_items - 1 && more_pages) page_step = 1;
+                else if (total_items > 0) {
                     selected_item_index += items_per_page_nav;
                     if (selected_item_index >= total_items) selected_item_index = total_items > 0 ? total_items -1 : 0;
                     top_item_index = selected_item_index - items_per_page_nav + 1;
@@ -1717,12 +6382,14 @@ void display_interactive_client_list(const char *title, const char *sql_query, I
             // Fall through
             case KEY_ACTION_SELECT: case KEY_ACTION_ENTER:
                 if (total_items > 0 && selected_item_index >=0 && selected_item_index < total_items) {
-                    int client_id_action = items[selected_item_index].id;
+                    const ClientListItem *selected = client_list_item(&list, selected_item_index);
+                    int client_id_action = selected->id;
+                    select_db_shard(selected->shard); // Edits and deletes go to the database that owns the row.
                     char client_name_action[MAX_STR_LEN];
-                    strncpy(client_name_action, items[selected_item_index].business_name, MAX_STR_LEN -1);
+                    strncpy(client_name_action, selected->business_name, MAX_STR_LEN -1);
                     client_name_action[MAX_STR_LEN-1] = '\0';
 
-                    werase(input_win); draw_custom_box(input_win); wrefresh(input_win);
+                    werase(input_win); draw_custom_box(input_win); refresh_window(input_win);
 
                     if (action_type == INTERACTIVE_LIST_ACTION_EDIT) {
                          if (key == KEY_ACTION_DELETE || key == KEY_ACTION_DELETE_ALT) {beep(); break;}
@@ -1730,28 +6397,28 @@ void display_interactive_client_list(const char *title, const char *sql_query, I
                         details_loaded_for_selected = false;
                         prev_selected_item_index = -1;
 
-                        Client temp_full_client_refresh;
-                        if (fetch_client_by_id(client_id_action, &temp_full_client_refresh)) {
-                            strncpy(items[selected_item_index].business_name, temp_full_client_refresh.business_name, MAX_STR_LEN - 1);
-                            items[selected_item_index].business_name[MAX_STR_LEN - 1] = '\0';
+                        Client *refreshed;
+                        if (fetch_client_by_id(client_id_action, &refreshed)) {
+                            client_list_set_name(&list, selected_item_index, client_text(refreshed, CF_BUSINESS_NAME), refreshed->text_widths[CF_BUSINESS_NAME]);
+                            client_free(refreshed);
                         }
                     } else if (action_type == INTERACTIVE_LIST_ACTION_DELETE) {
                         if (key == KEY_EDIT_CLIENT || key == KEY_EDIT_CLIENT_ALT) {beep(); break;}
                         char confirm_prompt[MAX_STR_LEN + 50];
                         snprintf(confirm_prompt, sizeof(confirm_prompt), "Delete '%s' (ID:%d)? (Y/N): ", client_name_action, client_id_action);
-                        mvwprintw(input_win, INPUT_PROMPT_Y, INPUT_PROMPT_X, "%.*s", getmaxx(input_win) - 2 - INPUT_PROMPT_X, confirm_prompt);
-                        wrefresh(input_win);
-                        int confirm_key = wgetch(input_win);
-                        werase(input_win); draw_custom_box(input_win); wrefresh(input_win);
+                        wmove(input_win, INPUT_PROMPT_Y, INPUT_PROMPT_X);
+                        draw_text_cols(input_win, confirm_prompt, NULL, getmaxx(input_win) - 2 - INPUT_PROMPT_X, false);
+                        refresh_window(input_win);
+                        int confirm_key = read_key(input_win);
+                        werase(input_win); draw_custom_box(input_win); refresh_window(input_win);
 
                         if (toupper(confirm_key) == 'Y') {
                             show_loading_indicator(true);
                             if (db_delete_client(client_id_action)) {
                                 show_status("Customer '%s' (ID: %d) deleted.", client_name_action, client_id_action);
-                                if (selected_item_index < total_items - 1) {
-                                    memmove(&items[selected_item_index], &items[selected_item_index + 1], (total_items - 1 - selected_item_index) * sizeof(ClientListItem));
-                                }
-                                total_items--;
+                                client_list_remove(&list, selected_item_index);
+                                total_items = list.count;
+                                if (order == LIST_ORDER_NAME) build_list_letter_index(&list, letter_index);
 
                                 if (total_items == 0) {
                                     selected_item_index = 0;
@@ -1770,10 +6437,38 @@ void display_interactive_client_list(const char *title, const char *sql_query, I
                 } else beep();
                 break;
 
+            case KEY_ACTION_NOTES: case KEY_ACTION_NOTES_ALT:
+                if (total_items > 0 && selected_item_index >= 0 && selected_item_index < total_items) {
+                    const ClientListItem *selected = client_list_item(&list, selected_item_index);
+                    char notes_name[MAX_STR_LEN];
+                    strcpy(notes_name, selected->business_name);
+                    select_db_shard(selected->shard);
+                    show_client_notes_pager(selected->id, notes_name);
+                } else beep();
+                break;
+
+            case KEY_ACTION_SEEK:
+                if (order != LIST_ORDER_NAME) {
+                    show_status("Seek needs a list sorted by name."); beep(); napms(1000);
+                } else if (total_items > 0) {
+                    seek_active = true;
+                    seek_prefix[0] = '\0';
+                } else beep();
+                break;
+
+            case KEY_ACTION_PROFILER: toggle_output_overlay(); break;
+            case KEY_ACTION_MEMORY: case KEY_ACTION_MEMORY_ALT: show_memory_usage(); napms(2500); break;
+
+            case KEY_ACTION_FILTER: case KEY_ACTION_FILTER_ALT:
+                // Leave the list like Q does; the caller runs the search again with the new filter.
+                list_status_filter = list_status_filter + 1 < CLIENT_STATUS_COUNT ? list_status_filter + 1 : -1;
+            // Fall through
             case KEY_ACTION_QUIT: case KEY_ACTION_QUIT_ALT: case KEY_ESC:
-                free(items);
-                werase(input_win); draw_custom_box(input_win); wrefresh(input_win);
-                return;
+                client_list_free(&list);
+                free(page_starts);
+                client_free(current_detailed_client);
+                werase(input_win); draw_custom_box(input_win); refresh_window(input_win);
+                return key == KEY_ACTION_FILTER || key == KEY_ACTION_FILTER_ALT;
 
             case KEY_RESIZE:
                 details_loaded_for_selected = false;
@@ -1782,6 +6477,36 @@ void display_interactive_client_list(const char *title, const char *sql_query, I
             default: beep(); break;
         }
 
+        if (page_step != 0) {
+            // The next page starts after the last row of this one; going back restarts a page from its saved cursor.
+            int target_page = page + page_step;
+            if (page_step > 0 && total_items == 0) {
+                target_page = page; // Every row of this page was deleted: reading it again brings up the next rows.
+            } else if (page_step > 0) {
+                CreatedCursor *starts = realloc(page_starts, (size_t)(target_page + 1) * sizeof(CreatedCursor));
+                if (!starts) { show_error("Failed to allocate memory for the next page."); continue; }
+                page_starts = starts;
+                const ClientListItem *last = client_list_item(&list, total_items - 1);
+                page_starts[target_page] = (CreatedCursor){ (sqlite3_int64)-last->sort_key, last->id, last->shard };
+            }
+            ClientList page_list;
+            memset(&page_list, 0, sizeof(page_list));
+            bool page_more = false;
+            show_loading_indicator(true);
+            if (fetch_created_page(pages, target_page > 0 ? &page_starts[target_page] : NULL, columns, &page_list, &page_more)) {
+                client_list_free(&list);
+                list = page_list;
+                page = target_page;
+                more_pages = page_more;
+                total_items = list.count;
+                selected_item_index = page_step > 0 ? 0 : total_items - 1;
+                top_item_index = selected_item_index;
+                prev_selected_item_index = -1;
+                details_loaded_for_selected = false;
+            }
+            show_loading_indicator(false);
+        }
+
         if (total_items > 0) {
             if (selected_item_index < 0) selected_item_index = 0;
             if (selected_item_index >= total_items) selected_item_index = total_items - 1;
@@ -1807,15 +6532,18 @@ void display_interactive_client_list(const char *title, const char *sql_query, I
         }
     }
 
-    free(items);
-    werase(input_win); draw_custom_box(input_win); wrefresh(input_win);
+    client_list_free(&list);
+    free(page_starts);
+    client_free(current_detailed_client);
+    werase(input_win); draw_custom_box(input_win); refresh_window(input_win);
+    return false;
 }
 
 
 // --- Other Functions ---
 void execute_gextux_crm() {
     show_status("Exiting editor and attempting to launch gextux_crm...");
-    wrefresh(status_win); napms(1000);
+    refresh_window(status_win); napms(1000);
 
     close_db();
     cleanup_ncurses();
@@ -1844,64 +6572,482 @@ int fetch_list_items_callback(void *data, int argc, char **argv, char **azColNam
         return SQLITE_ABORT;
     }
 
-    if (*list_data->count_ptr >= *list_data->capacity_ptr) {
-        int new_capacity = (*list_data->capacity_ptr == 0) ? 50 : *list_data->capacity_ptr * 2;
-        ClientListItem *new_items = realloc(*list_data->items_ptr, new_capacity * sizeof(ClientListItem));
-        if (!new_items) {
-            fprintf(stderr, "Failed to reallocate memory for customers list items.\n");
-            return SQLITE_ABORT;
-        }
-        *list_data->items_ptr = new_items;
-        *list_data->capacity_ptr = new_capacity;
+    ClientListItem item;
+    fill_client_list_item(&item, argv[0] ? atoi(argv[0]) : 0, (const char *const *)&argv[1], list_data->shard);
+    if (argc > 6 && argv[6]) item.sort_key = atof(argv[6]);
+    if (!client_list_append(list_data->list, &item)) {
+        fprintf(stderr, "Failed to store customers list items.\n");
+        return SQLITE_ABORT;
+    }
+    return 0;
+}
+
+// --- Command-Line Subcommands ---
+// "get", "search", "add", "update" and "delete" go straight through the db_* functions without initscr, windows or
+// setlocale, so scripts can call them thousands of times. Errors go to stderr (show_error has no status bar here).
+void cli_print_text(const char *text, CliFormat format) {
+    if (format == CLI_FORMAT_JSON) putchar('"');
+    for (const unsigned char *p = (const unsigned char*)text; *p; ++p) {
+        if (format == CLI_FORMAT_TSV) {
+            if (*p == '\t') fputs("\\t", stdout);
+            else if (*p == '\n') fputs("\\n", stdout);
+            else if (*p == '\r') fputs("\\r", stdout);
+            else if (*p == '\\') fputs("\\\\", stdout);
+            else putchar(*p);
+        } else if (*p == '"' || *p == '\\') {
+            putchar('\\'); putchar(*p);
+        } else if (*p == '\n') fputs("\\n", stdout);
+        else if (*p == '\t') fputs("\\t", stdout);
+        else if (*p < 0x20) printf("\\u%04x", *p);
+        else putchar(*p);
     }
+    if (format == CLI_FORMAT_JSON) putchar('"');
+}
+
+void cli_print_client(const Client *client, const char *notes, CliFormat format, bool header) {
+    int field_count = sizeof(cli_client_fields) / sizeof(cli_client_fields[0]);
+    if (format == CLI_FORMAT_TSV && header) {
+        for (int i = 0; i < field_count; ++i) printf("%s\t", cli_client_fields[i].name);
+        printf("notes\n");
+    }
+    if (format == CLI_FORMAT_JSON) putchar('{');
+    for (int i = 0; i < field_count; ++i) {
+        const CliClientField *field = &cli_client_fields[i];
+        if (format == CLI_FORMAT_JSON) printf("\"%s\":", field->name);
+        if (field->text_field < 0) printf("%d", *(const int*)((const char*)client + field->offset));
+        else cli_print_text(client_text(client, field->text_field), format);
+        putchar(format == CLI_FORMAT_JSON ? ',' : '\t');
+    }
+    if (format == CLI_FORMAT_JSON) fputs("\"notes\":", stdout);
+    cli_print_text(notes ? notes : "", format);
+    fputs(format == CLI_FORMAT_JSON ? "}\n" : "\n", stdout);
+}
 
-    ClientListItem *current_item = &((*list_data->items_ptr)[*list_data->count_ptr]);
-    memset(current_item, 0, sizeof(ClientListItem));
+void cli_print_list_item(const ClientListItem *item, CliFormat format, bool header, ListOrder order) {
+    static const char *names[] = { "business_name", "city", "phone", "email", "contact_person" };
+    const char *values[] = { item->business_name, item->city, item->phone, item->email, item->contact_person };
+    for (int i = 0; i < 5; ++i) {
+        if (item->null_fields & (1u << i)) values[i] = ""; // "N/A" is for the editor; scripts get an empty value.
+    }
+    char created_at[DATETIME_STR_LEN + 1] = "";
+    if (order == LIST_ORDER_CREATED) {
+        time_t added = (time_t)-item->sort_key;
+        struct tm added_tm;
+        gmtime_r(&added, &added_tm);
+        strftime(created_at, sizeof(created_at), DATETIME_FORMAT, &added_tm);
+    }
+    if (format == CLI_FORMAT_TSV) {
+        if (header) printf("id\tbusiness_name\tcity\tphone\temail\tcontact_person%s%s%s\n", shard_count > 1 ? "\tdb" : "",
+                           order == LIST_ORDER_DISTANCE ? "\tdistance_km" : "", order == LIST_ORDER_CREATED ? "\tcreated_at" : "");
+        printf("%d", item->id);
+        for (int i = 0; i < 5; ++i) { putchar('\t'); cli_print_text(values[i], format); }
+        if (shard_count > 1) { putchar('\t'); cli_print_text(shards[item->shard].label, format); }
+        if (order == LIST_ORDER_DISTANCE) printf("\t%.2f", item->sort_key);
+        if (order == LIST_ORDER_CREATED) printf("\t%s", created_at);
+        putchar('\n');
+        return;
+    }
+    printf("{\"id\":%d", item->id);
+    for (int i = 0; i < 5; ++i) { printf(",\"%s\":", names[i]); cli_print_text(values[i], format); }
+    if (shard_count > 1) { fputs(",\"db\":", stdout); cli_print_text(shards[item->shard].label, format); }
+    if (order == LIST_ORDER_DISTANCE) printf(",\"distance_km\":%.2f", item->sort_key);
+    if (order == LIST_ORDER_CREATED) printf(",\"created_at\":\"%s\"", created_at);
+    fputs("}\n", stdout);
+}
 
-    current_item->id = argv[0] ? atoi(argv[0]) : 0;
-    if (argv[1]) strncpy(current_item->business_name, argv[1], MAX_STR_LEN - 1); else strcpy(current_item->business_name, "N/A");
-    if (argv[2]) strncpy(current_item->city,          argv[2], MAX_STR_LEN - 1); else strcpy(current_item->city, "N/A");
-    if (argv[3]) strncpy(current_item->phone,         argv[3], MAX_STR_LEN - 1); else strcpy(current_item->phone, "N/A");
-    if (argv[4]) strncpy(current_item->email,         argv[4], MAX_STR_LEN - 1); else strcpy(current_item->email, "N/A");
-    if (argv[5]) strncpy(current_item->contact_person,argv[5], MAX_STR_LEN - 1); else strcpy(current_item->contact_person, "N/A");
-    current_item->business_name[MAX_STR_LEN -1] = '\0';
-    current_item->city[MAX_STR_LEN -1] = '\0';
-    current_item->phone[MAX_STR_LEN -1] = '\0';
-    current_item->email[MAX_STR_LEN -1] = '\0';
-    current_item->contact_person[MAX_STR_LEN -1] = '\0';
+int cli_set_client_field(Client **client, const char *assignment, char **notes) {
+    const char *eq = strchr(assignment, '=');
+    if (!eq || eq == assignment) {
+        fprintf(stderr, "Expected field=value, got '%s'.\n", assignment);
+        return 0;
+    }
+    size_t name_len = eq - assignment;
+    const char *value = eq + 1;
+    if (name_len == 5 && strncmp(assignment, "notes", 5) == 0) {
+        if (strlen(value) >= MAX_NOTES_LEN) {
+            fprintf(stderr, "Notes are longer than %d bytes.\n", MAX_NOTES_LEN - 1);
+            return 0;
+        }
+        *notes = (char*)value;
+        return 1;
+    }
+    for (size_t i = 0; i < sizeof(cli_client_fields) / sizeof(cli_client_fields[0]); ++i) {
+        const CliClientField *field = &cli_client_fields[i];
+        if (strlen(field->name) != name_len || strncmp(field->name, assignment, name_len) != 0) continue;
+        if (!field->writable) {
+            fprintf(stderr, "Field '%s' cannot be changed.\n", field->name);
+            return 0;
+        }
+        if (field->text_field < 0) {
+            char *end_ptr;
+            long number = strtol(value, &end_ptr, 10);
+            if (*value == '\0' || *end_ptr != '\0' || number < 0 || number > INT_MAX) {
+                fprintf(stderr, "Invalid number '%s' for %s.\n", value, field->name);
+                return 0;
+            }
+            if (!client_mutable(client)) return 0;
+            *(int*)((char*)*client + field->offset) = (int)number;
+        } else if (!client_set_text(client, field->text_field, value)) {
+            fprintf(stderr, "Out of memory setting %s.\n", field->name);
+            return 0;
+        }
+        return 1;
+    }
+    fprintf(stderr, "Unknown field '%.*s'.\n", (int)name_len, assignment);
+    return 0;
+}
 
-    (*list_data->count_ptr)++;
+int cli_print_client_by_id(int client_id, CliFormat format) {
+    Client *client;
+    if (!fetch_client_by_id(client_id, &client)) {
+        fprintf(stderr, "No customer with ID %d.\n", client_id);
+        return CLI_EXIT_NOT_FOUND;
+    }
+    char *notes = client->notes_len > 0 ? db_read_client_notes(client_id) : NULL;
+    cli_print_client(client, notes, format, true);
+    free(notes);
+    client_free(client);
     return 0;
 }
 
+int run_cli_command(int argc, char **argv, CliFormat format) {
+    const char *command = argv[0];
+    bool takes_id = strcmp(command, "get") == 0 || strcmp(command, "update") == 0 || strcmp(command, "delete") == 0 ||
+                    strcmp(command, "merge") == 0;
+    int client_id = 0;
+    if (takes_id) {
+        char *end_ptr;
+        long id_val = argc > 1 ? strtol(argv[1], &end_ptr, 10) : 0;
+        if (argc < 2 || *argv[1] == '\0' || *end_ptr != '\0' || id_val <= 0 || id_val > INT_MAX) {
+            fprintf(stderr, "Usage: %s ID%s\n", command, strcmp(command, "update") == 0 ? " field=value..." : strcmp(command, "merge") == 0 ? " ID..." : "");
+            return 1;
+        }
+        client_id = (int)id_val;
+    }
+
+    if (strcmp(command, "get") == 0) return cli_print_client_by_id(client_id, format);
+
+    if (strcmp(command, "search") == 0) {
+        if (argc != 2 || (argv[1][0] == '\0' && list_status_filter < 0)) {
+            fprintf(stderr, "Usage: search TERM (an ID, part of a name, contact, email or city, @ZIP [km], or +[DAYS|FROM..TO]; empty with --status)\n");
+            return 1;
+        }
+        ListOrder order;
+        CreatedRange range;
+        char *sql_query = build_customer_search_sql(argv[1], LIST_COLUMNS_ALL, &order, &range);
+        if (!sql_query) return 1;
+        ClientList list;
+        memset(&list, 0, sizeof(list));
+        int ok = fetch_client_list(sql_query, order, &list);
+        sqlite3_free(sql_query);
+        for (int i = 0; ok && i < list.count; ++i) cli_print_list_item(client_list_item(&list, i), format, i == 0, order);
+        client_list_free(&list);
+        return ok ? 0 : 1;
+    }
+
+    if (strcmp(command, "add") == 0 || strcmp(command, "update") == 0) {
+        bool adding = command[0] == 'a';
+        Client *client = NULL;
+        char *notes = NULL;
+        int first_assignment = adding ? 1 : 2;
+        if (argc <= first_assignment) {
+            fprintf(stderr, "Usage: %s field=value...\n", adding ? "add" : "update ID");
+            return 1;
+        }
+        if (adding && !(client = client_new())) {
+            fprintf(stderr, "Out of memory.\n");
+            return 1;
+        } else if (!adding && !fetch_client_by_id(client_id, &client)) {
+            fprintf(stderr, "No customer with ID %d.\n", client_id);
+            return CLI_EXIT_NOT_FOUND;
+        }
+        int saved = 0;
+        for (int i = first_assignment; i < argc; ++i) {
+            if (!cli_set_client_field(&client, argv[i], &notes)) goto done_saving;
+        }
+        if (client_text(client, CF_BUSINESS_NAME)[0] == '\0') {
+            fprintf(stderr, "business_name is required.\n");
+            goto done_saving;
+        }
+        client->notes = notes;
+        saved = adding ? db_insert_client(client) : db_update_client(client);
+        // Someone saved the customer after it was fetched: the assignments are reapplied to their version.
+        for (int attempt = 1; saved == DB_UPDATE_CONFLICT && attempt < CLI_UPDATE_ATTEMPTS; ++attempt) {
+            client_free(client);
+            if (!fetch_client_by_id(client_id, &client)) {
+                fprintf(stderr, "Customer %d was deleted by another user.\n", client_id);
+                return CLI_EXIT_NOT_FOUND;
+            }
+            for (int i = first_assignment; i < argc; ++i) cli_set_client_field(&client, argv[i], &notes);
+            client->notes = notes;
+            saved = db_update_client(client);
+        }
+        if (saved == DB_UPDATE_CONFLICT) fprintf(stderr, "Customer %d kept changing; update not saved.\n", client_id);
+    done_saving:
+        client_free(client);
+        if (saved != 1) return 1;
+        return cli_print_client_by_id(adding ? (int)sqlite3_last_insert_rowid(db) : client_id, format);
+    }
+
+    if (strcmp(command, "delete") == 0) {
+        Client *client;
+        if (!fetch_client_by_id(client_id, &client)) {
+            fprintf(stderr, "No customer with ID %d.\n", client_id);
+            return CLI_EXIT_NOT_FOUND;
+        }
+        char *notes = client->notes_len > 0 ? db_read_client_notes(client_id) : NULL;
+        int ok = db_delete_client(client_id);
+        if (ok) cli_print_client(client, notes, format, true); // Prints the record as it was before the delete.
+        free(notes);
+        client_free(client);
+        return ok ? 0 : 1;
+    }
+
+    if (strcmp(command, "merge") == 0) {
+        int *ids = malloc(argc * sizeof(int));
+        if (!ids) return 1;
+        for (int i = 1; i < argc; ++i) {
+            char *end_ptr;
+            long id_val = strtol(argv[i], &end_ptr, 10);
+            if (*argv[i] == '\0' || *end_ptr != '\0' || id_val <= 0 || id_val > INT_MAX) {
+                fprintf(stderr, "Invalid customer ID '%s'.\n", argv[i]);
+                free(ids);
+                return 1;
+            }
+            ids[i - 1] = (int)id_val;
+        }
+        if (argc < 3) {
+            fprintf(stderr, "Usage: merge ID ID... (the others are merged into the first)\n");
+            free(ids);
+            return 1;
+        }
+        int ok = db_merge_clients(ids, argc - 1);
+        free(ids);
+        return ok ? cli_print_client_by_id(client_id, format) : 1;
+    }
+
+    fprintf(stderr, "Unknown command '%s' (expected get, search, add, update, delete or merge).\n", command);
+    return 1;
+}
+
 // --- Main Function ---
 int main(int argc, char *argv[]) {
     strncpy(db_path, DEFAULT_DB_NAME, sizeof(db_path) - 1);
     db_path[sizeof(db_path) - 1] = '\0';
 
+    static const struct option long_options[] = {
+        { "database",        required_argument, NULL, 'd' },
+        { "backup",          required_argument, NULL, 'b' },
+        { "tail-changes",    required_argument, NULL, OPT_TAIL_CHANGES },
+        { "compact-changes", required_argument, NULL, OPT_COMPACT_CHANGES },
+        { "export-snapshot", required_argument, NULL, OPT_EXPORT_SNAPSHOT },
+        { "profile-output",  required_argument, NULL, OPT_PROFILE_OUTPUT },
+        { "memory-budget",   required_argument, NULL, OPT_MEMORY_BUDGET },
+        { "format",          required_argument, NULL, OPT_FORMAT },
+        { "import-zips",     required_argument, NULL, OPT_IMPORT_ZIPS },
+        { "status",          required_argument, NULL, OPT_STATUS },
+        { "find-duplicates", required_argument, NULL, OPT_FIND_DUPLICATES },
+        { "merge-duplicates", required_argument, NULL, OPT_MERGE_DUPLICATES },
+        { "list-columns",    required_argument, NULL, OPT_LIST_COLUMNS },
+        { "maintenance",     no_argument,       NULL, OPT_MAINTENANCE },
+        { "idle-maintenance", required_argument, NULL, OPT_IDLE_MAINTENANCE },
+        { "help",            no_argument,       NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
     int opt;
-    while ((opt = getopt(argc, argv, "d:h")) != -1) {
+    const char *backup_dest = NULL, *snapshot_dest = NULL, *zips_source = NULL, *duplicates_dest = NULL, *merge_source = NULL;
+    long long tail_from_seq = -1;
+    long compact_days = -1, budget_mb, idle_seconds = MAINTENANCE_IDLE_SECONDS;
+    bool maintain = false;
+    CliFormat cli_format = CLI_FORMAT_JSON;
+    char *end_ptr;
+    while ((opt = getopt_long(argc, argv, "d:b:h", long_options, NULL)) != -1) {
         switch (opt) {
-            case 'd':
-                strncpy(db_path, optarg, sizeof(db_path) - 1);
-                db_path[sizeof(db_path) - 1] = '\0';
+            case 'd': {
+                // Several databases may be given as repeated -d options or as a comma-separated list.
+                char *paths = strdup(optarg), *save_ptr = NULL;
+                for (char *path = paths ? strtok_r(paths, ",", &save_ptr) : NULL; path; path = strtok_r(NULL, ",", &save_ptr)) {
+                    if (!add_db_shard(path)) {
+                        fprintf(stderr, "Too many databases (at most %d) or empty path in '%s'.\n", MAX_SHARDS, optarg);
+                        free(paths);
+                        return 1;
+                    }
+                }
+                free(paths);
+                break;
+            }
+            case 'b':
+                backup_dest = optarg;
+                break;
+            case OPT_EXPORT_SNAPSHOT:
+                snapshot_dest = optarg;
+                break;
+            case OPT_IMPORT_ZIPS:
+                zips_source = optarg;
+                break;
+            case OPT_FIND_DUPLICATES:
+                duplicates_dest = optarg;
+                break;
+            case OPT_MERGE_DUPLICATES:
+                merge_source = optarg;
+                break;
+            case OPT_PROFILE_OUTPUT:
+                strncpy(output_profile.dump_path, optarg, sizeof(output_profile.dump_path) - 1);
+                break;
+            case OPT_FORMAT:
+                if (strcmp(optarg, "json") == 0) cli_format = CLI_FORMAT_JSON;
+                else if (strcmp(optarg, "tsv") == 0) cli_format = CLI_FORMAT_TSV;
+                else {
+                    fprintf(stderr, "Invalid format '%s' (expected json or tsv).\n", optarg);
+                    return 1;
+                }
+                break;
+            case OPT_STATUS:
+                list_status_filter = -1;
+                for (int i = 0; i < CLIENT_STATUS_COUNT; ++i) {
+                    if (strcasecmp(optarg, client_statuses[i]) == 0) list_status_filter = i;
+                }
+                if (list_status_filter < 0) {
+                    fprintf(stderr, "Invalid status '%s' (expected Active, Inactive, Prospect, Lead or Former).\n", optarg);
+                    return 1;
+                }
+                break;
+            case OPT_LIST_COLUMNS:
+                if (!parse_list_columns(optarg, &list_columns)) {
+                    fprintf(stderr, "Invalid list columns '%s' (expected a comma-separated list of city, phone, email and contact_person, or none).\n", optarg);
+                    return 1;
+                }
+                break;
+            case OPT_MAINTENANCE:
+                maintain = true;
+                break;
+            case OPT_IDLE_MAINTENANCE:
+                idle_seconds = strtol(optarg, &end_ptr, 10);
+                if (*optarg == '\0' || *end_ptr != '\0' || idle_seconds < 0 || idle_seconds > 24 * 3600) {
+                    fprintf(stderr, "Invalid number of seconds '%s' for --idle-maintenance.\n", optarg);
+                    return 1;
+                }
+                break;
+            case OPT_MEMORY_BUDGET:
+                budget_mb = strtol(optarg, &end_ptr, 10);
+                if (*optarg == '\0' || *end_ptr != '\0' || budget_mb < 1 || budget_mb > 1024 * 1024) {
+                    fprintf(stderr, "Invalid memory budget '%s' (megabytes) for --memory-budget.\n", optarg);
+                    return 1;
+                }
+                apply_memory_budget(budget_mb);
+                break;
+            case OPT_TAIL_CHANGES:
+                tail_from_seq = strtoll(optarg, &end_ptr, 10);
+                if (*optarg == '\0' || *end_ptr != '\0' || tail_from_seq < 0) {
+                    fprintf(stderr, "Invalid sequence number '%s' for --tail-changes.\n", optarg);
+                    return 1;
+                }
+                break;
+            case OPT_COMPACT_CHANGES:
+                compact_days = strtol(optarg, &end_ptr, 10);
+                if (*optarg == '\0' || *end_ptr != '\0' || compact_days < 0 || compact_days > INT_MAX) {
+                    fprintf(stderr, "Invalid number of days '%s' for --compact-changes.\n", optarg);
+                    return 1;
+                }
                 break;
             case 'h':
                 printf("GexTuX Customer Editor\n");
-                printf("Usage: %s [-d database_file]\n", argv[0]);
+                printf("Usage: %s [-d database_file[,database_file...]]... [-b backup_file] [--compact-changes DAYS] [--export-snapshot FILE] [--import-zips CSV] [--find-duplicates FILE] [--merge-duplicates FILE] [--tail-changes FROM_SEQ] [--profile-output FILE] [--memory-budget MB] [--status STATUS] [--list-columns LIST] [--maintenance] [--idle-maintenance SECONDS]\n"
+                       "       %s [-d database_file]... [--format json|tsv] [--status STATUS] get ID | search TERM | add field=value... | update ID field=value... | delete ID | merge ID ID...\n", argv[0], argv[0]);
                 printf("  -d database_file: Specify the SQLite database file to use.\n");
+                printf("                    Repeat -d or separate files with commas to search up to %d databases together;\n", MAX_SHARDS);
+                printf("                    new customers are added to the first one.\n");
                 printf("                    Default: %s\n", DEFAULT_DB_NAME);
+                printf("  -b backup_file: Back up the (first) database to backup_file without starting the editor.\n");
+                printf("  --compact-changes DAYS: Drop change log entries older than DAYS days that a later change\n");
+                printf("                    of the same customer supersedes, and deletions older than DAYS days.\n");
+                printf("  --export-snapshot FILE: Write the customers to FILE as a columnar snapshot (see gextux_snapshot.h).\n");
+                printf("  --import-zips CSV: Load zip code coordinates (lines of zip,latitude,longitude) for radius searches\n");
+                printf("                    (\"@ZIP [km]\" as search term) and exit; existing codes are updated.\n");
+                printf("  --find-duplicates FILE: Look for customers entered more than once (similar names, same email domain\n");
+                printf("                    or phone) and write the clusters found to FILE for review.\n");
+                printf("  --merge-duplicates FILE: Merge each cluster of a reviewed FILE into its first customer.\n");
+                printf("  --profile-output FILE: Count the bytes and write() calls sent to the terminal per screen region\n");
+                printf("                    and write the totals to FILE on exit (F12 shows them live).\n");
+                printf("  --memory-budget MB: Keep memory use near MB megabytes: bounds SQLite's heap and search cache, and\n");
+                printf("                    keeps large result lists in a temporary table instead of memory ('M' shows usage).\n");
+                printf("  --tail-changes FROM_SEQ: Print changes after sequence FROM_SEQ as JSON lines and keep\n");
+                printf("                    following new ones until interrupted (0 starts with every customer).\n");
+                printf("  --format json|tsv: Output format of the subcommands (default json, one object per line).\n");
+                printf("  --status STATUS: List only customers with this status (Active, Inactive, Prospect, Lead or Former)\n");
+                printf("                    in searches; an empty search term then lists them all. F in an editor list cycles it.\n");
+                printf("  --list-columns LIST: Columns shown after the name in editor lists when there is room, from city, phone,\n");
+                printf("                    email and contact_person (comma-separated; default city,phone; none for just the name).\n");
+                printf("  --maintenance: Gather query statistics, optimize and return free pages to the file system, then exit.\n");
+                printf("                    Older databases are switched to incremental auto_vacuum once a tenth of them is free.\n");
+                printf("  --idle-maintenance SECONDS: Maintain the databases in the editor after SECONDS without keys, at most\n");
+                printf("                    hourly; a key stops it at once (default %d, 0 turns it off). Runs are logged in maintenance_log.\n", MAINTENANCE_IDLE_SECONDS);
                 printf("  -h: Display this help message and exit.\n");
+                printf("Subcommands print customers without starting the editor (get/add/update/delete/merge use the first database):\n");
+                printf("  get ID, search TERM, add field=value..., update ID field=value..., delete ID,\n");
+                printf("  merge ID ID... (fills empty fields of the first customer from the others, then deletes them)\n");
+                printf("  Fields: business_name email phone website street city state zip_code country tax_number\n");
+                printf("          num_employees industry contact_person contact_email contact_phone status notes\n");
+                printf("  Exit status: 0 on success, 1 on errors, %d when the customer ID does not exist.\n", CLI_EXIT_NOT_FOUND);
                 return 0;
             default:
-                fprintf(stderr, "Usage: %s [-d database_file]\n", argv[0]);
+                fprintf(stderr, "Usage: %s [-d database_file[,database_file...]]... [-b backup_file] [--compact-changes DAYS] [--export-snapshot FILE] [--import-zips CSV] [--find-duplicates FILE] [--merge-duplicates FILE] [--tail-changes FROM_SEQ] [--profile-output FILE] [--memory-budget MB] [--status STATUS] [--list-columns LIST] [--maintenance] [--idle-maintenance SECONDS]\n"
+                       "       %s [-d database_file]... [--format json|tsv] [--status STATUS] get ID | search TERM | add field=value... | update ID field=value... | delete ID | merge ID ID...\n", argv[0], argv[0]);
                 return 1;
         }
     }
+    if (shard_count == 0) add_db_shard(DEFAULT_DB_NAME);
+    snprintf(db_path, sizeof(db_path), "%s", shards[0].path);
+
+    if (optind < argc) {
+        if (!open_db_shards()) return 1;
+        int status = run_cli_command(argc - optind, argv + optind, cli_format);
+        fflush(stdout);
+        close_db();
+        return status;
+    }
+
+    if (backup_dest || snapshot_dest || zips_source || duplicates_dest || merge_source || compact_days >= 0 || tail_from_seq >= 0 || maintain) {
+        if (!open_db_shards()) {
+            fprintf(stderr, "Failed to initialize database '%s'.\n", db_path);
+            return 1;
+        }
+        int status = 0;
+        if (zips_source) {
+            long long rows = import_zip_locations(zips_source);
+            if (rows < 0) status = 1;
+            else fprintf(stderr, "Loaded %lld zip codes.\n", rows);
+        }
+        if (status == 0 && merge_source) {
+            long long merged = merge_duplicate_clusters(merge_source);
+            if (merged < 0) status = 1;
+            else fprintf(stderr, "Merged %lld duplicate customers.\n", merged);
+        }
+        if (status == 0 && duplicates_dest && find_duplicate_clusters(duplicates_dest) < 0) status = 1;
+        if (status == 0 && compact_days >= 0) {
+            int removed = compact_client_changes((int)compact_days);
+            if (removed < 0) status = 1;
+            else fprintf(stderr, "Removed %d change log entries.\n", removed);
+        }
+        if (status == 0 && maintain && !run_headless_maintenance()) status = 1;
+        if (status == 0 && backup_dest && !run_headless_backup(backup_dest)) status = 1;
+        if (status == 0 && snapshot_dest) {
+            long long rows = export_columnar_snapshot(snapshot_dest);
+            if (rows < 0) status = 1;
+            else fprintf(stderr, "Exported %lld customers to '%s'.\n", rows, snapshot_dest);
+        }
+        if (status == 0 && tail_from_seq >= 0) {
+            signal(SIGINT, handle_exit_signal);
+            signal(SIGTERM, handle_exit_signal);
+            status = tail_client_changes(tail_from_seq);
+        }
+        close_db();
+        return status;
+    }
 
     init_ncurses();
 
-    if (!init_db(db_path)) {
+    if (!open_db_shards()) {
         napms(2000);
         cleanup_ncurses();
         fprintf(stderr, "Failed to initialize database '%s'. Exiting.\n", db_path);
@@ -1916,10 +7062,17 @@ int main(int argc, char *argv[]) {
         return 1;
     }
 
+    if (output_profile.dump_path[0] && !enable_output_profiling()) {
+        show_error("Output profiling needs %s (Linux); --profile-output ignored.", THREAD_IO_STATS_PATH); napms(1500);
+    }
+
+    start_idle_maintenance((int)idle_seconds);
     display_editor_main_menu();
 
+    dump_output_profile();
     close_db();
     cleanup_ncurses();
+    input_history_clear();
 
     if (exit_requested) {
         printf("GexTuX Customers Editor terminated by signal.\n");
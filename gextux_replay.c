@@ -0,0 +1,522 @@
+#define _GNU_SOURCE              // Enables forkpty, cfmakeraw and other BSD/GNU extensions.
+
+// Records keystrokes typed into the customer editor and replays scripted sessions under a pseudo-terminal,
+// reporting for every action how long the screen took to settle and how many bytes were written to it.
+//
+// Usage:
+//   gextux_replay record SCRIPT -- command [args...]
+//   gextux_replay replay SCRIPT [-c cols] [-r rows] [-s settle_ms] [-t timeout_ms] [-g count:database] [-o csv_file]
+//                 -- command [args...]
+//
+// Scripts hold one action per line; an action is sent, then output is read until the terminal has been quiet
+// for settle_ms. A line is a list of tokens: key names (Enter, Esc, Tab, Backspace, Space, Up, Down, Left, Right,
+// Home, End, PgUp, PgDn, Delete) and double-quoted strings with C escapes ("\x1b", "\n", "\""), sent together.
+// Other lines:
+//   xN tokens...   repeat the action N times (N separate measurements)
+//   label NAME     group the following actions under NAME in the report
+//   wait MS        sleep and discard output, e.g. to let a napms() message pass
+//   # ...          comment (also after tokens)
+// Recording writes the same format: each chunk read from the keyboard becomes one line, with its time since
+// the start in a trailing comment.
+
+#include <stdio.h>      // For file and console I/O.
+#include <stdlib.h>     // For malloc, qsort and strtol.
+#include <string.h>     // For string handling.
+#include <ctype.h>      // For isprint and isspace.
+#include <errno.h>      // For errno.
+#include <poll.h>       // For poll, used to wait for terminal output with a timeout.
+#include <pty.h>        // For forkpty.
+#include <signal.h>     // For SIGWINCH, SIGCHLD and kill.
+#include <termios.h>    // For raw mode on the recording terminal.
+#include <time.h>       // For clock_gettime.
+#include <unistd.h>     // For read, write and execvp.
+#include <sys/ioctl.h>  // For TIOCGWINSZ/TIOCSWINSZ.
+#include <sys/stat.h>   // For stat, used to check whether the database must be generated.
+#include <sys/wait.h>   // For waitpid.
+#include <sqlite3.h>    // For generating the benchmark database.
+
+#define MAX_ACTION_BYTES 256        // Defines the largest byte sequence a single script line may send.
+#define MAX_LABEL_LEN 64            // Defines the buffer size of an action label.
+#define MAX_COMMAND_ARGS 64         // Defines how many arguments the benchmarked command line may have.
+#define DEFAULT_COLS 120            // Defines the default pseudo-terminal width.
+#define DEFAULT_ROWS 40             // Defines the default pseudo-terminal height.
+#define DEFAULT_SETTLE_MS 50        // Defines how long the output must stay quiet for the screen to count as settled.
+#define DEFAULT_TIMEOUT_MS 5000     // Defines how long an action may take before it is reported as timed out.
+#define STARTUP_SETTLE_MS 300       // Defines the quiet period that marks the end of program startup.
+#define READ_CHUNK 65536            // Defines the buffer size for reading terminal output.
+
+typedef struct { // Defines the measurement of one replayed action.
+    char label[MAX_LABEL_LEN];      // Label in effect when the action ran.
+    int line;                       // Script line the action came from.
+    double latency_ms;              // Time from sending the keys to the last output byte before the screen settled.
+    long bytes;                     // Bytes written to the terminal in response.
+    int timed_out;                  // Non-zero if the output did not settle within the timeout.
+} ActionResult;
+
+typedef struct { // Defines a named key and the bytes an xterm sends for it in keypad (application) mode.
+    const char *name;
+    const char *bytes;
+} KeyName;
+
+static const KeyName key_names[] = {
+    { "Enter", "\r" }, { "Esc", "\x1b" }, { "Tab", "\t" }, { "Backspace", "\x7f" }, { "Space", " " },
+    { "Up", "\x1bOA" }, { "Down", "\x1bOB" }, { "Right", "\x1bOC" }, { "Left", "\x1bOD" },
+    { "Home", "\x1bOH" }, { "End", "\x1bOF" }, { "PgUp", "\x1b[5~" }, { "PgDn", "\x1b[6~" }, { "Delete", "\x1b[3~" },
+};
+
+static volatile sig_atomic_t window_changed = 0;
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static void handle_winch(int sig) {
+    (void)sig;
+    window_changed = 1;
+}
+
+static int write_all(int fd, const char *buf, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, buf, len);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return 0;
+        }
+        buf += n;
+        len -= (size_t)n;
+    }
+    return 1;
+}
+
+// --- Recording ---
+static void write_recorded_chunk(FILE *out, const char *buf, size_t len, double t_ms) {
+    for (size_t i = 0; i < sizeof(key_names) / sizeof(key_names[0]); ++i) {
+        if (strlen(key_names[i].bytes) == len && memcmp(key_names[i].bytes, buf, len) == 0) {
+            fprintf(out, "%-24s # t=%.0f\n", key_names[i].name, t_ms);
+            return;
+        }
+    }
+    char token[MAX_ACTION_BYTES * 4 + 3];
+    int pos = 0;
+    token[pos++] = '"';
+    for (size_t i = 0; i < len && pos < (int)sizeof(token) - 6; ++i) {
+        unsigned char c = (unsigned char)buf[i];
+        if (c == '"' || c == '\\') pos += sprintf(token + pos, "\\%c", c);
+        else if (isprint(c)) token[pos++] = (char)c;
+        else pos += sprintf(token + pos, "\\x%02x", c);
+    }
+    token[pos++] = '"';
+    token[pos] = '\0';
+    fprintf(out, "%-24s # t=%.0f\n", token, t_ms);
+}
+
+static int record_session(const char *script_path, char **command) {
+    FILE *out = fopen(script_path, "w");
+    if (!out) {
+        fprintf(stderr, "Cannot create '%s': %s\n", script_path, strerror(errno));
+        return 1;
+    }
+    struct winsize ws = { .ws_row = DEFAULT_ROWS, .ws_col = DEFAULT_COLS };
+    ioctl(STDIN_FILENO, TIOCGWINSZ, &ws);
+    fprintf(out, "# Recorded from: %s (%dx%d)\n", command[0], ws.ws_col, ws.ws_row);
+
+    struct termios saved, raw;
+    int have_tty = tcgetattr(STDIN_FILENO, &saved) == 0;
+    int master;
+    pid_t pid = forkpty(&master, NULL, have_tty ? &saved : NULL, &ws);
+    if (pid < 0) {
+        fprintf(stderr, "forkpty failed: %s\n", strerror(errno));
+        fclose(out);
+        return 1;
+    }
+    if (pid == 0) {
+        execvp(command[0], command);
+        fprintf(stderr, "Cannot run '%s': %s\n", command[0], strerror(errno));
+        _exit(127);
+    }
+    if (have_tty) {
+        raw = saved;
+        cfmakeraw(&raw);
+        tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+    }
+    signal(SIGWINCH, handle_winch);
+
+    double start = now_ms();
+    char buf[READ_CHUNK];
+    struct pollfd fds[2] = { { .fd = STDIN_FILENO, .events = POLLIN }, { .fd = master, .events = POLLIN } };
+    while (1) {
+        if (window_changed) {
+            window_changed = 0;
+            if (ioctl(STDIN_FILENO, TIOCGWINSZ, &ws) == 0) ioctl(master, TIOCSWINSZ, &ws);
+        }
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[0].revents & POLLIN) {
+            ssize_t n = read(STDIN_FILENO, buf, MAX_ACTION_BYTES);
+            if (n <= 0) break;
+            write_recorded_chunk(out, buf, (size_t)n, now_ms() - start);
+            if (!write_all(master, buf, (size_t)n)) break;
+        }
+        if (fds[1].revents & (POLLIN | POLLHUP | POLLERR)) {
+            ssize_t n = read(master, buf, sizeof(buf));
+            if (n <= 0) break; // The program exited and closed the terminal.
+            write_all(STDOUT_FILENO, buf, (size_t)n);
+        }
+    }
+
+    if (have_tty) tcsetattr(STDIN_FILENO, TCSANOW, &saved);
+    close(master);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    fclose(out);
+    fprintf(stderr, "Recorded session written to '%s'.\n", script_path);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+}
+
+// --- Replay ---
+
+// Reads output until it has been quiet for settle_ms (or timeout_ms passed); returns bytes read and the time
+// of the last byte, or -1 once the program has exited.
+static long drain_output(int master, double settle_ms, double timeout_ms, double *last_output_at, int *timed_out) {
+    char buf[READ_CHUNK];
+    long total = 0;
+    double start = now_ms();
+    *last_output_at = -1;
+    *timed_out = 0;
+    while (1) {
+        double now = now_ms();
+        double wait = start + timeout_ms - now;
+        if (wait <= 0) { *timed_out = 1; break; } // Never settled, or no response at all.
+        if (*last_output_at >= 0 && *last_output_at + settle_ms - now < wait) wait = *last_output_at + settle_ms - now;
+        if (wait <= 0) break;
+
+        struct pollfd pfd = { .fd = master, .events = POLLIN };
+        int ready = poll(&pfd, 1, (int)(wait + 0.999));
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (ready == 0) continue; // Re-evaluated above: settled or timed out.
+        ssize_t n = read(master, buf, sizeof(buf));
+        if (n <= 0) return total > 0 ? total : -1;
+        total += n;
+        *last_output_at = now_ms();
+    }
+    return total;
+}
+
+static int parse_action(const char *line, char *out, size_t *out_len) {
+    size_t len = 0;
+    const char *p = line;
+    while (*p) {
+        while (isspace((unsigned char)*p)) p++;
+        if (!*p || *p == '#') break;
+        if (*p == '"') {
+            for (p++; *p && *p != '"'; p++) {
+                char c = *p;
+                if (c == '\\' && p[1]) {
+                    p++;
+                    switch (*p) {
+                        case 'n': c = '\n'; break;
+                        case 'r': c = '\r'; break;
+                        case 't': c = '\t'; break;
+                        case 'e': c = '\x1b'; break;
+                        case 'x': {
+                            char hex[3] = { p[1], p[1] ? p[2] : '\0', '\0' };
+                            c = (char)strtol(hex, NULL, 16);
+                            p += hex[1] ? 2 : 1;
+                            break;
+                        }
+                        default: c = *p; break;
+                    }
+                }
+                if (len >= MAX_ACTION_BYTES) return 0;
+                out[len++] = c;
+            }
+            if (*p != '"') return 0;
+            p++;
+        } else {
+            const char *end = p;
+            while (*end && !isspace((unsigned char)*end) && *end != '#') end++;
+            size_t name_len = (size_t)(end - p);
+            const char *bytes = NULL;
+            for (size_t i = 0; i < sizeof(key_names) / sizeof(key_names[0]); ++i) {
+                if (strlen(key_names[i].name) == name_len && strncasecmp(key_names[i].name, p, name_len) == 0) bytes = key_names[i].bytes;
+            }
+            if (!bytes) return 0;
+            size_t n = strlen(bytes);
+            if (len + n > MAX_ACTION_BYTES) return 0;
+            memcpy(out + len, bytes, n);
+            len += n;
+            p = end;
+        }
+    }
+    *out_len = len;
+    return 1;
+}
+
+// Adds the given names to a lookup table (cities, countries or industries), skipping ones already there.
+static int fill_lookup_table(sqlite3 *db, const char *table, const char *const *names, int count) {
+    char sql[96];
+    snprintf(sql, sizeof(sql), "INSERT OR IGNORE INTO %s (name) VALUES (?1);", table);
+    sqlite3_stmt *stmt = NULL;
+    int ok = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) == SQLITE_OK;
+    for (int i = 0; ok && i < count; ++i) {
+        sqlite3_bind_text(stmt, 1, names[i], -1, SQLITE_STATIC);
+        ok = sqlite3_step(stmt) == SQLITE_DONE;
+        sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+    return ok;
+}
+
+// Creates count synthetic customers in database (only if it does not exist yet), letting the editor create
+// the schema first so the benchmark always runs against the current layout.
+// City, country and industry are stored as keys into lookup tables of their names.
+static int generate_database(const char *spec, char **command, char *db_path, size_t db_path_size) {
+    char *colon = strchr(spec, ':');
+    long count = strtol(spec, NULL, 10);
+    if (!colon || count <= 0) {
+        fprintf(stderr, "Expected -g count:database, got '%s'.\n", spec);
+        return 0;
+    }
+    snprintf(db_path, db_path_size, "%s", colon + 1);
+    struct stat st;
+    if (stat(db_path, &st) == 0) return 1;
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        freopen("/dev/null", "w", stdout);
+        freopen("/dev/null", "w", stderr);
+        execlp(command[0], command[0], "-d", db_path, "--compact-changes", "0", (char*)NULL);
+        _exit(127);
+    }
+    int status = 0;
+    if (pid < 0 || waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        fprintf(stderr, "Could not create the schema with: %s -d %s --compact-changes 0\n", command[0], db_path);
+        return 0;
+    }
+
+    static const char *words[] = { "Acme", "Nova", "Luna", "Sol", "Terra", "Vega", "Orion", "Atlas", "Iris", "Zephyr",
+                                   "Delta", "Polar", "Quanta", "Echo", "Falcon", "Granite", "Harbor", "Juniper" };
+    static const char *cities[] = { "Madrid", "Berlin", "Paris", "Lisboa", "Roma", "Wien", "Köln", "Córdoba", "Zürich", "Praha" };
+    static const char *countries[] = { "Spain", "Germany", "France", "Portugal", "Italy", "Austria", "Germany", "Spain", "Switzerland", "Czechia" };
+    static const char *statuses[] = { "Active", "Inactive", "Prospect", "Lead", "Former" };
+    const int n_words = sizeof(words) / sizeof(words[0]);
+
+    sqlite3 *db = NULL;
+    sqlite3_stmt *stmt = NULL;
+    int ok = sqlite3_open(db_path, &db) == SQLITE_OK &&
+             sqlite3_exec(db, "BEGIN;", NULL, NULL, NULL) == SQLITE_OK &&
+             fill_lookup_table(db, "cities", cities, 10) && fill_lookup_table(db, "countries", countries, 10) &&
+             fill_lookup_table(db, "industries", words, n_words) &&
+             sqlite3_prepare_v2(db, "INSERT INTO clients (business_name, email, phone, street, city_id, zip_code, country_id, "
+                                    "num_employees, industry_id, contact_person, status) VALUES (?1, ?2, ?3, ?4, "
+                                    "(SELECT id FROM cities WHERE name = ?5), ?6, (SELECT id FROM countries WHERE name = ?7), ?8, "
+                                    "(SELECT id FROM industries WHERE name = ?9), ?10, ?11);",
+                                -1, &stmt, NULL) == SQLITE_OK;
+    unsigned int seed = 12345;
+    char name[128], email[128], phone[32], street[64], zip[16], person[64];
+    for (long i = 0; ok && i < count; ++i) {
+        seed = seed * 1103515245u + 12345u;
+        int a = (seed >> 16) % n_words, b = (seed >> 8) % n_words, city = (seed >> 4) % 10;
+        snprintf(name, sizeof(name), "%s %s %ld", words[a], words[b], i);
+        snprintf(email, sizeof(email), "info%ld@%s.example", i, words[a]);
+        snprintf(phone, sizeof(phone), "+34 %07ld", i);
+        snprintf(street, sizeof(street), "%s Street %ld", words[b], i % 500);
+        snprintf(zip, sizeof(zip), "%05ld", 10000 + i % 90000);
+        snprintf(person, sizeof(person), "%s Person %ld", words[(a + b) % n_words], i);
+        sqlite3_bind_text(stmt, 1, name, -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 2, email, -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 3, phone, -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 4, street, -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 5, cities[city], -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 6, zip, -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 7, countries[city], -1, SQLITE_STATIC);
+        sqlite3_bind_int(stmt, 8, (int)(seed % 5000));
+        sqlite3_bind_text(stmt, 9, words[b], -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 10, person, -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 11, statuses[seed % 5], -1, SQLITE_STATIC);
+        ok = sqlite3_step(stmt) == SQLITE_DONE;
+        sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+    if (ok) ok = sqlite3_exec(db, "COMMIT;", NULL, NULL, NULL) == SQLITE_OK;
+    if (!ok) fprintf(stderr, "Generating '%s' failed: %s\n", db_path, sqlite3_errmsg(db));
+    sqlite3_close(db);
+    if (!ok) remove(db_path);
+    return ok;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static void print_summary_row(const char *label, ActionResult *results, int n, double *scratch) {
+    int count = 0, timeouts = 0;
+    long bytes = 0;
+    for (int i = 0; i < n; ++i) {
+        if (strcmp(results[i].label, label) != 0) continue;
+        scratch[count++] = results[i].latency_ms;
+        bytes += results[i].bytes;
+        timeouts += results[i].timed_out;
+    }
+    if (count == 0) return;
+    qsort(scratch, count, sizeof(double), compare_double);
+    printf("%-20s %7d %8.2f %8.2f %8.2f %11ld %12ld %8d\n", label, count, scratch[count / 2],
+           scratch[(int)(count * 0.95) < count ? (int)(count * 0.95) : count - 1], scratch[count - 1],
+           bytes / count, bytes, timeouts);
+}
+
+static int replay_session(const char *script_path, char **command, struct winsize ws, double settle_ms,
+                          double timeout_ms, const char *csv_path) {
+    FILE *script = fopen(script_path, "r");
+    if (!script) {
+        fprintf(stderr, "Cannot open script '%s': %s\n", script_path, strerror(errno));
+        return 1;
+    }
+
+    int master;
+    pid_t pid = forkpty(&master, NULL, NULL, &ws);
+    if (pid < 0) {
+        fprintf(stderr, "forkpty failed: %s\n", strerror(errno));
+        fclose(script);
+        return 1;
+    }
+    if (pid == 0) {
+        setenv("TERM", "xterm-256color", 1);
+        execvp(command[0], command);
+        fprintf(stderr, "Cannot run '%s': %s\n", command[0], strerror(errno));
+        _exit(127);
+    }
+
+    double last_output_at;
+    int timed_out;
+    double started = now_ms();
+    long startup_bytes = drain_output(master, STARTUP_SETTLE_MS, timeout_ms, &last_output_at, &timed_out);
+    printf("Startup: %.2f ms, %ld bytes\n", last_output_at >= 0 ? last_output_at - started : 0.0, startup_bytes);
+
+    int capacity = 256, n_results = 0, line_no = 0, exited = 0;
+    ActionResult *results = malloc(capacity * sizeof(ActionResult));
+    char label[MAX_LABEL_LEN] = "default";
+    char line[4096], action[MAX_ACTION_BYTES];
+    while (results && !exited && fgets(line, sizeof(line), script)) {
+        line_no++;
+        char *p = line;
+        while (isspace((unsigned char)*p)) p++;
+        if (!*p || *p == '#') continue;
+        if (strncmp(p, "label ", 6) == 0) {
+            snprintf(label, sizeof(label), "%s", p + 6);
+            label[strcspn(label, " \t\r\n#")] = '\0';
+            continue;
+        }
+        if (strncmp(p, "wait ", 5) == 0) {
+            double wait_ms = strtod(p + 5, NULL);
+            if (drain_output(master, wait_ms, wait_ms, &last_output_at, &timed_out) < 0) exited = 1;
+            continue;
+        }
+        long repeat = 1;
+        if (*p == 'x' && isdigit((unsigned char)p[1])) repeat = strtol(p + 1, &p, 10);
+
+        size_t action_len;
+        if (!parse_action(p, action, &action_len)) {
+            fprintf(stderr, "%s:%d: cannot parse '%s'\n", script_path, line_no, p);
+            break;
+        }
+        for (long r = 0; r < repeat && !exited; ++r) {
+            if (n_results == capacity) {
+                ActionResult *grown = realloc(results, 2 * capacity * sizeof(ActionResult));
+                if (!grown) { exited = 1; break; }
+                results = grown;
+                capacity *= 2;
+            }
+            ActionResult *res = &results[n_results++];
+            snprintf(res->label, sizeof(res->label), "%s", label);
+            res->line = line_no;
+            double sent_at = now_ms();
+            if (!write_all(master, action, action_len)) { exited = 1; break; }
+            res->bytes = drain_output(master, settle_ms, timeout_ms, &last_output_at, &res->timed_out);
+            if (res->bytes < 0) { res->bytes = 0; exited = 1; }
+            res->latency_ms = last_output_at >= 0 ? last_output_at - sent_at : 0.0;
+        }
+    }
+    fclose(script);
+
+    kill(pid, SIGTERM);
+    int status;
+    waitpid(pid, &status, 0);
+    close(master);
+    if (!results) return 1;
+
+    printf("%-20s %7s %8s %8s %8s %11s %12s %8s\n", "label", "actions", "p50_ms", "p95_ms", "max_ms", "bytes/action", "total_bytes", "timeouts");
+    double *scratch = malloc((n_results + 1) * sizeof(double));
+    for (int i = 0; scratch && i < n_results; ++i) {
+        int seen = 0;
+        for (int j = 0; j < i && !seen; ++j) seen = strcmp(results[j].label, results[i].label) == 0;
+        if (!seen) print_summary_row(results[i].label, results, n_results, scratch);
+    }
+    free(scratch);
+
+    if (csv_path) {
+        FILE *csv = fopen(csv_path, "w");
+        if (csv) {
+            fprintf(csv, "index,label,line,latency_ms,bytes,timed_out\n");
+            for (int i = 0; i < n_results; ++i) {
+                fprintf(csv, "%d,%s,%d,%.3f,%ld,%d\n", i, results[i].label, results[i].line, results[i].latency_ms,
+                        results[i].bytes, results[i].timed_out);
+            }
+            fclose(csv);
+        } else {
+            fprintf(stderr, "Cannot create '%s': %s\n", csv_path, strerror(errno));
+        }
+    }
+    free(results);
+    return 0;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s record SCRIPT -- command [args...]\n", prog);
+    fprintf(stderr, "       %s replay SCRIPT [-c cols] [-r rows] [-s settle_ms] [-t timeout_ms] [-g count:database] [-o csv_file] -- command [args...]\n", prog);
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 5) { usage(argv[0]); return 1; }
+    const char *mode = argv[1], *script = argv[2];
+    struct winsize ws = { .ws_row = DEFAULT_ROWS, .ws_col = DEFAULT_COLS };
+    double settle_ms = DEFAULT_SETTLE_MS, timeout_ms = DEFAULT_TIMEOUT_MS;
+    const char *csv_path = NULL, *generate = NULL;
+
+    int i = 3;
+    for (; i < argc && strcmp(argv[i], "--") != 0; i += 2) {
+        if (i + 1 >= argc) { usage(argv[0]); return 1; }
+        if (strcmp(argv[i], "-c") == 0) ws.ws_col = (unsigned short)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-r") == 0) ws.ws_row = (unsigned short)atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-s") == 0) settle_ms = atof(argv[i + 1]);
+        else if (strcmp(argv[i], "-t") == 0) timeout_ms = atof(argv[i + 1]);
+        else if (strcmp(argv[i], "-g") == 0) generate = argv[i + 1];
+        else if (strcmp(argv[i], "-o") == 0) csv_path = argv[i + 1];
+        else { usage(argv[0]); return 1; }
+    }
+    if (i + 1 >= argc || argc - i > MAX_COMMAND_ARGS) { usage(argv[0]); return 1; }
+
+    char *command[MAX_COMMAND_ARGS + 3];
+    int n = 0;
+    for (int k = i + 1; k < argc; ++k) command[n++] = argv[k];
+    char db_path[1024];
+    if (generate) {
+        if (!generate_database(generate, command, db_path, sizeof(db_path))) return 1;
+        command[n++] = "-d";
+        command[n++] = db_path;
+    }
+    command[n] = NULL;
+
+    if (strcmp(mode, "record") == 0) return record_session(script, command);
+    if (strcmp(mode, "replay") == 0) return replay_session(script, command, ws, settle_ms, timeout_ms, csv_path);
+    usage(argv[0]);
+    return 1;
+}
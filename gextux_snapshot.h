@@ -0,0 +1,187 @@
+#ifndef GEXTUX_SNAPSHOT_H
+#define GEXTUX_SNAPSHOT_H
+
+// Columnar customer snapshot written by "gextux_customer_management --export-snapshot" and a header-only,
+// zero-copy reader for it. The file is mapped read-only and every accessor returns pointers into the mapping.
+//
+// Layout (byte order of the writing host, checked through byte_order_mark; every section starts 8-byte aligned):
+//   GxsHeader | GxsColumn[column_count] | column sections...
+//   GXS_TYPE_INT64 / GXS_TYPE_INT32: data holds one value per row.
+//   GXS_TYPE_DICT:   data holds a uint32 code per row; aux holds uint64 offsets[dict_count + 1] followed by the
+//                    entries' UTF-8 bytes (entry i spans offsets[i]..offsets[i + 1] of those bytes).
+//   GXS_TYPE_STRING: data holds uint64 offsets[row_count + 1]; aux holds the UTF-8 bytes they index.
+// Strings are not NUL-terminated and NULL is stored as the empty string. Rows are in ascending id order.
+
+#include <stdint.h>     // For the fixed-width types used in the file format.
+#include <stddef.h>     // For size_t.
+#include <string.h>     // For memcmp and strncmp.
+#include <fcntl.h>      // For open.
+#include <unistd.h>     // For close.
+#include <sys/mman.h>   // For mmap and munmap.
+#include <sys/stat.h>   // For fstat.
+
+#define GXS_MAGIC "GXSNAP\r\n"                   // Defines the 8-byte file signature.
+#define GXS_VERSION 1                            // Defines the format version written and accepted.
+#define GXS_BYTE_ORDER_MARK 0x0102030405060708ULL // Defines the value that reads back unchanged only in the writer's byte order.
+#define GXS_COLUMN_NAME_LEN 24                   // Defines the size of a column name, NUL padded.
+
+enum { // Defines the column encodings.
+    GXS_TYPE_INT64 = 1,
+    GXS_TYPE_INT32 = 2,
+    GXS_TYPE_DICT = 3,
+    GXS_TYPE_STRING = 4
+};
+
+typedef struct { // Defines the 64-byte file header.
+    char magic[8];                  // GXS_MAGIC.
+    uint32_t version;               // GXS_VERSION.
+    uint32_t column_count;          // Number of GxsColumn entries following the header.
+    uint64_t byte_order_mark;       // GXS_BYTE_ORDER_MARK as written by the exporter.
+    uint64_t row_count;             // Number of customers.
+    int64_t created_at;             // Unix time of the export.
+    uint64_t file_size;             // Total size of the file in bytes.
+    uint8_t reserved[16];           // Zero.
+} GxsHeader;
+
+typedef struct { // Defines a 64-byte column directory entry.
+    char name[GXS_COLUMN_NAME_LEN]; // Column name as in the clients table.
+    uint32_t type;                  // One of the GXS_TYPE_* encodings.
+    uint32_t dict_count;            // Number of dictionary entries (GXS_TYPE_DICT only).
+    uint64_t data_offset;           // File offset of the per-row section.
+    uint64_t data_size;             // Size of the per-row section in bytes.
+    uint64_t aux_offset;            // File offset of the string bytes or dictionary (0 when unused).
+    uint64_t aux_size;              // Size of the aux section in bytes.
+} GxsColumn;
+
+typedef struct { // Defines an open, mapped snapshot.
+    const uint8_t *base;            // Start of the mapping.
+    size_t size;                    // Size of the mapping.
+    const GxsHeader *header;        // The file header.
+    const GxsColumn *columns;       // The column directory.
+} GxsSnapshot;
+
+static inline int gxs_offsets_valid(const uint64_t *offsets, uint64_t count, uint64_t limit) {
+    if (offsets[0] != 0) return 0;
+    for (uint64_t i = 0; i < count; ++i) {
+        if (offsets[i + 1] < offsets[i]) return 0;
+    }
+    return offsets[count] <= limit;
+}
+
+static inline int gxs_range_valid(const GxsSnapshot *snap, uint64_t offset, uint64_t size) {
+    return offset % 8 == 0 && offset <= snap->size && size <= snap->size - offset;
+}
+
+// Validates the whole file up front, so the accessors below can index it without bounds checks.
+static inline int gxs_validate(const GxsSnapshot *snap) {
+    const GxsHeader *h = snap->header;
+    if (snap->size < sizeof(GxsHeader) || memcmp(h->magic, GXS_MAGIC, 8) != 0) return 0;
+    if (h->version != GXS_VERSION || h->byte_order_mark != GXS_BYTE_ORDER_MARK || h->file_size != snap->size) return 0;
+    if (h->column_count > (snap->size - sizeof(GxsHeader)) / sizeof(GxsColumn)) return 0;
+
+    uint64_t rows = h->row_count;
+    // Every snapshot has an 8-byte id per row, so a larger count is corrupt; it would also wrap the sizes below.
+    if (rows > snap->size / 8) return 0;
+    for (uint32_t i = 0; i < h->column_count; ++i) {
+        const GxsColumn *c = &snap->columns[i];
+        if (memchr(c->name, '\0', GXS_COLUMN_NAME_LEN) == NULL) return 0;
+        if (!gxs_range_valid(snap, c->data_offset, c->data_size) || !gxs_range_valid(snap, c->aux_offset, c->aux_size)) return 0;
+        const uint8_t *data = snap->base + c->data_offset;
+        switch (c->type) {
+            case GXS_TYPE_INT64: if (c->data_size != rows * 8) return 0; break;
+            case GXS_TYPE_INT32: if (c->data_size != rows * 4) return 0; break;
+            case GXS_TYPE_DICT: {
+                uint64_t table_size = ((uint64_t)c->dict_count + 1) * 8;
+                if (c->data_size != rows * 4 || c->aux_size < table_size) return 0;
+                if (!gxs_offsets_valid((const uint64_t*)(snap->base + c->aux_offset), c->dict_count, c->aux_size - table_size)) return 0;
+                const uint32_t *codes = (const uint32_t*)data;
+                for (uint64_t r = 0; r < rows; ++r) {
+                    if (codes[r] >= c->dict_count) return 0;
+                }
+                break;
+            }
+            case GXS_TYPE_STRING:
+                if (c->data_size != (rows + 1) * 8) return 0;
+                if (!gxs_offsets_valid((const uint64_t*)data, rows, c->aux_size)) return 0;
+                break;
+            default: return 0;
+        }
+    }
+    return 1;
+}
+
+// Returns 1 on success; on failure the snapshot is left closed and errno tells why when a system call failed.
+static inline int gxs_open(const char *path, GxsSnapshot *snap) {
+    memset(snap, 0, sizeof(*snap));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(GxsHeader)) { close(fd); return 0; }
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return 0;
+
+    snap->base = (const uint8_t*)map;
+    snap->size = (size_t)st.st_size;
+    snap->header = (const GxsHeader*)map;
+    snap->columns = (const GxsColumn*)(snap->base + sizeof(GxsHeader));
+    if (!gxs_validate(snap)) {
+        munmap(map, snap->size);
+        memset(snap, 0, sizeof(*snap));
+        return 0;
+    }
+    return 1;
+}
+
+static inline void gxs_close(GxsSnapshot *snap) {
+    if (snap->base) munmap((void*)snap->base, snap->size);
+    memset(snap, 0, sizeof(*snap));
+}
+
+static inline uint64_t gxs_row_count(const GxsSnapshot *snap) {
+    return snap->header->row_count;
+}
+
+static inline const GxsColumn *gxs_find_column(const GxsSnapshot *snap, const char *name) {
+    for (uint32_t i = 0; i < snap->header->column_count; ++i) {
+        if (strncmp(snap->columns[i].name, name, GXS_COLUMN_NAME_LEN) == 0) return &snap->columns[i];
+    }
+    return NULL;
+}
+
+static inline const int64_t *gxs_int64_values(const GxsSnapshot *snap, const GxsColumn *col) {
+    return col && col->type == GXS_TYPE_INT64 ? (const int64_t*)(snap->base + col->data_offset) : NULL;
+}
+
+static inline const int32_t *gxs_int32_values(const GxsSnapshot *snap, const GxsColumn *col) {
+    return col && col->type == GXS_TYPE_INT32 ? (const int32_t*)(snap->base + col->data_offset) : NULL;
+}
+
+static inline const uint32_t *gxs_dict_codes(const GxsSnapshot *snap, const GxsColumn *col) {
+    return col && col->type == GXS_TYPE_DICT ? (const uint32_t*)(snap->base + col->data_offset) : NULL;
+}
+
+static inline const char *gxs_dict_entry(const GxsSnapshot *snap, const GxsColumn *col, uint32_t code, size_t *len) {
+    const uint64_t *offsets = (const uint64_t*)(snap->base + col->aux_offset);
+    const char *bytes = (const char*)(offsets + col->dict_count + 1);
+    *len = (size_t)(offsets[code + 1] - offsets[code]);
+    return bytes + offsets[code];
+}
+
+// Returns the code of a dictionary entry, or UINT32_MAX when no row has that value.
+static inline uint32_t gxs_dict_lookup(const GxsSnapshot *snap, const GxsColumn *col, const char *value) {
+    size_t value_len = strlen(value), len;
+    for (uint32_t code = 0; code < col->dict_count; ++code) {
+        const char *entry = gxs_dict_entry(snap, col, code, &len);
+        if (len == value_len && memcmp(entry, value, len) == 0) return code;
+    }
+    return UINT32_MAX;
+}
+
+static inline const char *gxs_string(const GxsSnapshot *snap, const GxsColumn *col, uint64_t row, size_t *len) {
+    const uint64_t *offsets = (const uint64_t*)(snap->base + col->data_offset);
+    *len = (size_t)(offsets[row + 1] - offsets[row]);
+    return (const char*)(snap->base + col->aux_offset + offsets[row]);
+}
+
+#endif // GEXTUX_SNAPSHOT_H
@@ -0,0 +1,132 @@
+// Compares scan times over a columnar snapshot (gextux_snapshot.h) with the same queries run through SQLite.
+//
+// Usage: gextux_snapshot_bench database_file snapshot_file [iterations] [city]
+// Create the snapshot first with: gextux_customer_management -d database_file --export-snapshot snapshot_file
+
+#include <stdio.h>    // For printf and fprintf.
+#include <stdlib.h>   // For atoi.
+#include <string.h>   // For memcmp and strlen.
+#include <time.h>     // For clock_gettime.
+#include <sqlite3.h>  // For running the reference queries.
+#include "gextux_snapshot.h" // For the snapshot reader.
+
+#define DEFAULT_ITERATIONS 20      // Defines how often each query runs when not given on the command line.
+#define DEFAULT_CITY "Madrid"      // Defines the city counted by the filter query when not given.
+#define NAME_NEEDLE "a"            // Defines the substring counted by the string scan query.
+
+typedef struct { // Defines the results of one round of queries, compared between both engines.
+    long long employees_sum;       // Sum of num_employees.
+    long long city_count;          // Customers in the chosen city.
+    long long active_count;        // Customers with status 'Active'.
+    long long name_matches;        // Business names containing NAME_NEEDLE (case-sensitive).
+} BenchResult;
+
+static double now_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static long long sqlite_scalar(sqlite3 *db, const char *sql, const char *param) {
+    sqlite3_stmt *stmt = NULL;
+    long long value = -1;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, NULL) == SQLITE_OK) {
+        if (param) sqlite3_bind_text(stmt, 1, param, -1, SQLITE_STATIC);
+        if (sqlite3_step(stmt) == SQLITE_ROW) value = sqlite3_column_int64(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    return value;
+}
+
+static BenchResult run_sqlite(sqlite3 *db, const char *city) {
+    BenchResult r;
+    r.employees_sum = sqlite_scalar(db, "SELECT total(num_employees) FROM clients;", NULL);
+    r.city_count = sqlite_scalar(db, "SELECT count(*) FROM clients WHERE city_id = (SELECT id FROM cities WHERE name = ?1);", city);
+    r.active_count = sqlite_scalar(db, "SELECT count(*) FROM clients WHERE status = 'Active';", NULL);
+    r.name_matches = sqlite_scalar(db, "SELECT count(*) FROM clients WHERE instr(business_name, '" NAME_NEEDLE "') > 0;", NULL);
+    return r;
+}
+
+static BenchResult run_snapshot(const GxsSnapshot *snap, const char *city) {
+    BenchResult r = {0, 0, 0, 0};
+    uint64_t rows = gxs_row_count(snap);
+
+    const int32_t *employees = gxs_int32_values(snap, gxs_find_column(snap, "num_employees"));
+    for (uint64_t i = 0; i < rows; ++i) r.employees_sum += employees[i];
+
+    // Filters on dictionary columns compare integer codes instead of strings.
+    const GxsColumn *city_col = gxs_find_column(snap, "city");
+    uint32_t city_code = gxs_dict_lookup(snap, city_col, city);
+    const uint32_t *city_codes = gxs_dict_codes(snap, city_col);
+    for (uint64_t i = 0; i < rows; ++i) r.city_count += city_codes[i] == city_code;
+
+    const GxsColumn *status_col = gxs_find_column(snap, "status");
+    uint32_t active_code = gxs_dict_lookup(snap, status_col, "Active");
+    const uint32_t *status_codes = gxs_dict_codes(snap, status_col);
+    for (uint64_t i = 0; i < rows; ++i) r.active_count += status_codes[i] == active_code;
+
+    const GxsColumn *name_col = gxs_find_column(snap, "business_name");
+    size_t needle_len = strlen(NAME_NEEDLE);
+    for (uint64_t i = 0; i < rows; ++i) {
+        size_t len;
+        const char *name = gxs_string(snap, name_col, i, &len);
+        for (size_t k = 0; k + needle_len <= len; ++k) {
+            if (memcmp(name + k, NAME_NEEDLE, needle_len) == 0) { r.name_matches++; break; }
+        }
+    }
+    return r;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s database_file snapshot_file [iterations] [city]\n", argv[0]);
+        return 1;
+    }
+    int iterations = argc > 3 ? atoi(argv[3]) : DEFAULT_ITERATIONS;
+    const char *city = argc > 4 ? argv[4] : DEFAULT_CITY;
+    if (iterations < 1) iterations = 1;
+
+    sqlite3 *db = NULL;
+    if (sqlite3_open_v2(argv[1], &db, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK) {
+        fprintf(stderr, "Cannot open database '%s': %s\n", argv[1], sqlite3_errmsg(db));
+        sqlite3_close(db);
+        return 1;
+    }
+    GxsSnapshot snap;
+    if (!gxs_open(argv[2], &snap)) {
+        fprintf(stderr, "Cannot open snapshot '%s' (missing, truncated or of another version).\n", argv[2]);
+        sqlite3_close(db);
+        return 1;
+    }
+    const char *required[] = { "num_employees", "city", "status", "business_name" };
+    for (size_t i = 0; i < sizeof(required) / sizeof(required[0]); ++i) {
+        if (!gxs_find_column(&snap, required[i])) {
+            fprintf(stderr, "Snapshot has no '%s' column.\n", required[i]);
+            gxs_close(&snap);
+            sqlite3_close(db);
+            return 1;
+        }
+    }
+
+    BenchResult sqlite_result = run_sqlite(db, city), snapshot_result = run_snapshot(&snap, city); // Warm-up.
+    double start = now_ms();
+    for (int i = 0; i < iterations; ++i) sqlite_result = run_sqlite(db, city);
+    double sqlite_ms = (now_ms() - start) / iterations;
+    start = now_ms();
+    for (int i = 0; i < iterations; ++i) snapshot_result = run_snapshot(&snap, city);
+    double snapshot_ms = (now_ms() - start) / iterations;
+
+    printf("Rows: %llu, iterations: %d, city: %s\n", (unsigned long long)gxs_row_count(&snap), iterations, city);
+    printf("%-10s %14s %10s %10s %12s %10s\n", "engine", "sum(employees)", "city", "active", "name~'" NAME_NEEDLE "'", "ms/round");
+    printf("%-10s %14lld %10lld %10lld %12lld %10.3f\n", "sqlite", sqlite_result.employees_sum, sqlite_result.city_count,
+           sqlite_result.active_count, sqlite_result.name_matches, sqlite_ms);
+    printf("%-10s %14lld %10lld %10lld %12lld %10.3f\n", "snapshot", snapshot_result.employees_sum, snapshot_result.city_count,
+           snapshot_result.active_count, snapshot_result.name_matches, snapshot_ms);
+    if (snapshot_ms > 0) printf("Speedup: %.1fx\n", sqlite_ms / snapshot_ms);
+
+    int mismatch = memcmp(&sqlite_result, &snapshot_result, sizeof(BenchResult)) != 0;
+    if (mismatch) fprintf(stderr, "Results differ: the snapshot is older than the database or was exported from another file.\n");
+    gxs_close(&snap);
+    sqlite3_close(db);
+    return mismatch ? 2 : 0;
+}
@@ -1 +1,3 @@
-gcc -Os gextux_customer_management.c -o gextux_customer_management -lncursesw -lsqlite3
\ No newline at end of file
+gcc -Os gextux_customer_management.c -o gextux_customer_management -lncursesw -lsqlite3 -lm -pthread
+gcc -O2 gextux_snapshot_bench.c -o gextux_snapshot_bench -lsqlite3
+gcc -O2 gextux_replay.c -o gextux_replay -lutil -lsqlite3
\ No newline at end of file